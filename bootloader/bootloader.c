@@ -0,0 +1,106 @@
+/*
+** file: bootloader.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Runs after boot2, from the start of flash. Reads the boot control record
+** and starts the firmware in the active slot.
+**
+** An image which has not been confirmed yet is started under the watchdog,
+** and at most L61_BOOTCTL_MAX_ATTEMPTS times. If it does not confirm itself
+** by then, or if its CRC does not match the one recorded by the update,
+** the previous slot becomes active again.
+**
+** A confirmed boot only reads the record before jumping, so the time spent
+** here is dominated by the SDK runtime initialisation.
+*/
+
+#include "hardware/regs/addressmap.h"
+#include "hardware/regs/m0plus.h"
+#include "hardware/structs/scb.h"
+#include "hardware/watchdog.h"
+#include "lard61_bootctl.h"
+#include "lard61_crc.h"
+#include "lard61_flash.h"
+#include "pico/bootrom.h"
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static const uint32_t* slot_vectors(uint slot) {
+  return l61_flash_ptr(l61_flash_slot_offset(slot) +
+                       L61_FLASH_IMAGE_VECTORS_OFFSET);
+}
+
+// Whether the slot starts with a plausible vector table: initial stack
+// pointer in RAM, reset handler in the slot
+static bool image_plausible(uint slot) {
+  const uint32_t* vectors = slot_vectors(slot);
+  uint32_t start = XIP_BASE + l61_flash_slot_offset(slot);
+  return vectors[0] > SRAM_BASE && vectors[0] <= SRAM_END &&
+         (vectors[1] & 1) && vectors[1] >= start &&
+         vectors[1] < start + L61_FLASH_SLOT_SIZE;
+}
+
+static bool image_valid(const struct l61_bootctl* ctl, uint slot) {
+  if (!image_plausible(slot))
+    return false;
+  // Images flashed through BOOTSEL have no recorded size
+  if (ctl->image_size[slot] == 0)
+    return true;
+  uint32_t crc = l61_crc32(L61_CRC32_INIT,
+                           l61_flash_ptr(l61_flash_slot_offset(slot)),
+                           ctl->image_size[slot]);
+  return crc == ctl->image_crc[slot];
+}
+
+static void __attribute__((noreturn)) start_slot(uint slot) {
+  const uint32_t* vectors = slot_vectors(slot);
+
+  // Disable and clear all interrupts, the firmware sets up its own
+  *(volatile uint32_t*)(PPB_BASE + M0PLUS_NVIC_ICER_OFFSET) = 0xffffffff;
+  *(volatile uint32_t*)(PPB_BASE + M0PLUS_NVIC_ICPR_OFFSET) = 0xffffffff;
+
+  scb_hw->vtor = (uintptr_t)vectors;
+  __asm volatile(
+      "msr msp, %0\n"
+      "bx %1\n"
+      :
+      : "r"(vectors[0]), "r"(vectors[1]));
+  __builtin_unreachable();
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main() {
+  struct l61_bootctl ctl;
+  l61_bootctl_read(&ctl);
+
+  if (!ctl.confirmed) {
+    if (ctl.boot_attempts >= L61_BOOTCTL_MAX_ATTEMPTS ||
+        !image_valid(&ctl, ctl.active_slot)) {
+      // Roll back to the image which was running before the update
+      ctl.active_slot = ctl.previous_slot;
+      ctl.confirmed = 1;
+      ctl.boot_attempts = 0;
+      l61_bootctl_write(&ctl);
+    } else {
+      ctl.boot_attempts++;
+      l61_bootctl_write(&ctl);
+      // If the new image hangs before confirming, come back here
+      watchdog_enable(L61_BOOTCTL_TRIAL_WATCHDOG_MS, true);
+    }
+  }
+
+  uint slot = ctl.active_slot;
+  if (!image_plausible(slot))
+    slot = 1 - slot;
+  if (!image_plausible(slot)) {
+    // Nothing to start, wait for a new firmware in BOOTSEL mode
+    reset_usb_boot(0, 0);
+  }
+  start_slot(slot);
+}
@@ -0,0 +1,625 @@
+/*
+** file: l61_bench.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Benchmark of the key path, from the raw matrix to the reports the host
+** receives: the firmware's debounce, keymap, report building and
+** l61_hid_task run against a simulated clock, scan timer and USB host
+** polling the HID endpoint every frame.
+**
+** Each input is turned into timed strokes (a key pressed at some time and
+** released later), then into raw matrix edges with switch bounce:
+**
+** - `.txt` files are typed as text at -w words per minute, with random
+**   intervals and hold times, so fast typing rolls into overlapping keys.
+**   Uppercase and symbols hold the left shift around their key.
+** - `.trace` files list key events, for gaming and other recorded
+**   sessions. Each line is `<time in ms> <key> down|up`, with the key given
+**   as a character typed by it, one of the names in `key_names` or `#` and
+**   a key matrix index. Lines starting with '#' are comments.
+**
+** For every stroke, the press latency is the time from its first raw edge
+** to the first received keyboard report holding its key, and the release
+** latency the same for the release. A stroke never seen in a report is
+** dropped, and one seen after a stroke pressed later is misordered.
+** Reports per second and the host CPU time spent in each scan (debounce
+** and l61_hid_task) are measured too.
+**
+** The output is one JSON object per input, on its own line, so results can
+** be stored and compared between commits. Everything but the CPU times is
+** deterministic for a given seed.
+**
+** -e 1 debounces eagerly and -t 0 lets chords into a single report, like
+** the gaming profile (see lard61_profile.h).
+**
+** Usage: l61_bench [-r scan_rate_hz] [-w wpm] [-b bounce_us] [-s seed]
+**                  [-e eager] [-t throttle] input...
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "class/hid/hid.h"
+#include "l61_host.h"
+#include "lard61_debounce.h"
+#include "lard61_hid.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+
+#define KEY_COUNT L61_DEBOUNCE_KEY_COUNT
+// USB full speed frame, the polling interval of the HID endpoint
+#define FRAME_US 1000
+// Polls happen half a frame after scans, as the two clocks are unrelated
+#define POLL_PHASE_US 500
+// A stroke not reported by then is dropped
+#define DROP_AFTER_US 100000
+// Time between two presses of the same key, so their strokes do not merge
+#define SAME_KEY_GAP_US 15000
+
+struct stroke {
+  uint8_t key;
+  uint8_t usage;
+  uint64_t press_us;
+  uint64_t release_us;
+  bool press_seen;
+  bool release_seen;
+};
+
+struct edge {
+  uint64_t time_us;
+  uint8_t key;
+  bool state;
+};
+
+struct stats {
+  uint32_t* press_latency;
+  uint32_t* release_latency;
+  uint32_t press_count;
+  uint32_t release_count;
+  uint32_t dropped;
+  uint32_t misordered;
+  uint32_t reports;
+  uint32_t* scan_ns;
+  uint32_t scan_count;
+};
+
+static const struct {
+  const char* name;
+  uint8_t usage;
+} key_names[] = {
+    {"space", HID_KEY_SPACE},
+    {"enter", HID_KEY_ENTER},
+    {"tab", HID_KEY_TAB},
+    {"esc", HID_KEY_ESCAPE},
+    {"backspace", HID_KEY_BACKSPACE},
+    {"shift", HID_KEY_SHIFT_LEFT},
+    {"rshift", HID_KEY_SHIFT_RIGHT},
+    {"ctrl", HID_KEY_CONTROL_LEFT},
+    {"alt", HID_KEY_ALT_LEFT},
+    {"gui", HID_KEY_GUI_LEFT},
+};
+
+// Characters typed with each HID usage, without and with shift
+static const struct {
+  uint8_t usage;
+  char plain;
+  char shifted;
+} symbols[] = {
+    {HID_KEY_MINUS, '-', '_'},         {HID_KEY_EQUAL, '=', '+'},
+    {HID_KEY_BRACKET_LEFT, '[', '{'},  {HID_KEY_BRACKET_RIGHT, ']', '}'},
+    {HID_KEY_BACKSLASH, '\\', '|'},    {HID_KEY_SEMICOLON, ';', ':'},
+    {HID_KEY_APOSTROPHE, '\'', '"'},   {HID_KEY_GRAVE, '`', '~'},
+    {HID_KEY_COMMA, ',', '<'},         {HID_KEY_PERIOD, '.', '>'},
+    {HID_KEY_SLASH, '/', '?'},         {HID_KEY_SPACE, ' ', 0},
+    {HID_KEY_ENTER, '\n', 0},          {HID_KEY_TAB, '\t', 0},
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static uint32_t scan_period_us = 1000;
+static uint32_t wpm = 80;
+static uint32_t bounce_us = 1500;
+
+// Key matrix index of each HID usage on the base layer, or -1
+static int usage_key[256];
+
+static struct stroke* strokes = NULL;
+static uint32_t stroke_count = 0;
+static uint32_t stroke_capacity = 0;
+
+static struct edge* edges = NULL;
+static uint32_t edge_count = 0;
+static uint32_t edge_capacity = 0;
+
+static struct stats stats;
+static uint64_t now_us = 0;
+// Press time of the last stroke seen in a report, for misordering
+static uint64_t last_seen_press_us = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t random_below(uint32_t max) {
+  return max == 0 ? 0 : (uint32_t)rand() % max;
+}
+
+static void* grow(void* array, uint32_t* capacity, size_t size) {
+  *capacity = *capacity ? *capacity * 2 : 1024;
+  array = realloc(array, *capacity * size);
+  if (!array) {
+    fprintf(stderr, "out of memory\n");
+    exit(2);
+  }
+  return array;
+}
+
+static void map_usages() {
+  for (uint i = 0; i < 256; ++i)
+    usage_key[i] = -1;
+  const uint16_t* base = l61_keymap_get()->keycode[L61_LAYER_BASE];
+  for (int i = KEY_COUNT - 1; i >= 0; --i) {
+    if ((base[i] & L61_KC_TYPE_MASK) == L61_KC_KEYBOARD &&
+        base[i] != HID_KEY_NONE)
+      usage_key[base[i] & 0xff] = i;
+  }
+}
+
+// HID usage typing `c` on a US layout, and whether it needs shift.
+// Return false if no key types it.
+static bool char_usage(char c, uint8_t* usage, bool* shift) {
+  *shift = false;
+  if (c >= 'a' && c <= 'z') {
+    *usage = HID_KEY_A + (c - 'a');
+    return true;
+  }
+  if (c >= 'A' && c <= 'Z') {
+    *usage = HID_KEY_A + (c - 'A');
+    *shift = true;
+    return true;
+  }
+  if (c >= '1' && c <= '9') {
+    *usage = HID_KEY_1 + (c - '1');
+    return true;
+  }
+  if (c == '0') {
+    *usage = HID_KEY_0;
+    return true;
+  }
+  const char* digit_symbols = "!@#$%^&*()";
+  const char* s = strchr(digit_symbols, c);
+  if (c != '\0' && s) {
+    *usage = s == digit_symbols + 9 ? HID_KEY_0
+                                    : HID_KEY_1 + (uint8_t)(s - digit_symbols);
+    *shift = true;
+    return true;
+  }
+  for (uint i = 0; i < sizeof(symbols) / sizeof(symbols[0]); ++i) {
+    if (c == symbols[i].plain || (c != 0 && c == symbols[i].shifted)) {
+      *usage = symbols[i].usage;
+      *shift = c == symbols[i].shifted;
+      return true;
+    }
+  }
+  return false;
+}
+
+static struct stroke* add_stroke(uint8_t usage,
+                                 uint64_t press_us,
+                                 uint64_t release_us) {
+  if (usage_key[usage] < 0)
+    return NULL;
+  if (stroke_count == stroke_capacity)
+    strokes = grow(strokes, &stroke_capacity, sizeof(*strokes));
+  struct stroke* s = &strokes[stroke_count++];
+  memset(s, 0, sizeof(*s));
+  s->key = (uint8_t)usage_key[usage];
+  s->usage = usage;
+  s->press_us = press_us;
+  s->release_us = release_us;
+  return s;
+}
+
+// Last stroke of `key` before the one being added, or NULL
+static struct stroke* last_stroke(uint8_t key) {
+  for (uint32_t i = stroke_count; i > 0; --i) {
+    if (strokes[i - 1].key == key)
+      return &strokes[i - 1];
+  }
+  return NULL;
+}
+
+static bool load_text(const char* path, uint64_t start_us) {
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  // Average time between two characters, at 5 characters per word
+  uint64_t interval_us = 60000000ull / (wpm * 5);
+  uint64_t t = start_us;
+  int c;
+  while ((c = fgetc(f)) != EOF) {
+    uint8_t usage;
+    bool shift;
+    if (!char_usage((char)c, &usage, &shift) || usage_key[usage] < 0)
+      continue;
+
+    uint64_t hold_us = 60000 + random_below(80000);
+    // A repeated key has to be released first
+    struct stroke* previous = last_stroke((uint8_t)usage_key[usage]);
+    if (previous && t < previous->release_us + SAME_KEY_GAP_US)
+      t = previous->release_us + SAME_KEY_GAP_US;
+
+    if (shift) {
+      // Keep holding shift from the previous character if it still is
+      uint64_t shift_down = t - 25000;
+      uint64_t shift_up = t + hold_us + 15000;
+      struct stroke* held =
+          last_stroke((uint8_t)usage_key[HID_KEY_SHIFT_LEFT]);
+      if (held && held->release_us + SAME_KEY_GAP_US > shift_down)
+        held->release_us = shift_up;
+      else
+        add_stroke(HID_KEY_SHIFT_LEFT, shift_down, shift_up);
+    }
+    add_stroke(usage, t, t + hold_us);
+    t += interval_us / 2 + random_below((uint32_t)interval_us);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool trace_usage(const char* name, uint8_t* usage) {
+  if (name[0] == '#' && name[1] != '\0') {
+    int key = atoi(name + 1);
+    if (key < 0 || key >= KEY_COUNT)
+      return false;
+    // Strokes are tracked by usage, find the one of that key
+    for (uint u = 0; u < 256; ++u) {
+      if (usage_key[u] == key) {
+        *usage = (uint8_t)u;
+        return true;
+      }
+    }
+    return false;
+  }
+  for (uint i = 0; i < sizeof(key_names) / sizeof(key_names[0]); ++i) {
+    if (strcmp(name, key_names[i].name) == 0) {
+      *usage = key_names[i].usage;
+      return true;
+    }
+  }
+  bool shift;
+  return name[1] == '\0' && char_usage(name[0], usage, &shift);
+}
+
+static bool load_trace(const char* path, uint64_t start_us) {
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  // Stroke of each key currently down in the trace
+  struct stroke* down[256] = {NULL};
+  char line[256];
+  uint number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    number++;
+    double ms;
+    char name[32], state[8];
+    if (line[0] == '#' || line[0] == '\n')
+      continue;
+    uint8_t usage;
+    if (sscanf(line, "%lf %31s %7s", &ms, name, state) != 3 ||
+        !trace_usage(name, &usage) || usage_key[usage] < 0) {
+      fprintf(stderr, "%s:%u: bad trace line\n", path, number);
+      ok = false;
+      break;
+    }
+    uint64_t t = start_us + (uint64_t)(ms * 1000.0);
+    if (strcmp(state, "down") == 0 && !down[usage]) {
+      down[usage] = add_stroke(usage, t, t);
+    } else if (strcmp(state, "up") == 0 && down[usage]) {
+      // Strokes may have moved when the array grew, find it again
+      struct stroke* s = last_stroke((uint8_t)usage_key[usage]);
+      s->release_us = t;
+      down[usage] = NULL;
+    }
+    // Repeated downs or ups are ignored
+  }
+  // Keys still down at the end are released 100 ms after the last press
+  for (uint u = 0; u < 256; ++u) {
+    if (down[u]) {
+      struct stroke* s = last_stroke((uint8_t)usage_key[u]);
+      s->release_us = strokes[stroke_count - 1].press_us + 100000;
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+static void add_edge(uint64_t time_us, uint8_t key, bool state) {
+  if (edge_count == edge_capacity)
+    edges = grow(edges, &edge_capacity, sizeof(*edges));
+  edges[edge_count++] = (struct edge){time_us, key, state};
+}
+
+// Raw edges of a key going to `state`, bouncing before it settles
+static void add_transition(uint8_t key, bool state, uint64_t time_us) {
+  uint bounces = bounce_us > 0 ? random_below(5) : 0;
+  for (uint i = 0; i < bounces; ++i) {
+    add_edge(time_us, key, state);
+    time_us += 30 + random_below(bounce_us / 5);
+    add_edge(time_us, key, !state);
+    time_us += 30 + random_below(bounce_us / 5);
+  }
+  add_edge(time_us, key, state);
+}
+
+static int compare_edges(const void* a, const void* b) {
+  const struct edge* ea = a;
+  const struct edge* eb = b;
+  return ea->time_us < eb->time_us ? -1 : ea->time_us > eb->time_us;
+}
+
+static int compare_u32(const void* a, const void* b) {
+  uint32_t ua = *(const uint32_t*)a;
+  uint32_t ub = *(const uint32_t*)b;
+  return ua < ub ? -1 : ua > ub;
+}
+
+static int compare_press(const void* a, const void* b) {
+  const struct stroke* sa = *(const struct stroke* const*)a;
+  const struct stroke* sb = *(const struct stroke* const*)b;
+  return sa->press_us < sb->press_us ? -1 : sa->press_us > sb->press_us;
+}
+
+static bool report_has(const uint8_t* keycode, uint8_t usage) {
+  for (uint i = 0; i < 6; ++i) {
+    if (keycode[i] == usage)
+      return true;
+  }
+  return false;
+}
+
+// Match a keyboard report received at `now_us` against the strokes
+static void keyboard_report(const uint8_t* keycode) {
+  // Strokes of the same key do not overlap, so only the first stroke of
+  // each key which is not over yet can be matched
+  struct stroke* current[KEY_COUNT] = {NULL};
+  for (uint32_t i = 0; i < stroke_count; ++i) {
+    struct stroke* s = &strokes[i];
+    if (!current[s->key] && !s->release_seen)
+      current[s->key] = s;
+  }
+
+  struct stroke* appeared[KEY_COUNT];
+  uint appeared_count = 0;
+  for (uint k = 0; k < KEY_COUNT; ++k) {
+    struct stroke* s = current[k];
+    if (!s || now_us < s->press_us)
+      continue;
+    if (!s->press_seen && now_us > s->release_us + DROP_AFTER_US) {
+      // Dropped, counted at the end. Let the next stroke be matched.
+      s->release_seen = true;
+      continue;
+    }
+    if (!s->press_seen && report_has(keycode, s->usage)) {
+      s->press_seen = true;
+      stats.press_latency[stats.press_count++] =
+          (uint32_t)(now_us - s->press_us);
+      appeared[appeared_count++] = s;
+    } else if (s->press_seen && now_us >= s->release_us &&
+               !report_has(keycode, s->usage)) {
+      s->release_seen = true;
+      stats.release_latency[stats.release_count++] =
+          (uint32_t)(now_us - s->release_us);
+    }
+  }
+
+  // Keys appearing in the same report count in the order they were pressed
+  qsort(appeared, appeared_count, sizeof(appeared[0]), compare_press);
+  for (uint i = 0; i < appeared_count; ++i) {
+    if (appeared[i]->press_us < last_seen_press_us)
+      stats.misordered++;
+    else
+      last_seen_press_us = appeared[i]->press_us;
+  }
+}
+
+static void hid_report(uint8_t instance,
+                       uint8_t report_id,
+                       const uint8_t* data,
+                       uint16_t len) {
+  stats.reports++;
+  if (instance == L61_HID_KEYBOARD && report_id == L61_REPORT_ID_KEYBOARD &&
+      len == 8)
+    keyboard_report(&data[2]);
+}
+
+static uint64_t clock_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void run(uint64_t start_us, uint64_t end_us) {
+  static bool raw[KEY_COUNT];
+  uint32_t e = 0;
+  uint64_t next_scan = start_us;
+  uint64_t next_poll = start_us + POLL_PHASE_US;
+  stats.scan_ns =
+      malloc(((end_us - start_us) / scan_period_us + 2) * sizeof(uint32_t));
+
+  while (next_scan <= end_us || next_poll <= end_us) {
+    if (next_scan <= next_poll) {
+      now_us = next_scan;
+      next_scan += scan_period_us;
+      for (; e < edge_count && edges[e].time_us <= now_us; ++e)
+        raw[edges[e].key] = edges[e].state;
+      l61_host_set_time_us(now_us);
+
+      uint64_t t0 = clock_ns();
+      l61_debounce_update(raw, l61_host_pressed, (uint32_t)now_us);
+      l61_hid_task();
+      stats.scan_ns[stats.scan_count++] = (uint32_t)(clock_ns() - t0);
+    } else {
+      now_us = next_poll;
+      next_poll += FRAME_US;
+      l61_host_set_time_us(now_us);
+      l61_host_hid_poll();
+      // The main loop sends the next report as soon as the endpoint is free
+      l61_hid_task();
+    }
+  }
+}
+
+static uint32_t percentile(const uint32_t* sorted, uint32_t count, uint p) {
+  return count == 0 ? 0 : sorted[(uint64_t)(count - 1) * p / 100];
+}
+
+static void print_latency(const char* name, uint32_t* values, uint32_t count) {
+  qsort(values, count, sizeof(*values), compare_u32);
+  printf("\"%s\": {\"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u}", name,
+         percentile(values, count, 50), percentile(values, count, 90),
+         percentile(values, count, 99), count ? values[count - 1] : 0);
+}
+
+static int bench(const char* path) {
+  stroke_count = 0;
+  edge_count = 0;
+  memset(&stats, 0, sizeof(stats));
+  last_seen_press_us = 0;
+  uint64_t start_us = now_us + 100000;
+
+  const char* ext = strrchr(path, '.');
+  bool text = ext && strcmp(ext, ".txt") == 0;
+  bool trace = ext && strcmp(ext, ".trace") == 0;
+  if (!text && !trace) {
+    fprintf(stderr, "%s: expected a .txt or .trace file\n", path);
+    return 2;
+  }
+  if (!(text ? load_text(path, start_us) : load_trace(path, start_us))) {
+    fprintf(stderr, "cannot load %s\n", path);
+    return 2;
+  }
+  if (stroke_count == 0) {
+    fprintf(stderr, "%s: no keys to type\n", path);
+    return 2;
+  }
+
+  uint64_t end_us = start_us;
+  for (uint32_t i = 0; i < stroke_count; ++i) {
+    add_transition(strokes[i].key, true, strokes[i].press_us);
+    add_transition(strokes[i].key, false, strokes[i].release_us);
+    if (strokes[i].release_us > end_us)
+      end_us = strokes[i].release_us;
+  }
+  qsort(edges, edge_count, sizeof(edges[0]), compare_edges);
+  end_us += DROP_AFTER_US;
+
+  stats.press_latency = malloc(stroke_count * sizeof(uint32_t));
+  stats.release_latency = malloc(stroke_count * sizeof(uint32_t));
+  run(start_us, end_us);
+
+  for (uint32_t i = 0; i < stroke_count; ++i) {
+    if (!strokes[i].press_seen)
+      stats.dropped++;
+  }
+
+  uint64_t total_ns = 0;
+  for (uint32_t i = 0; i < stats.scan_count; ++i)
+    total_ns += stats.scan_ns[i];
+  double seconds = (double)(end_us - start_us) / 1e6;
+
+  printf("{\"input\": \"%s\", \"scan_rate_hz\": %u, \"bounce_us\": %u, ",
+         path, 1000000 / scan_period_us, bounce_us);
+  printf("\"eager\": %d, \"throttle\": %d, ",
+         l61_debounce_get_mode() == L61_DEBOUNCE_EAGER,
+         l61_hid_get_key_throttle());
+  if (text)
+    printf("\"wpm\": %u, ", wpm);
+  printf("\"strokes\": %u, \"dropped\": %u, \"misordered\": %u, ",
+         stroke_count, stats.dropped, stats.misordered);
+  printf("\"seconds\": %.3f, \"reports\": %u, \"reports_per_s\": %.1f, ",
+         seconds, stats.reports, stats.reports / seconds);
+  print_latency("press_latency_us", stats.press_latency, stats.press_count);
+  printf(", ");
+  print_latency("release_latency_us", stats.release_latency,
+                stats.release_count);
+  qsort(stats.scan_ns, stats.scan_count, sizeof(uint32_t), compare_u32);
+  printf(", \"scan_ns\": {\"mean\": %llu, \"p50\": %u, \"p99\": %u}}\n",
+         (unsigned long long)(total_ns / stats.scan_count),
+         percentile(stats.scan_ns, stats.scan_count, 50),
+         percentile(stats.scan_ns, stats.scan_count, 99));
+
+  free(stats.press_latency);
+  free(stats.release_latency);
+  free(stats.scan_ns);
+  return stats.dropped == 0 ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  uint32_t seed = 1;
+  int first_input = argc;
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-') {
+      first_input = i;
+      break;
+    }
+    uint32_t value =
+        i + 1 < argc ? (uint32_t)strtoul(argv[i + 1], NULL, 0) : 0;
+    if (strcmp(argv[i], "-r") == 0 && value > 0 && value <= 1000000)
+      scan_period_us = 1000000 / value;
+    else if (strcmp(argv[i], "-w") == 0 && value > 0)
+      wpm = value;
+    else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+      bounce_us = value;
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      seed = value;
+    else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+      l61_debounce_set_mode(value ? L61_DEBOUNCE_EAGER : L61_DEBOUNCE_DEFERRED);
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      l61_hid_set_key_throttle(value != 0);
+    else
+      first_input = 0;
+    if (first_input == 0)
+      break;
+    ++i;
+  }
+  if (first_input == 0 || first_input >= argc) {
+    fprintf(stderr,
+            "usage: %s [-r scan_rate_hz] [-w wpm] [-b bounce_us] [-s seed] "
+            "[-e eager] [-t throttle] input...\n",
+            argv[0]);
+    return 2;
+  }
+
+  srand(seed);
+  l61_keymap_setup();
+  l61_debounce_init(NULL);
+  l61_host_hid_report = &hid_report;
+  map_usages();
+
+  // Let the first reports go out before the inputs start
+  now_us = 1000000;
+
+  int status = 0;
+  for (int i = first_input; i < argc; ++i) {
+    int result = bench(argv[i]);
+    if (result > status)
+      status = result;
+  }
+  free(strokes);
+  free(edges);
+  return status;
+}
@@ -0,0 +1,161 @@
+/*
+** file: l61_cycles_sim.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Runs an ARM ELF program built for the RP2040's core on the simulator of
+** l61_m0.c, with what it writes through semihosting on the standard
+** output. This is how l61_cycles_target.c counts the key path's cycles
+** without a board (see host/README.md).
+**
+** The exit status is the program's. A fault is reported with the address
+** of the instruction that caused it, and a program still running after -c
+** cycles is stopped.
+**
+** Usage: l61_cycles_sim [-c max_cycles] program.elf
+*/
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "l61_m0.h"
+
+// Default limit on the cycles a program runs for, a few seconds at 125 MHz
+#define MAX_CYCLES 1000000000ull
+// Stack after the program's segments
+#define STACK_SIZE (1024 * 1024)
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void write_stdout(const char* data, size_t len) {
+  fwrite(data, 1, len, stdout);
+}
+
+static uint8_t* read_file(const char* path, size_t* len) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t* data = malloc(end > 0 ? end : 1);
+  if (!data || fread(data, 1, end, f) != (size_t)end) {
+    fprintf(stderr, "%s: could not read\n", path);
+    free(data);
+    fclose(f);
+    return NULL;
+  }
+  fclose(f);
+  *len = end;
+  return data;
+}
+
+// Load the segments of the ELF file into the simulator's memory and return
+// its entry point, or 0 if it is not a 32 bit little endian ARM executable
+static uint32_t load_elf(struct l61_m0* m,
+                         const char* path,
+                         const uint8_t* data,
+                         size_t len) {
+  const Elf32_Ehdr* ehdr = (const Elf32_Ehdr*)data;
+  if (len < sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+      ehdr->e_ident[EI_CLASS] != ELFCLASS32 ||
+      ehdr->e_ident[EI_DATA] != ELFDATA2LSB || ehdr->e_machine != EM_ARM ||
+      ehdr->e_type != ET_EXEC) {
+    fprintf(stderr, "%s: not an ARM executable\n", path);
+    return 0;
+  }
+  if (ehdr->e_phoff > len ||
+      (size_t)ehdr->e_phnum * sizeof(Elf32_Phdr) > len - ehdr->e_phoff) {
+    fprintf(stderr, "%s: truncated program headers\n", path);
+    return 0;
+  }
+  const Elf32_Phdr* phdr = (const Elf32_Phdr*)(data + ehdr->e_phoff);
+
+  uint32_t low = UINT32_MAX;
+  uint32_t high = 0;
+  for (int i = 0; i < ehdr->e_phnum; ++i) {
+    if (phdr[i].p_type != PT_LOAD || phdr[i].p_memsz == 0)
+      continue;
+    if (phdr[i].p_offset > len || phdr[i].p_filesz > len - phdr[i].p_offset ||
+        phdr[i].p_filesz > phdr[i].p_memsz) {
+      fprintf(stderr, "%s: truncated segment\n", path);
+      return 0;
+    }
+    if (phdr[i].p_vaddr < low)
+      low = phdr[i].p_vaddr;
+    if (phdr[i].p_vaddr + phdr[i].p_memsz > high)
+      high = phdr[i].p_vaddr + phdr[i].p_memsz;
+  }
+  if (low >= high) {
+    fprintf(stderr, "%s: nothing to load\n", path);
+    return 0;
+  }
+
+  m->base = low & ~7u;
+  m->size = ((high - m->base + 7) & ~7u) + STACK_SIZE;
+  m->mem = calloc(m->size, 1);
+  if (!m->mem) {
+    fprintf(stderr, "%s: out of memory\n", path);
+    return 0;
+  }
+  for (int i = 0; i < ehdr->e_phnum; ++i) {
+    if (phdr[i].p_type == PT_LOAD)
+      memcpy(&m->mem[phdr[i].p_vaddr - m->base], data + phdr[i].p_offset,
+             phdr[i].p_filesz);
+  }
+  return ehdr->e_entry;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  uint64_t max_cycles = MAX_CYCLES;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:")) != -1) {
+    switch (opt) {
+      case 'c':
+        max_cycles = strtoull(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-c max_cycles] program.elf\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind + 1 != argc) {
+    fprintf(stderr, "Usage: %s [-c max_cycles] program.elf\n", argv[0]);
+    return 2;
+  }
+  const char* path = argv[optind];
+
+  size_t len;
+  uint8_t* data = read_file(path, &len);
+  if (!data)
+    return 2;
+  struct l61_m0 m = {.write = write_stdout};
+  uint32_t entry = load_elf(&m, path, data, len);
+  free(data);
+  if (entry == 0)
+    return 2;
+
+  l61_m0_reset(&m, entry);
+  bool exited = l61_m0_run(&m, max_cycles);
+  fflush(stdout);
+  if (m.fault) {
+    fprintf(stderr, "%s: %s at 0x%08x after %llu cycles\n", path, m.fault,
+            m.fault_pc, (unsigned long long)m.cycles);
+  } else if (!exited) {
+    fprintf(stderr, "%s: still running after %llu cycles\n", path,
+            (unsigned long long)m.cycles);
+    m.exit_status = 1;
+  }
+  free(m.mem);
+  return m.exit_status;
+}
@@ -0,0 +1,193 @@
+/*
+** file: l61_cycles_target.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Key path cycle counts without a board: this program is built for the
+** RP2040's Cortex-M0+ with the firmware's compiler and flags, and run on
+** the simulated core of l61_m0.c by l61_cycles_sim. It types fixed key
+** matrix states through the debouncer, the keymap, the report building and
+** l61_hid_task, with the probes of lard61_cycles.c timing them on the
+** simulated SysTick, and prints their table like the `cycles` command.
+**
+** The states are held long enough to give every load at least the 100
+** calls tools/l61_cycles.py requires, and the same program always gives
+** the same counts, so they can be stored and compared between commits.
+**
+** The scan probe times the debounce alone: reading the matrix is GPIO
+** access and waits for the rows to settle, which are only meaningful on the
+** board. Its rows stay empty.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include "l61_host.h"
+#include "lard61_cycles.h"
+#include "lard61_debounce.h"
+#include "lard61_hid.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "class/hid/hid.h"
+
+#define KEY_COUNT L61_DEBOUNCE_KEY_COUNT
+// 1 kHz, the default scan rate, with the main loop calling l61_hid_task
+// after each scan and after each USB frame
+#define SCAN_US 1000
+// Scans a state is held for, and after releasing its keys
+#define HOLD_SCANS 200
+#define SETTLE_SCANS 100
+// Scans a switch bounces for after each edge, flipping every scan
+#define BOUNCE_SCANS 3
+// Keys of the typing roll: one pressed every ROLL_GAP_SCANS, each held for
+// ROLL_HOLD_SCANS, so that up to four overlap
+#define ROLL_GAP_SCANS 5
+#define ROLL_HOLD_SCANS 20
+
+#define SYS_WRITE 0x05
+#define SYS_EXIT_EXTENDED 0x20
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026u
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static uint64_t now_us = 1000000;
+static bool raw[KEY_COUNT] = {false};
+
+// Keys typing letters on the base layer, in key index order
+static uint letter_keys[KEY_COUNT];
+static uint letter_count = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void find_letter_keys() {
+  const uint16_t* base = l61_keymap_get()->keycode[L61_LAYER_BASE];
+  for (uint i = 0; i < KEY_COUNT; ++i) {
+    if ((base[i] & L61_KC_TYPE_MASK) == L61_KC_KEYBOARD &&
+        (base[i] & 0xff) >= HID_KEY_A && (base[i] & 0xff) <= HID_KEY_Z)
+      letter_keys[letter_count++] = i;
+  }
+}
+
+// One scan period: debounce the raw states like l61_keymatrix_update does
+// once it read them, then the main loop's l61_hid_task calls around the
+// host polling the keyboard
+static void scan() {
+  now_us += SCAN_US / 2;
+  l61_host_set_time_us(now_us);
+  uint32_t start = l61_cycles_now();
+  l61_debounce_update(raw, l61_host_pressed, (uint32_t)now_us);
+  l61_cycles_record(L61_CYCLES_DEBOUNCE, start);
+  l61_hid_task();
+
+  now_us += SCAN_US / 2;
+  l61_host_set_time_us(now_us);
+  l61_host_hid_poll();
+  l61_hid_task();
+}
+
+// Raw state `scans` after an edge to `state`
+static bool bounce(bool state, uint scans) {
+  return scans < BOUNCE_SCANS && scans % 2 ? !state : state;
+}
+
+// Press the first `count` letter keys together, hold them and release them
+static void chord(uint count) {
+  for (uint s = 0; s < HOLD_SCANS; ++s) {
+    for (uint i = 0; i < count; ++i)
+      raw[letter_keys[i]] = bounce(true, s);
+    scan();
+  }
+  for (uint s = 0; s < SETTLE_SCANS; ++s) {
+    for (uint i = 0; i < count; ++i)
+      raw[letter_keys[i]] = bounce(false, s);
+    scan();
+  }
+}
+
+// Type every letter key in turn with overlapping strokes
+static void roll() {
+  uint scans = letter_count * ROLL_GAP_SCANS + ROLL_HOLD_SCANS + SETTLE_SCANS;
+  for (uint s = 0; s < scans; ++s) {
+    for (uint i = 0; i < letter_count; ++i) {
+      uint press = i * ROLL_GAP_SCANS;
+      uint release = press + ROLL_HOLD_SCANS;
+      if (s < press)
+        raw[letter_keys[i]] = false;
+      else if (s < release)
+        raw[letter_keys[i]] = bounce(true, s - press);
+      else
+        raw[letter_keys[i]] = bounce(false, s - release);
+    }
+    scan();
+  }
+}
+
+//-----------------------------------------------------------------------------
+// C library support: there is nothing but semihosting on the simulated core
+//-----------------------------------------------------------------------------
+
+static uint32_t semihosting(uint32_t op, const void* arg) {
+  register uint32_t r0 __asm__("r0") = op;
+  register const void* r1 __asm__("r1") = arg;
+  __asm__ volatile("bkpt 0xab" : "+r"(r0) : "r"(r1) : "memory");
+  return r0;
+}
+
+int _write(int fd, char* data, int len) {
+  uint32_t args[3] = {(uint32_t)fd, (uint32_t)data, (uint32_t)len};
+  semihosting(SYS_WRITE, args);
+  return len;
+}
+
+void _exit(int status) {
+  uint32_t args[2] = {ADP_STOPPED_APPLICATION_EXIT, (uint32_t)status};
+  semihosting(SYS_EXIT_EXTENDED, args);
+  for (;;) {
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+int main() {
+  l61_cycles_setup();
+  l61_keymap_setup();
+  l61_debounce_init(NULL);
+  find_letter_keys();
+  if (letter_count < 10) {
+    printf("the keymap has %u letter keys, 10 are needed\n", letter_count);
+    return 1;
+  }
+
+  // Let the first reports go out before counting
+  for (uint s = 0; s < SETTLE_SCANS; ++s)
+    scan();
+  l61_cycles_reset();
+
+  for (uint s = 0; s < HOLD_SCANS; ++s)
+    scan();
+  chord(1);
+  chord(6);
+  chord(10);
+  roll();
+
+  l61_cycles_print();
+  return 0;
+}
+
+extern void (*__init_array_start[])(void);
+extern void (*__init_array_end[])(void);
+
+// Entry point, with the stack set up and the data loaded by l61_cycles_sim
+void _start() {
+  for (void (**init)(void) = __init_array_start; init < __init_array_end;
+       ++init)
+    (*init)();
+  int status = main();
+  fflush(stdout);
+  _exit(status);
+}
@@ -0,0 +1,259 @@
+/*
+** file: l61_dcd.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** A transfer queued by the stack with dcd_edpt_xfer waits on its endpoint
+** until the simulated host reads or writes it one packet at a time. It is
+** complete once all its bytes went through or after a short packet, as on
+** the RP2040, and the completion event is handled by tud_task right away.
+*/
+
+#include "l61_dcd.h"
+
+#include <string.h>
+#include "device/dcd.h"
+#include "tusb.h"
+
+#define RHPORT BOARD_TUD_RHPORT
+
+struct endpoint {
+  bool open;
+  bool stalled;
+  uint16_t packet_size;
+  // Transfer queued by the stack
+  bool busy;
+  uint8_t* buffer;
+  uint16_t length;
+  uint16_t done;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct endpoint endpoints[TUP_DCD_ENDPOINT_MAX][2];
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static struct endpoint* get_endpoint(uint8_t ep) {
+  uint8_t number = tu_edpt_number(ep);
+  if (number >= TUP_DCD_ENDPOINT_MAX)
+    return NULL;
+  return &endpoints[number][tu_edpt_dir(ep)];
+}
+
+// Close every endpoint but endpoint 0
+static void reset_endpoints() {
+  memset(endpoints, 0, sizeof(endpoints));
+  for (uint8_t dir = 0; dir < 2; ++dir) {
+    endpoints[0][dir].open = true;
+    endpoints[0][dir].packet_size = CFG_TUD_ENDPOINT0_SIZE;
+  }
+}
+
+// Endpoint `ep` if the host can exchange a packet with it
+static struct endpoint* ready_endpoint(uint8_t ep) {
+  struct endpoint* e = get_endpoint(ep);
+  if (e == NULL || !e->open || e->stalled || !e->busy)
+    return NULL;
+  return e;
+}
+
+// Count the `moved` bytes of a packet of `len` bytes on `ep`, and complete
+// the transfer if it was the last packet
+static void end_packet(uint8_t ep,
+                       struct endpoint* e,
+                       uint16_t moved,
+                       uint16_t len) {
+  e->done += moved;
+  if (e->done < e->length && len == e->packet_size)
+    return;
+  e->busy = false;
+  dcd_event_xfer_complete(RHPORT, ep, e->done, XFER_RESULT_SUCCESS, true);
+  tud_task();
+}
+
+//-----------------------------------------------------------------------------
+// TinyUSB device controller driver API
+//-----------------------------------------------------------------------------
+
+// TinyUSB 0.17 (pico SDK 2.1) passes the port configuration to dcd_init,
+// and can stop the stack with dcd_deinit
+#if TUSB_VERSION_MAJOR == 0 && TUSB_VERSION_MINOR < 17
+void dcd_init(uint8_t rhport) {
+  reset_endpoints();
+}
+#else
+bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
+  reset_endpoints();
+  return true;
+}
+
+bool dcd_deinit(uint8_t rhport) {
+  reset_endpoints();
+  return true;
+}
+#endif
+
+void dcd_int_handler(uint8_t rhport) {}
+
+void dcd_int_enable(uint8_t rhport) {}
+
+void dcd_int_disable(uint8_t rhport) {}
+
+void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
+  // The stack leaves the status stage of SET_ADDRESS to the controller
+  dcd_edpt_xfer(rhport, TUSB_DIR_IN_MASK, NULL, 0);
+}
+
+void dcd_remote_wakeup(uint8_t rhport) {}
+
+void dcd_connect(uint8_t rhport) {}
+
+void dcd_disconnect(uint8_t rhport) {}
+
+void dcd_sof_enable(uint8_t rhport, bool en) {}
+
+bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
+  struct endpoint* e = get_endpoint(desc_ep->bEndpointAddress);
+  if (e == NULL)
+    return false;
+  memset(e, 0, sizeof(*e));
+  e->open = true;
+  e->packet_size = tu_edpt_packet_size(desc_ep);
+  return true;
+}
+
+void dcd_edpt_close_all(uint8_t rhport) {
+  reset_endpoints();
+}
+
+void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
+  struct endpoint* e = get_endpoint(ep_addr);
+  if (e != NULL)
+    memset(e, 0, sizeof(*e));
+}
+
+bool dcd_edpt_xfer(uint8_t rhport,
+                   uint8_t ep_addr,
+                   uint8_t* buffer,
+                   uint16_t total_bytes) {
+  struct endpoint* e = get_endpoint(ep_addr);
+  if (e == NULL || !e->open || e->busy)
+    return false;
+  e->busy = true;
+  e->buffer = buffer;
+  e->length = total_bytes;
+  e->done = 0;
+  return true;
+}
+
+// Neither the HID nor the CDC driver transfers from a FIFO, and the
+// firmware has no isochronous endpoint
+bool dcd_edpt_xfer_fifo(uint8_t rhport,
+                        uint8_t ep_addr,
+                        tu_fifo_t* ff,
+                        uint16_t total_bytes) {
+  return false;
+}
+
+bool dcd_edpt_iso_alloc(uint8_t rhport,
+                        uint8_t ep_addr,
+                        uint16_t largest_packet_size) {
+  return false;
+}
+
+bool dcd_edpt_iso_activate(uint8_t rhport,
+                           tusb_desc_endpoint_t const* desc_ep) {
+  return false;
+}
+
+void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
+  struct endpoint* e = get_endpoint(ep_addr);
+  if (e == NULL)
+    return;
+  e->stalled = true;
+  e->busy = false;
+}
+
+void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
+  struct endpoint* e = get_endpoint(ep_addr);
+  if (e != NULL)
+    e->stalled = false;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_dcd_bus_reset(void) {
+  reset_endpoints();
+  dcd_event_bus_reset(RHPORT, TUSB_SPEED_FULL, true);
+  tud_task();
+}
+
+int l61_dcd_control(const tusb_control_request_t* request, void* data) {
+  // A SETUP packet is always received, and clears the stall of endpoint 0
+  for (uint8_t dir = 0; dir < 2; ++dir) {
+    endpoints[0][dir].stalled = false;
+    endpoints[0][dir].busy = false;
+  }
+  dcd_event_setup_received(RHPORT, (const uint8_t*)request, true);
+  tud_task();
+
+  uint8_t* bytes = data;
+  bool in = request->bmRequestType_bit.direction == TUSB_DIR_IN;
+  uint16_t len = 0;
+  while (len < request->wLength) {
+    if (in) {
+      int n = l61_dcd_in(TUSB_DIR_IN_MASK, bytes + len);
+      if (n < 0)
+        return -1;
+      len += (uint16_t)n;
+      if (n < CFG_TUD_ENDPOINT0_SIZE)
+        break;
+    } else {
+      uint16_t n = tu_min16(request->wLength - len, CFG_TUD_ENDPOINT0_SIZE);
+      if (!l61_dcd_out(0, bytes + len, n))
+        return -1;
+      len += n;
+    }
+  }
+
+  // The status stage is an empty packet in the other direction
+  bool acked = in && request->wLength > 0
+                   ? l61_dcd_out(0, NULL, 0)
+                   : l61_dcd_in(TUSB_DIR_IN_MASK, NULL) == 0;
+  return acked ? len : -1;
+}
+
+int l61_dcd_in(uint8_t ep, void* data) {
+  struct endpoint* e = ready_endpoint(ep);
+  if (e == NULL || tu_edpt_dir(ep) != TUSB_DIR_IN)
+    return -1;
+  uint16_t len = tu_min16(e->length - e->done, e->packet_size);
+  if (len > 0)
+    memcpy(data, e->buffer + e->done, len);
+  end_packet(ep, e, len, len);
+  return len;
+}
+
+bool l61_dcd_out(uint8_t ep, const void* data, uint16_t len) {
+  struct endpoint* e = ready_endpoint(ep);
+  if (e == NULL || tu_edpt_dir(ep) != TUSB_DIR_OUT || len > e->packet_size)
+    return false;
+  // Bytes past the end of the transfer are lost, as with a controller
+  uint16_t kept = tu_min16(len, e->length - e->done);
+  if (kept > 0)
+    memcpy(e->buffer + e->done, data, kept);
+  end_packet(ep, e, kept, len);
+  return true;
+}
+
+bool l61_dcd_is_open(uint8_t ep) {
+  struct endpoint* e = get_endpoint(ep);
+  return e != NULL && e->open;
+}
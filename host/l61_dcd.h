@@ -0,0 +1,38 @@
+/*
+** file: l61_dcd.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Simulated USB device controller, under the real TinyUSB device stack.
+** l61_dcd.c implements the dcd_* API which TinyUSB expects from a port,
+** and the functions below play the host side of the bus. Each of them
+** raises the controller events and runs tud_task until the stack has
+** handled them, like the firmware's main loop would.
+**
+** Endpoint addresses have TUSB_DIR_IN_MASK set for IN endpoints, as in the
+** descriptors.
+*/
+
+#ifndef _L61_DCD_H
+#define _L61_DCD_H
+
+#include "common/tusb_types.h"
+
+// Reset the bus, before enumerating the device
+void l61_dcd_bus_reset(void);
+// Run a control transfer: the SETUP packet `request`, the data stage read
+// into or sent from `data`, which holds request->wLength bytes, and the
+// status stage. Return the length of the data stage, or -1 if the device
+// stalled or did not answer.
+int l61_dcd_control(const tusb_control_request_t* request, void* data);
+// Read a packet from IN endpoint `ep` into `data`, which holds up to the
+// endpoint's packet size. Return its length, or -1 if the device had
+// nothing to send (NAK) or the endpoint is stalled.
+int l61_dcd_in(uint8_t ep, void* data);
+// Send a packet of `len` bytes to OUT endpoint `ep`. Return false if the
+// device was not ready to receive it (NAK) or the endpoint is stalled.
+bool l61_dcd_out(uint8_t ep, const void* data, uint16_t len);
+// Whether the stack opened endpoint `ep`
+bool l61_dcd_is_open(uint8_t ep);
+
+#endif /* _L61_DCD_H */
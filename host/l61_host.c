@@ -0,0 +1,192 @@
+/*
+** file: l61_host.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+*/
+
+#include "l61_host.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "lard61_boot.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_cycles.h"
+#include "lard61_health.h"
+#include "lard61_led.h"
+#include "lard61_profile.h"
+#include "lard61_scan.h"
+#include "pico/bootrom.h"
+#include "pico/time.h"
+
+bool l61_host_pressed[N_ROWS * N_COLS] = {false};
+
+static uint8_t host_leds = 0;
+
+static uint64_t now_us = 0;
+
+void l61_host_set_time_us(uint64_t us) {
+  now_us = us;
+}
+
+//-----------------------------------------------------------------------------
+// pico/time.h
+//-----------------------------------------------------------------------------
+
+absolute_time_t get_absolute_time(void) {
+  return now_us;
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+  return (uint32_t)(t / 1000);
+}
+
+uint32_t time_us_32(void) {
+  return (uint32_t)now_us;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_keymatrix.h
+//-----------------------------------------------------------------------------
+
+bool l61_keymatrix_is_key_pressed(uint index) {
+  return l61_host_pressed[index];
+}
+
+bool l61_keymatrix_is_fn_key_pressed() {
+  return l61_host_pressed[L61_KEY_FN];
+}
+
+uint l61_keymatrix_get_pressed_count() {
+  uint count = 0;
+  for (uint i = 0; i < N_ROWS * N_COLS; ++i)
+    count += l61_host_pressed[i];
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_cdc.h
+//-----------------------------------------------------------------------------
+
+void l61_printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+}
+
+void l61_cdc_set_raw(bool raw) {
+  (void)raw;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_config.h: nothing is stored, the defaults are used
+//-----------------------------------------------------------------------------
+
+bool l61_config_load(enum l61_config_item item, void* data, uint32_t size) {
+  (void)item;
+  (void)data;
+  (void)size;
+  return false;
+}
+
+void l61_config_store(enum l61_config_item item,
+                      const void* data,
+                      uint32_t size) {
+  (void)item;
+  (void)data;
+  (void)size;
+}
+
+void l61_config_clear(enum l61_config_item item) {
+  (void)item;
+}
+
+//-----------------------------------------------------------------------------
+// Boot and health
+//-----------------------------------------------------------------------------
+
+void l61_boot_mark(enum l61_boot_phase phase) {
+  (void)phase;
+}
+
+void l61_health_count(enum l61_fault fault) {
+  (void)fault;
+}
+
+void l61_health_trace(enum l61_health_event event, uint32_t arg) {
+  (void)event;
+  (void)arg;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_cycles.h: SysTick only counts on the board, or on the simulated core
+// of l61_cycles_target.c which builds lard61_cycles.c
+//-----------------------------------------------------------------------------
+
+#ifndef L61_HOST_M0
+uint32_t l61_cycles_now() {
+  return 0;
+}
+
+uint32_t l61_cycles_record(enum l61_cycles_probe probe, uint32_t start) {
+  (void)probe;
+  (void)start;
+  return 0;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// lard61_profile.h: the settings are set directly, there is no scan here
+//-----------------------------------------------------------------------------
+
+void l61_profile_key(uint key, bool pressed, uint32_t delay_us) {
+  (void)key;
+  (void)pressed;
+  (void)delay_us;
+}
+
+uint16_t l61_profile_get_debounce_window() {
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_scan.h: the host tools scan at their own pace, at least every frame
+//-----------------------------------------------------------------------------
+
+enum l61_scan_mode l61_scan_get_mode() {
+  return L61_SCAN_FREE_RUNNING;
+}
+
+uint l61_scan_get_rate() {
+  return L61_SCAN_RATE_DEFAULT_HZ;
+}
+
+//-----------------------------------------------------------------------------
+// lard61_led.h: only the host LED state is kept
+//-----------------------------------------------------------------------------
+
+void l61_led_set_usb_state(enum l61_led_usb_state state) {
+  (void)state;
+}
+
+void l61_led_set_host_leds(uint8_t leds) {
+  host_leds = leds;
+}
+
+uint8_t l61_led_get_host_leds() {
+  return host_leds;
+}
+
+//-----------------------------------------------------------------------------
+// pico/bootrom.h
+//-----------------------------------------------------------------------------
+
+void reset_usb_boot(uint32_t gpio_activity_pin_mask,
+                    uint32_t disable_interface_mask) {
+  (void)gpio_activity_pin_mask;
+  (void)disable_interface_mask;
+  fprintf(stderr, "reset_usb_boot called, exiting\n");
+  exit(3);
+}
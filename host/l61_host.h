@@ -0,0 +1,52 @@
+/*
+** file: l61_host.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Stand-ins for the hardware-facing parts of the firmware, so that its
+** debounce, keymap and report code can run on the host.
+**
+** The key matrix is replaced by the `l61_host_pressed` table, which the
+** debouncer writes to like it writes to the real one, the clock by a
+** simulated one, and the USB host by l61_host_hid_poll and the
+** l61_host_cdc_write and l61_host_hid_report hooks. The TinyUSB callbacks
+** of lard61_usb.c are called like the device stack would.
+**
+** The USB stand-ins are in l61_host_usb.c, in the l61_host library only.
+** The l61_host_tusb library runs the real TinyUSB stack instead, driven
+** through l61_dcd.h.
+*/
+
+#ifndef _L61_HOST_H
+#define _L61_HOST_H
+
+#include "lard61_keymatrix.h"
+#include "pico/types.h"
+
+// Debounced key states, read by l61_keymatrix_is_key_pressed
+extern bool l61_host_pressed[N_ROWS * N_COLS];
+
+// Set the simulated time returned by the pico time functions
+void l61_host_set_time_us(uint64_t us);
+
+// The rest is only in the l61_host library, see l61_host_usb.c
+
+// Called with the data written with tud_cdc_write, if set
+extern void (*l61_host_cdc_write)(const void* data, uint32_t size);
+
+// Called with each HID report the simulated host receives. Keyboard
+// reports are the 8 bytes of the boot keyboard report, after the report ID.
+extern void (*l61_host_hid_report)(uint8_t instance,
+                                   uint8_t report_id,
+                                   const uint8_t* data,
+                                   uint16_t len);
+// Poll the HID endpoints like the host does every frame: pass the reports
+// waiting on them to l61_host_hid_report and make them ready again
+void l61_host_hid_poll(void);
+// Switch a HID interface to the boot or report protocol, like a
+// SET_PROTOCOL request
+void l61_host_hid_set_protocol(uint8_t instance, uint8_t protocol);
+// Mount or unmount the device, calling tud_mount_cb or tud_umount_cb
+void l61_host_set_mounted(bool mounted);
+
+#endif /* _L61_HOST_H */
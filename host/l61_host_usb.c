@@ -0,0 +1,143 @@
+/*
+** file: l61_host_usb.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Stand-in for the TinyUSB device API, used by the host tools which only
+** need the reports and CDC output of the firmware. l61_usb_sim runs the
+** real stack instead, see l61_dcd.h.
+*/
+
+#include "l61_host.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "class/cdc/cdc_device.h"
+#include "class/hid/hid_device.h"
+#include "device/usbd.h"
+
+void (*l61_host_cdc_write)(const void* data, uint32_t size) = NULL;
+void (*l61_host_hid_report)(uint8_t instance,
+                            uint8_t report_id,
+                            const uint8_t* data,
+                            uint16_t len) = NULL;
+
+// Report waiting on each HID endpoint
+#define HID_INSTANCES 2
+#define HID_REPORT_MAX 16
+static struct {
+  bool busy;
+  uint8_t report_id;
+  uint8_t data[HID_REPORT_MAX];
+  uint16_t len;
+  uint8_t protocol;
+} hid_endpoint[HID_INSTANCES] = {
+    {.protocol = HID_PROTOCOL_REPORT},
+    {.protocol = HID_PROTOCOL_REPORT},
+};
+
+static bool mounted = true;
+
+//-----------------------------------------------------------------------------
+// TinyUSB CDC API: nothing is received and the port is always open
+//-----------------------------------------------------------------------------
+
+uint32_t tud_cdc_available(void) {
+  return 0;
+}
+
+uint32_t tud_cdc_read(void* buffer, uint32_t bufsize) {
+  (void)buffer;
+  (void)bufsize;
+  return 0;
+}
+
+uint32_t tud_cdc_write_available(void) {
+  return 1024;
+}
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize) {
+  if (l61_host_cdc_write)
+    l61_host_cdc_write(buffer, bufsize);
+  else
+    fwrite(buffer, 1, bufsize, stdout);
+  return bufsize;
+}
+
+uint32_t tud_cdc_write_flush(void) {
+  return 0;
+}
+
+bool tud_cdc_connected(void) {
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// TinyUSB HID API: one report at a time per endpoint, until polled
+//-----------------------------------------------------------------------------
+
+void l61_host_hid_poll(void) {
+  for (uint8_t i = 0; i < HID_INSTANCES; ++i) {
+    if (!hid_endpoint[i].busy)
+      continue;
+    hid_endpoint[i].busy = false;
+    if (l61_host_hid_report)
+      l61_host_hid_report(i, hid_endpoint[i].report_id, hid_endpoint[i].data,
+                          hid_endpoint[i].len);
+    tud_hid_report_complete_cb(i, hid_endpoint[i].data, hid_endpoint[i].len);
+  }
+}
+
+void l61_host_hid_set_protocol(uint8_t instance, uint8_t protocol) {
+  if (instance < HID_INSTANCES)
+    hid_endpoint[instance].protocol = protocol;
+}
+
+bool tud_hid_n_ready(uint8_t instance) {
+  return instance < HID_INSTANCES && !hid_endpoint[instance].busy;
+}
+
+uint8_t tud_hid_n_get_protocol(uint8_t instance) {
+  return instance < HID_INSTANCES ? hid_endpoint[instance].protocol
+                                  : HID_PROTOCOL_REPORT;
+}
+
+bool tud_hid_n_report(uint8_t instance,
+                      uint8_t report_id,
+                      void const* report,
+                      uint16_t len) {
+  if (!tud_hid_n_ready(instance) || len > HID_REPORT_MAX)
+    return false;
+  hid_endpoint[instance].busy = true;
+  hid_endpoint[instance].report_id = report_id;
+  memcpy(hid_endpoint[instance].data, report, len);
+  hid_endpoint[instance].len = len;
+  return true;
+}
+
+bool tud_hid_n_keyboard_report(uint8_t instance,
+                               uint8_t report_id,
+                               uint8_t modifier,
+                               const uint8_t keycode[6]) {
+  uint8_t report[8] = {modifier, 0};
+  memcpy(&report[2], keycode, 6);
+  return tud_hid_n_report(instance, report_id, report, sizeof(report));
+}
+
+//-----------------------------------------------------------------------------
+// TinyUSB device API
+//-----------------------------------------------------------------------------
+
+void l61_host_set_mounted(bool mount) {
+  if (mount == mounted)
+    return;
+  mounted = mount;
+  if (mounted)
+    tud_mount_cb();
+  else
+    tud_umount_cb();
+}
+
+bool tud_mounted(void) {
+  return mounted;
+}
@@ -0,0 +1,783 @@
+/*
+** file: l61_m0.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Instructions are decoded as in the ARMv6-M Architecture Reference Manual,
+** section A5.2. Reading the PC as an operand gives the address of the
+** instruction plus 4. Each instruction adds its cycles to `cycles` before
+** it runs, so SysTick reads see the cycle count at their start.
+*/
+
+#include "l61_m0.h"
+
+#include <string.h>
+
+#define SYSTICK_BASE 0xe000e010u
+#define SYSTICK_CSR (SYSTICK_BASE + 0x0)
+#define SYSTICK_RVR (SYSTICK_BASE + 0x4)
+#define SYSTICK_CVR (SYSTICK_BASE + 0x8)
+#define SYSTICK_CALIB (SYSTICK_BASE + 0xc)
+#define SYSTICK_MASK 0xffffffu
+#define SYSTICK_CSR_ENABLE 0x1u
+
+#define BKPT_SEMIHOSTING 0xab
+#define SYS_WRITEC 0x03
+#define SYS_WRITE0 0x04
+#define SYS_WRITE 0x05
+#define SYS_EXIT 0x18
+#define SYS_EXIT_EXTENDED 0x20
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026u
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void fault(struct l61_m0* m, const char* reason) {
+  if (m->stopped)
+    return;
+  m->stopped = true;
+  m->exit_status = 1;
+  m->fault = reason;
+}
+
+static bool in_memory(struct l61_m0* m, uint32_t addr, uint32_t len) {
+  return addr >= m->base && addr - m->base <= m->size - len;
+}
+
+static uint32_t systick_read(struct l61_m0* m, uint32_t addr) {
+  switch (addr) {
+    case SYSTICK_CSR:
+      return m->systick_csr;
+    case SYSTICK_RVR:
+      return m->systick_rvr;
+    case SYSTICK_CVR: {
+      if (!(m->systick_csr & SYSTICK_CSR_ENABLE))
+        return 0;
+      // Cleared to 0, reloaded at the next cycle, then counting down
+      uint64_t elapsed = m->cycles - m->systick_cleared;
+      if (elapsed == 0)
+        return 0;
+      uint64_t period = (uint64_t)m->systick_rvr + 1;
+      return m->systick_rvr - (uint32_t)((elapsed - 1) % period);
+    }
+    case SYSTICK_CALIB:
+      return 0;
+  }
+  fault(m, "read from an unmapped address");
+  return 0;
+}
+
+static void systick_write(struct l61_m0* m, uint32_t addr, uint32_t value) {
+  switch (addr) {
+    case SYSTICK_CSR:
+      m->systick_csr = value & 0x7;
+      return;
+    case SYSTICK_RVR:
+      m->systick_rvr = value & SYSTICK_MASK;
+      return;
+    case SYSTICK_CVR:
+      m->systick_cleared = m->cycles;
+      return;
+    case SYSTICK_CALIB:
+      return;
+  }
+  fault(m, "write to an unmapped address");
+}
+
+static uint32_t load(struct l61_m0* m, uint32_t addr, uint32_t len) {
+  if (addr % len != 0) {
+    fault(m, "unaligned load");
+    return 0;
+  }
+  if (!in_memory(m, addr, len)) {
+    if (len == 4 && addr >= SYSTICK_BASE && addr <= SYSTICK_CALIB)
+      return systick_read(m, addr);
+    fault(m, "load from an unmapped address");
+    return 0;
+  }
+  const uint8_t* p = &m->mem[addr - m->base];
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < len; ++i)
+    value |= (uint32_t)p[i] << (8 * i);
+  return value;
+}
+
+static void store(struct l61_m0* m,
+                  uint32_t addr,
+                  uint32_t len,
+                  uint32_t value) {
+  if (addr % len != 0) {
+    fault(m, "unaligned store");
+    return;
+  }
+  if (!in_memory(m, addr, len)) {
+    if (len == 4 && addr >= SYSTICK_BASE && addr <= SYSTICK_CALIB)
+      systick_write(m, addr, value);
+    else
+      fault(m, "store to an unmapped address");
+    return;
+  }
+  uint8_t* p = &m->mem[addr - m->base];
+  for (uint32_t i = 0; i < len; ++i)
+    p[i] = (uint8_t)(value >> (8 * i));
+}
+
+static void set_nz(struct l61_m0* m, uint32_t result) {
+  m->n = result >> 31;
+  m->z = result == 0;
+}
+
+static uint32_t add_with_carry(struct l61_m0* m,
+                               uint32_t a,
+                               uint32_t b,
+                               bool carry,
+                               bool set_flags) {
+  uint64_t unsigned_sum = (uint64_t)a + b + carry;
+  int64_t signed_sum = (int64_t)(int32_t)a + (int32_t)b + carry;
+  uint32_t result = (uint32_t)unsigned_sum;
+  if (set_flags) {
+    set_nz(m, result);
+    m->c = unsigned_sum >> 32;
+    m->v = (int64_t)(int32_t)result != signed_sum;
+  }
+  return result;
+}
+
+enum shift {
+  SHIFT_LSL,
+  SHIFT_LSR,
+  SHIFT_ASR,
+  SHIFT_ROR,
+};
+
+// Shift `value` by `amount` and set the carry flag like the register forms
+// of the shift instructions do
+static uint32_t shift_c(struct l61_m0* m,
+                        enum shift type,
+                        uint32_t value,
+                        uint32_t amount) {
+  if (amount == 0)
+    return value;
+  switch (type) {
+    case SHIFT_LSL:
+      if (amount > 32) {
+        m->c = false;
+        return 0;
+      }
+      m->c = (value >> (32 - amount)) & 1;
+      return amount == 32 ? 0 : value << amount;
+    case SHIFT_LSR:
+      if (amount > 32) {
+        m->c = false;
+        return 0;
+      }
+      m->c = (value >> (amount - 1)) & 1;
+      return amount == 32 ? 0 : value >> amount;
+    case SHIFT_ASR:
+      if (amount >= 32) {
+        m->c = value >> 31;
+        return value >> 31 ? 0xffffffffu : 0;
+      }
+      m->c = (value >> (amount - 1)) & 1;
+      return (uint32_t)((int32_t)value >> amount);
+    case SHIFT_ROR:
+      amount %= 32;
+      if (amount != 0)
+        value = value >> amount | value << (32 - amount);
+      m->c = value >> 31;
+      return value;
+  }
+  return value;
+}
+
+static bool condition_passed(struct l61_m0* m, uint32_t cond) {
+  switch (cond) {
+    case 0x0:
+      return m->z;
+    case 0x1:
+      return !m->z;
+    case 0x2:
+      return m->c;
+    case 0x3:
+      return !m->c;
+    case 0x4:
+      return m->n;
+    case 0x5:
+      return !m->n;
+    case 0x6:
+      return m->v;
+    case 0x7:
+      return !m->v;
+    case 0x8:
+      return m->c && !m->z;
+    case 0x9:
+      return !m->c || m->z;
+    case 0xa:
+      return m->n == m->v;
+    case 0xb:
+      return m->n != m->v;
+    case 0xc:
+      return !m->z && m->n == m->v;
+    case 0xd:
+      return m->z || m->n != m->v;
+  }
+  return true;
+}
+
+static uint32_t sign_extend(uint32_t value, uint32_t bits) {
+  uint32_t sign = 1u << (bits - 1);
+  return (value ^ sign) - sign;
+}
+
+// Branch to `target`, which must have its Thumb bit set
+static void bx_write_pc(struct l61_m0* m, uint32_t target) {
+  if (!(target & 1)) {
+    fault(m, "branch to ARM state");
+    return;
+  }
+  m->r[L61_M0_PC] = target & ~1u;
+}
+
+static void semihosting(struct l61_m0* m) {
+  uint32_t op = m->r[0];
+  uint32_t arg = m->r[1];
+  switch (op) {
+    case SYS_WRITEC: {
+      char c = (char)load(m, arg, 1);
+      if (m->write)
+        m->write(&c, 1);
+      return;
+    }
+    case SYS_WRITE0:
+      for (char c; !m->stopped && (c = (char)load(m, arg, 1)) != '\0'; ++arg) {
+        if (m->write)
+          m->write(&c, 1);
+      }
+      return;
+    case SYS_WRITE: {
+      uint32_t data = load(m, arg + 4, 4);
+      uint32_t len = load(m, arg + 8, 4);
+      if (!in_memory(m, data, len)) {
+        fault(m, "SYS_WRITE outside of memory");
+        return;
+      }
+      if (m->write)
+        m->write((const char*)&m->mem[data - m->base], len);
+      m->r[0] = 0;
+      return;
+    }
+    case SYS_EXIT:
+      m->stopped = true;
+      m->exit_status = arg == ADP_STOPPED_APPLICATION_EXIT ? 0 : 1;
+      return;
+    case SYS_EXIT_EXTENDED: {
+      uint32_t reason = load(m, arg, 4);
+      uint32_t code = load(m, arg + 4, 4);
+      m->stopped = true;
+      m->exit_status =
+          reason == ADP_STOPPED_APPLICATION_EXIT ? (int)code : 1;
+      return;
+    }
+  }
+  fault(m, "unsupported semihosting call");
+}
+
+// Shift (immediate), add, subtract, move and compare
+static void shift_add_sub_mov_cmp(struct l61_m0* m, uint16_t op) {
+  uint32_t* r = m->r;
+  uint32_t rd = op & 7;
+  uint32_t rm = (op >> 3) & 7;
+  uint32_t imm5 = (op >> 6) & 0x1f;
+  uint32_t rdn8 = (op >> 8) & 7;
+  uint32_t imm8 = op & 0xff;
+
+  switch ((op >> 11) & 7) {
+    case 0:
+      // MOVS when the shift is 0
+      r[rd] = shift_c(m, SHIFT_LSL, r[rm], imm5);
+      set_nz(m, r[rd]);
+      return;
+    case 1:
+      r[rd] = shift_c(m, SHIFT_LSR, r[rm], imm5 ? imm5 : 32);
+      set_nz(m, r[rd]);
+      return;
+    case 2:
+      r[rd] = shift_c(m, SHIFT_ASR, r[rm], imm5 ? imm5 : 32);
+      set_nz(m, r[rd]);
+      return;
+    case 3: {
+      uint32_t operand = op & 0x400 ? (op >> 6) & 7 : r[(op >> 6) & 7];
+      if (op & 0x200)
+        r[rd] = add_with_carry(m, r[rm], ~operand, true, true);
+      else
+        r[rd] = add_with_carry(m, r[rm], operand, false, true);
+      return;
+    }
+    case 4:
+      r[rdn8] = imm8;
+      set_nz(m, imm8);
+      return;
+    case 5:
+      add_with_carry(m, r[rdn8], ~imm8, true, true);
+      return;
+    case 6:
+      r[rdn8] = add_with_carry(m, r[rdn8], imm8, false, true);
+      return;
+    case 7:
+      r[rdn8] = add_with_carry(m, r[rdn8], ~imm8, true, true);
+      return;
+  }
+}
+
+static void data_processing(struct l61_m0* m, uint16_t op) {
+  uint32_t* r = m->r;
+  uint32_t rdn = op & 7;
+  uint32_t rm = (op >> 3) & 7;
+  uint32_t result;
+
+  switch ((op >> 6) & 0xf) {
+    case 0x0:
+      r[rdn] &= r[rm];
+      set_nz(m, r[rdn]);
+      return;
+    case 0x1:
+      r[rdn] ^= r[rm];
+      set_nz(m, r[rdn]);
+      return;
+    case 0x2:
+      r[rdn] = shift_c(m, SHIFT_LSL, r[rdn], r[rm] & 0xff);
+      set_nz(m, r[rdn]);
+      return;
+    case 0x3:
+      r[rdn] = shift_c(m, SHIFT_LSR, r[rdn], r[rm] & 0xff);
+      set_nz(m, r[rdn]);
+      return;
+    case 0x4:
+      r[rdn] = shift_c(m, SHIFT_ASR, r[rdn], r[rm] & 0xff);
+      set_nz(m, r[rdn]);
+      return;
+    case 0x5:
+      r[rdn] = add_with_carry(m, r[rdn], r[rm], m->c, true);
+      return;
+    case 0x6:
+      r[rdn] = add_with_carry(m, r[rdn], ~r[rm], m->c, true);
+      return;
+    case 0x7:
+      r[rdn] = shift_c(m, SHIFT_ROR, r[rdn], r[rm] & 0xff);
+      set_nz(m, r[rdn]);
+      return;
+    case 0x8:
+      set_nz(m, r[rdn] & r[rm]);
+      return;
+    case 0x9:
+      // RSBS Rd, Rn, #0
+      r[rdn] = add_with_carry(m, ~r[rm], 0, true, true);
+      return;
+    case 0xa:
+      add_with_carry(m, r[rdn], ~r[rm], true, true);
+      return;
+    case 0xb:
+      add_with_carry(m, r[rdn], r[rm], false, true);
+      return;
+    case 0xc:
+      r[rdn] |= r[rm];
+      set_nz(m, r[rdn]);
+      return;
+    case 0xd:
+      // The RP2040 has the single cycle multiplier
+      result = r[rdn] * r[rm];
+      r[rdn] = result;
+      set_nz(m, result);
+      return;
+    case 0xe:
+      r[rdn] &= ~r[rm];
+      set_nz(m, r[rdn]);
+      return;
+    case 0xf:
+      r[rdn] = ~r[rm];
+      set_nz(m, r[rdn]);
+      return;
+  }
+}
+
+// Register value as an operand, the PC reading as the instruction plus 4
+static uint32_t operand(struct l61_m0* m, uint32_t reg, uint32_t pc) {
+  return reg == L61_M0_PC ? pc + 4 : m->r[reg];
+}
+
+static void special_data_branch(struct l61_m0* m, uint16_t op, uint32_t pc) {
+  uint32_t rdn = (op & 7) | ((op >> 4) & 8);
+  uint32_t rm = (op >> 3) & 0xf;
+
+  switch ((op >> 8) & 3) {
+    case 0: {
+      uint32_t result = operand(m, rdn, pc) + operand(m, rm, pc);
+      if (rdn == L61_M0_PC) {
+        m->r[L61_M0_PC] = result & ~1u;
+        m->cycles++;
+      } else {
+        m->r[rdn] = result;
+      }
+      return;
+    }
+    case 1:
+      add_with_carry(m, operand(m, rdn, pc), ~operand(m, rm, pc), true, true);
+      return;
+    case 2: {
+      uint32_t value = operand(m, rm, pc);
+      if (rdn == L61_M0_PC) {
+        m->r[L61_M0_PC] = value & ~1u;
+        m->cycles++;
+      } else {
+        m->r[rdn] = value;
+      }
+      return;
+    }
+    case 3: {
+      uint32_t target = operand(m, rm, pc);
+      if (op & 0x80)
+        m->r[L61_M0_LR] = (pc + 2) | 1;
+      m->cycles++;
+      bx_write_pc(m, target);
+      return;
+    }
+  }
+}
+
+static void load_store(struct l61_m0* m, uint16_t op) {
+  uint32_t* r = m->r;
+  uint32_t rt = op & 7;
+  uint32_t rn = (op >> 3) & 7;
+  uint32_t imm5 = (op >> 6) & 0x1f;
+  m->cycles++;
+
+  if ((op >> 12) == 0x5) {
+    uint32_t addr = r[rn] + r[(op >> 6) & 7];
+    switch ((op >> 9) & 7) {
+      case 0:
+        store(m, addr, 4, r[rt]);
+        return;
+      case 1:
+        store(m, addr, 2, r[rt]);
+        return;
+      case 2:
+        store(m, addr, 1, r[rt]);
+        return;
+      case 3:
+        r[rt] = sign_extend(load(m, addr, 1), 8);
+        return;
+      case 4:
+        r[rt] = load(m, addr, 4);
+        return;
+      case 5:
+        r[rt] = load(m, addr, 2);
+        return;
+      case 6:
+        r[rt] = load(m, addr, 1);
+        return;
+      case 7:
+        r[rt] = sign_extend(load(m, addr, 2), 16);
+        return;
+    }
+  }
+
+  bool is_load = op & 0x800;
+  uint32_t addr;
+  uint32_t len;
+  switch (op >> 12) {
+    case 0x6:
+      addr = r[rn] + imm5 * 4;
+      len = 4;
+      break;
+    case 0x7:
+      addr = r[rn] + imm5;
+      len = 1;
+      break;
+    case 0x8:
+      addr = r[rn] + imm5 * 2;
+      len = 2;
+      break;
+    default:
+      // SP relative
+      rt = (op >> 8) & 7;
+      addr = r[L61_M0_SP] + (op & 0xff) * 4;
+      len = 4;
+      break;
+  }
+  if (is_load)
+    r[rt] = load(m, addr, len);
+  else
+    store(m, addr, len, r[rt]);
+}
+
+static void push_pop(struct l61_m0* m, uint16_t op) {
+  uint32_t list = op & 0xff;
+  bool extra = op & 0x100;
+  uint32_t count = __builtin_popcount(list) + extra;
+  m->cycles += count;
+
+  if (!(op & 0x800)) {
+    uint32_t addr = m->r[L61_M0_SP] - 4 * count;
+    m->r[L61_M0_SP] = addr;
+    for (uint32_t i = 0; i < 8; ++i) {
+      if (list & (1u << i)) {
+        store(m, addr, 4, m->r[i]);
+        addr += 4;
+      }
+    }
+    if (extra)
+      store(m, addr, 4, m->r[L61_M0_LR]);
+    return;
+  }
+
+  uint32_t addr = m->r[L61_M0_SP];
+  m->r[L61_M0_SP] = addr + 4 * count;
+  for (uint32_t i = 0; i < 8; ++i) {
+    if (list & (1u << i)) {
+      m->r[i] = load(m, addr, 4);
+      addr += 4;
+    }
+  }
+  if (extra) {
+    m->cycles += 2;
+    bx_write_pc(m, load(m, addr, 4));
+  }
+}
+
+static void misc(struct l61_m0* m, uint16_t op) {
+  uint32_t* r = m->r;
+  uint32_t rd = op & 7;
+  uint32_t rm = (op >> 3) & 7;
+
+  if ((op & 0xff00) == 0xb000) {
+    uint32_t imm = (op & 0x7f) * 4;
+    r[L61_M0_SP] += op & 0x80 ? -imm : imm;
+  } else if ((op & 0xff00) == 0xb200) {
+    switch ((op >> 6) & 3) {
+      case 0:
+        r[rd] = sign_extend(r[rm] & 0xffff, 16);
+        break;
+      case 1:
+        r[rd] = sign_extend(r[rm] & 0xff, 8);
+        break;
+      case 2:
+        r[rd] = r[rm] & 0xffff;
+        break;
+      case 3:
+        r[rd] = r[rm] & 0xff;
+        break;
+    }
+  } else if ((op & 0xf600) == 0xb400) {
+    push_pop(m, op);
+  } else if ((op & 0xffe8) == 0xb660) {
+    // CPS: there are no interrupts to mask
+  } else if ((op & 0xff00) == 0xba00 && ((op >> 6) & 3) != 2) {
+    uint32_t v = r[rm];
+    switch ((op >> 6) & 3) {
+      case 0:
+        r[rd] = __builtin_bswap32(v);
+        break;
+      case 1:
+        r[rd] = (v & 0xff00ff00u) >> 8 | (v & 0x00ff00ffu) << 8;
+        break;
+      case 3:
+        r[rd] = sign_extend(((v & 0xff) << 8) | ((v >> 8) & 0xff), 16);
+        break;
+    }
+  } else if ((op & 0xff00) == 0xbe00) {
+    if ((op & 0xff) == BKPT_SEMIHOSTING)
+      semihosting(m);
+    else
+      fault(m, "breakpoint");
+  } else if ((op & 0xff0f) == 0xbf00 && (op & 0xf0) <= 0x40) {
+    // NOP, YIELD, WFE, WFI and SEV: nothing else runs
+  } else {
+    fault(m, "undefined instruction");
+  }
+}
+
+static void load_store_multiple(struct l61_m0* m, uint16_t op) {
+  uint32_t rn = (op >> 8) & 7;
+  uint32_t list = op & 0xff;
+  uint32_t addr = m->r[rn];
+  m->cycles += __builtin_popcount(list);
+  if (list == 0) {
+    fault(m, "empty register list");
+    return;
+  }
+
+  bool is_load = op & 0x800;
+  for (uint32_t i = 0; i < 8; ++i) {
+    if (!(list & (1u << i)))
+      continue;
+    if (is_load)
+      m->r[i] = load(m, addr, 4);
+    else
+      store(m, addr, 4, m->r[i]);
+    addr += 4;
+  }
+  // LDM does not write back a base register it loaded
+  if (!is_load || !(list & (1u << rn)))
+    m->r[rn] = addr;
+}
+
+static void branch_32(struct l61_m0* m,
+                      uint16_t op,
+                      uint16_t op2,
+                      uint32_t pc) {
+  if ((op2 & 0xd000) == 0xd000) {
+    // BL
+    uint32_t s = (op >> 10) & 1;
+    uint32_t i1 = !(((op2 >> 13) & 1) ^ s);
+    uint32_t i2 = !(((op2 >> 11) & 1) ^ s);
+    uint32_t imm = s << 24 | i1 << 23 | i2 << 22 | (op & 0x3ff) << 12 |
+                   (op2 & 0x7ff) << 1;
+    m->r[L61_M0_LR] = (pc + 4) | 1;
+    m->r[L61_M0_PC] = pc + 4 + sign_extend(imm, 25);
+    m->cycles += 2;
+    return;
+  }
+
+  m->cycles += 2;
+  if ((op & 0xfff0) == 0xf380 && (op2 & 0xff00) == 0x8800) {
+    // MSR: the APSR flags, the stack pointers and PRIMASK
+    uint32_t value = m->r[op & 0xf];
+    switch (op2 & 0xff) {
+      case 0x00:
+        m->n = value >> 31;
+        m->z = (value >> 30) & 1;
+        m->c = (value >> 29) & 1;
+        m->v = (value >> 28) & 1;
+        return;
+      case 0x08:
+      case 0x09:
+        m->r[L61_M0_SP] = value & ~3u;
+        return;
+      case 0x10:
+        return;
+    }
+  } else if (op == 0xf3ef && (op2 & 0xf000) == 0x8000) {
+    // MRS
+    uint32_t rd = (op2 >> 8) & 0xf;
+    switch (op2 & 0xff) {
+      case 0x00:
+        m->r[rd] = (uint32_t)m->n << 31 | (uint32_t)m->z << 30 |
+                   (uint32_t)m->c << 29 | (uint32_t)m->v << 28;
+        return;
+      case 0x08:
+      case 0x09:
+        m->r[rd] = m->r[L61_M0_SP];
+        return;
+      case 0x10:
+        // PRIMASK, interrupts are never disabled
+        m->r[rd] = 0;
+        return;
+    }
+  } else if (op == 0xf3bf && (op2 & 0xffc0) == 0x8f40) {
+    // DSB, DMB and ISB
+    return;
+  }
+  fault(m, "undefined instruction");
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_m0_reset(struct l61_m0* m, uint32_t entry) {
+  memset(m->r, 0, sizeof(m->r));
+  m->n = m->z = m->c = m->v = false;
+  m->cycles = 0;
+  m->systick_csr = 0;
+  m->systick_rvr = 0;
+  m->systick_cleared = 0;
+  m->stopped = false;
+  m->exit_status = 0;
+  m->fault = NULL;
+  m->r[L61_M0_SP] = (m->base + m->size) & ~7u;
+  // Returning from the entry point branches to ARM state, and faults
+  m->r[L61_M0_LR] = 0xfffffffeu;
+  m->r[L61_M0_PC] = entry & ~1u;
+}
+
+void l61_m0_step(struct l61_m0* m) {
+  uint32_t pc = m->r[L61_M0_PC];
+  m->fault_pc = pc;
+  uint16_t op = (uint16_t)load(m, pc, 2);
+  if (m->stopped)
+    return;
+  m->r[L61_M0_PC] = pc + 2;
+  m->cycles++;
+
+  switch (op >> 12) {
+    case 0x0:
+    case 0x1:
+    case 0x2:
+    case 0x3:
+      shift_add_sub_mov_cmp(m, op);
+      return;
+    case 0x4:
+      if ((op & 0xfc00) == 0x4000) {
+        data_processing(m, op);
+      } else if ((op & 0xfc00) == 0x4400) {
+        special_data_branch(m, op, pc);
+      } else {
+        // LDR (literal)
+        m->cycles++;
+        m->r[(op >> 8) & 7] = load(m, ((pc + 4) & ~3u) + (op & 0xff) * 4, 4);
+      }
+      return;
+    case 0x5:
+    case 0x6:
+    case 0x7:
+    case 0x8:
+    case 0x9:
+      load_store(m, op);
+      return;
+    case 0xa:
+      // ADR and ADD (SP plus immediate)
+      m->r[(op >> 8) & 7] =
+          (op & 0x800 ? m->r[L61_M0_SP] : (pc + 4) & ~3u) + (op & 0xff) * 4;
+      return;
+    case 0xb:
+      misc(m, op);
+      return;
+    case 0xc:
+      load_store_multiple(m, op);
+      return;
+    case 0xd: {
+      uint32_t cond = (op >> 8) & 0xf;
+      if (cond >= 0xe) {
+        fault(m, cond == 0xe ? "undefined instruction" : "supervisor call");
+      } else if (condition_passed(m, cond)) {
+        m->r[L61_M0_PC] = pc + 4 + sign_extend((op & 0xff) << 1, 9);
+        m->cycles++;
+      }
+      return;
+    }
+    case 0xe:
+      if (op & 0x800) {
+        fault(m, "undefined instruction");
+        return;
+      }
+      m->r[L61_M0_PC] = pc + 4 + sign_extend((op & 0x7ff) << 1, 12);
+      m->cycles++;
+      return;
+    case 0xf: {
+      uint16_t op2 = (uint16_t)load(m, pc + 2, 2);
+      m->r[L61_M0_PC] = pc + 4;
+      if ((op & 0xf800) == 0xf000 && (op2 & 0x8000))
+        branch_32(m, op, op2, pc);
+      else
+        fault(m, "undefined instruction");
+      return;
+    }
+  }
+}
+
+bool l61_m0_run(struct l61_m0* m, uint64_t max_cycles) {
+  while (!m->stopped && m->cycles < max_cycles)
+    l61_m0_step(m);
+  return m->stopped && m->fault == NULL;
+}
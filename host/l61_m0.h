@@ -0,0 +1,77 @@
+/*
+** file: l61_m0.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Instruction set simulator of the RP2040's Cortex-M0+ core, counting
+** cycles, to measure the key path of the firmware without a board.
+**
+** It runs the ARMv6-M Thumb instructions with the cycle counts of the
+** Cortex-M0+ technical reference manual: one cycle for most instructions,
+** two for loads, stores and taken branches, three for BL, 1 + N for the
+** loads and stores of N registers, 3 + N for a POP into the PC. Memory has
+** no wait states, as the SRAM the hot path runs from with
+** L61_HOT_PATH_IN_RAM. There is no XIP cache, no bus contention with the
+** other core or the DMA, and no interrupt.
+**
+** The memory is one block holding the program's segments, with the stack
+** at its end. The only peripheral is SysTick, counting down at the
+** processor clock as lard61_cycles.c sets it up. Output and exit go
+** through the semihosting calls SYS_WRITEC, SYS_WRITE0, SYS_WRITE,
+** SYS_EXIT and SYS_EXIT_EXTENDED, made with BKPT 0xab.
+**
+** Any other access, an unaligned one, an undefined instruction or a
+** branch to ARM state stops the simulation with a fault.
+*/
+
+#ifndef _L61_M0_H
+#define _L61_M0_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define L61_M0_SP 13
+#define L61_M0_LR 14
+#define L61_M0_PC 15
+
+struct l61_m0 {
+  uint32_t r[16];
+  // APSR flags
+  bool n, z, c, v;
+  uint64_t cycles;
+
+  // Memory from `base` to `base + size`
+  uint8_t* mem;
+  uint32_t base;
+  uint32_t size;
+
+  // SysTick registers, and cycle of the last write to its current value
+  uint32_t systick_csr;
+  uint32_t systick_rvr;
+  uint64_t systick_cleared;
+
+  // Called with the characters written through semihosting
+  void (*write)(const char* data, size_t len);
+
+  // Set once the program exited, or stopped on a fault
+  bool stopped;
+  int exit_status;
+  const char* fault;
+  uint32_t fault_pc;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Reset the core to run from `entry` with the stack at the end of memory.
+// The memory must already be allocated and loaded.
+void l61_m0_reset(struct l61_m0* m, uint32_t entry);
+// Execute one instruction
+void l61_m0_step(struct l61_m0* m);
+// Execute until the program exits or faults, or `max_cycles` elapse.
+// Return false if it did not exit.
+bool l61_m0_run(struct l61_m0* m, uint64_t max_cycles);
+
+#endif /* _L61_M0_H */
@@ -0,0 +1,290 @@
+/*
+** file: l61_replay.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Replay a key event capture (see lard61_capture.h) through the firmware's
+** debounce and report code.
+**
+** The debouncer is restored from the capture's checkpoint, then scanned at
+** every captured time: the captured raw events are applied before the scan
+** at their time, and quiet scan words and debounced events only mark that
+** a scan happened. Settings words change the debounce mode and window
+** override before the scan of the event following them. Scans the capture
+** does not mention could not change the debouncer state, so the debounced
+** events produced must be exactly the captured ones, at the same times.
+** The exit status is 0 if they are, so a capture of a field bug can be
+** kept and replayed as a regression check after changing the debounce
+** code.
+**
+** Usage: l61_replay [-v] capture.bin
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "l61_host.h"
+#include "lard61_capture.h"
+#include "lard61_debounce.h"
+#include "lard61_keymap.h"
+#include "lard61_report.h"
+
+#define KEY_COUNT L61_DEBOUNCE_KEY_COUNT
+
+enum event_type {
+  EVENT_RAW,
+  EVENT_DEBOUNCED,
+  EVENT_SCAN,
+  EVENT_SETTINGS,
+};
+
+struct event {
+  uint64_t time_us;
+  enum event_type type;
+  uint8_t key;
+  bool state;
+  // Of settings events
+  enum l61_debounce_mode mode;
+  uint16_t window_us;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static bool verbose = false;
+
+// Raw key states fed to the debouncer
+static bool raw[KEY_COUNT];
+
+// Debounced events from the capture, and the next one to match
+static struct event* expected = NULL;
+static size_t expected_count = 0;
+static size_t expected_next = 0;
+
+static uint64_t start_us = 0;
+static uint32_t matched = 0;
+static uint32_t mismatches = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static const char* state_name(bool state) {
+  return state ? "down" : "up";
+}
+
+static void print_report() {
+  struct l61_report report;
+  l61_report_build(&report, sizeof(report.keycode));
+  printf("    report:");
+  for (uint i = 0; i < report.key_count; ++i)
+    printf(" %02x", report.keycode[i]);
+  if (report.consumer)
+    printf(" consumer %03x", report.consumer);
+  if (report.system)
+    printf(" system %x", report.system);
+  if (report.mouse)
+    printf(" mouse %03x", report.mouse);
+  printf("\n");
+}
+
+// Compare a debounced event produced by the replay with the next captured
+// one
+static void check_event(uint64_t time_us, uint key, bool state) {
+  double ms = (double)(time_us - start_us) / 1000.0;
+  if (verbose)
+    printf("%12.3f ms  key %2u %s\n", ms, key, state_name(state));
+
+  if (expected_next >= expected_count) {
+    printf("%12.3f ms  key %2u %s: not in the capture\n", ms, key,
+           state_name(state));
+    mismatches++;
+    return;
+  }
+
+  const struct event* e = &expected[expected_next++];
+  if (e->key != key || e->state != state) {
+    printf("%12.3f ms  key %2u %s: capture has key %2u %s\n", ms, key,
+           state_name(state), e->key, state_name(e->state));
+    mismatches++;
+  } else if (e->time_us != time_us) {
+    printf("%12.3f ms  key %2u %s: %+lld us from the capture\n", ms, key,
+           state_name(state), (long long)(time_us - e->time_us));
+    mismatches++;
+  } else {
+    matched++;
+  }
+}
+
+// Run one scan at `time_us` and check the debounced events it produces
+static void scan(uint64_t time_us) {
+  bool before[KEY_COUNT];
+  memcpy(before, l61_host_pressed, sizeof(before));
+
+  // The firmware clock is 32 bits, like the times the debouncer keeps
+  l61_host_set_time_us(time_us);
+  if (!l61_debounce_update(raw, l61_host_pressed, (uint32_t)time_us))
+    return;
+
+  for (uint i = 0; i < KEY_COUNT; ++i) {
+    if (before[i] != l61_host_pressed[i])
+      check_event(time_us, i, l61_host_pressed[i]);
+  }
+  if (verbose)
+    print_report();
+}
+
+static uint8_t* read_file(const char* path, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  *size = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t* data = malloc(*size);
+  if (data && fread(data, 1, *size, f) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+// Decode the event words into `events` with absolute times.
+// Return the number of events.
+static size_t decode(const uint32_t* words,
+                     uint32_t word_count,
+                     uint64_t base_time_us,
+                     struct event* events) {
+  size_t count = 0;
+  uint64_t time_us = base_time_us;
+  uint32_t high = 0;
+  // Settings word waiting for the time of the next event
+  const uint32_t* settings = NULL;
+  for (uint32_t i = 0; i < word_count; ++i) {
+    uint32_t word = words[i];
+    uint32_t delta = word >> L61_CAPTURE_DELTA_SHIFT;
+    uint8_t key = word & L61_CAPTURE_KEY_MASK;
+    if (key == L61_CAPTURE_KEY_TIME) {
+      high = delta;
+      continue;
+    }
+    if (key == L61_CAPTURE_KEY_SETTINGS) {
+      settings = &words[i];
+      continue;
+    }
+    time_us += ((uint64_t)high << 20) | delta;
+    high = 0;
+
+    struct event* e = NULL;
+    if (settings) {
+      e = &events[count++];
+      e->time_us = time_us;
+      e->type = EVENT_SETTINGS;
+      e->mode = *settings & L61_CAPTURE_SETTINGS_EAGER_BIT
+                    ? L61_DEBOUNCE_EAGER
+                    : L61_DEBOUNCE_DEFERRED;
+      e->window_us = *settings >> L61_CAPTURE_SETTINGS_WINDOW_SHIFT;
+      settings = NULL;
+    }
+
+    e = &events[count++];
+    e->time_us = time_us;
+    e->key = key;
+    e->state = word & L61_CAPTURE_STATE_BIT;
+    if (key == L61_CAPTURE_KEY_SCAN)
+      e->type = EVENT_SCAN;
+    else if (word & L61_CAPTURE_DEBOUNCED_BIT)
+      e->type = EVENT_DEBOUNCED;
+    else
+      e->type = EVENT_RAW;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-v") == 0)
+      verbose = true;
+    else
+      path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-v] capture.bin\n", argv[0]);
+    return 2;
+  }
+
+  size_t size = 0;
+  uint8_t* data = read_file(path, &size);
+  if (!data) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 2;
+  }
+
+  struct l61_capture_header header;
+  if (size < sizeof(header)) {
+    fprintf(stderr, "%s: too short for a capture\n", path);
+    return 2;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != L61_CAPTURE_MAGIC ||
+      header.version != L61_CAPTURE_VERSION ||
+      header.key_count != KEY_COUNT ||
+      size != sizeof(header) + header.word_count * sizeof(uint32_t)) {
+    fprintf(stderr, "%s: not a version %d capture for %d keys\n", path,
+            L61_CAPTURE_VERSION, KEY_COUNT);
+    return 2;
+  }
+
+  struct event* events = calloc(header.word_count + 1, sizeof(*events));
+  size_t event_count =
+      decode((const uint32_t*)(data + sizeof(header)), header.word_count,
+             header.base_time_us, events);
+
+  expected = calloc(event_count + 1, sizeof(*expected));
+  for (size_t i = 0; i < event_count; ++i) {
+    if (events[i].type == EVENT_DEBOUNCED)
+      expected[expected_count++] = events[i];
+  }
+
+  printf("%s: %zu events (%zu debounced), scan period %u us\n", path,
+         event_count, expected_count, header.scan_period_us);
+
+  // Continue from the checkpoint, as the firmware did
+  l61_keymap_setup();
+  l61_debounce_restore(&header.checkpoint, l61_host_pressed);
+  for (uint i = 0; i < KEY_COUNT; ++i)
+    raw[i] = header.checkpoint.key[i].raw;
+  start_us = header.base_time_us +
+             (uint32_t)(header.checkpoint_time_us - header.base_time_us);
+
+  // Events at the same time come from the same scan: apply all the raw
+  // events first, then scan once
+  for (size_t i = 0; i < event_count;) {
+    uint64_t time_us = events[i].time_us;
+    for (; i < event_count && events[i].time_us == time_us; ++i) {
+      if (events[i].type == EVENT_RAW)
+        raw[events[i].key] = events[i].state;
+      else if (events[i].type == EVENT_SETTINGS) {
+        l61_debounce_set_mode(events[i].mode);
+        l61_debounce_set_window_override(events[i].window_us);
+      }
+    }
+    scan(time_us);
+  }
+
+  size_t missing = expected_count - expected_next;
+  printf("matched %u, mismatched %u, missing %zu\n", matched, mismatches,
+         missing);
+
+  free(expected);
+  free(events);
+  free(data);
+  return mismatches == 0 && missing == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/*
+** file: l61_steno_sim.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Type random steno chords, with bouncing switches, through the firmware's
+** debounce and steno code, and measure the chord-to-packet latency: the
+** time from the last raw edge of a chord (its last key settling up) to its
+** GeminiPR packet being written to CDC. It is negative when the debouncer
+** registered the release before the switch settled, which slow scans of
+** long bounces can do.
+**
+** Every packet is also checked against the chord typed, with the expected
+** GeminiPR bit of each key listed here independently of lard61_steno.c. The
+** exit status is 0 if all packets were right.
+**
+** Usage: l61_steno_sim [-r scan_rate_hz] [-n chords] [-b bounce_us] [-s seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "l61_host.h"
+#include "lard61_debounce.h"
+#include "lard61_keymap.h"
+#include "lard61_steno.h"
+
+#define KEY_COUNT L61_DEBOUNCE_KEY_COUNT
+#define MAX_CHORD_KEYS 6
+// Raw edges of a chord: a press and a release per key, each bouncing
+#define MAX_EDGES (MAX_CHORD_KEYS * 2 * 16)
+
+struct steno_key {
+  uint8_t index;
+  uint8_t key;
+};
+
+struct edge {
+  uint64_t time_us;
+  uint8_t index;
+  bool state;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// Key matrix index and GeminiPR key of the steno layout
+static const struct steno_key layout[] = {
+    {1, L61_STENO_N1},   {2, L61_STENO_N2},   {3, L61_STENO_N3},
+    {4, L61_STENO_N4},   {5, L61_STENO_N5},   {6, L61_STENO_N6},
+    {7, L61_STENO_N7},   {8, L61_STENO_N8},   {9, L61_STENO_N9},
+    {10, L61_STENO_NA},  {11, L61_STENO_NB},  {12, L61_STENO_NC},
+    {15, L61_STENO_S1},  {16, L61_STENO_T},   {17, L61_STENO_P},
+    {18, L61_STENO_H},   {19, L61_STENO_ST1}, {20, L61_STENO_ST3},
+    {21, L61_STENO_RF},  {22, L61_STENO_RP},  {23, L61_STENO_RL},
+    {24, L61_STENO_RT},  {25, L61_STENO_RD},  {29, L61_STENO_S2},
+    {30, L61_STENO_K},   {31, L61_STENO_W},   {32, L61_STENO_R},
+    {33, L61_STENO_ST2}, {34, L61_STENO_ST4}, {35, L61_STENO_RR},
+    {36, L61_STENO_RB},  {37, L61_STENO_RG},  {38, L61_STENO_RS},
+    {39, L61_STENO_RZ},  {44, L61_STENO_A},   {45, L61_STENO_O},
+    {47, L61_STENO_RE},  {48, L61_STENO_RU},
+};
+#define LAYOUT_SIZE (sizeof(layout) / sizeof(layout[0]))
+
+static bool raw[KEY_COUNT];
+static uint64_t now_us = 0;
+
+// Last packet written, when, and how many since the chord started
+static uint8_t packet[L61_STENO_PACKET_SIZE];
+static uint32_t packet_count = 0;
+static uint64_t packet_us = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void cdc_write(const void* data, uint32_t size) {
+  if (size == L61_STENO_PACKET_SIZE)
+    memcpy(packet, data, size);
+  packet_count++;
+  packet_us = now_us;
+}
+
+static uint32_t random_us(uint32_t max) {
+  return max == 0 ? 0 : (uint32_t)rand() % max;
+}
+
+// Add the edges of a key going to `state` at `time_us`, bouncing for up to
+// `bounce_us` before settling
+static uint add_edges(struct edge* edges,
+                      uint count,
+                      uint8_t index,
+                      bool state,
+                      uint64_t time_us,
+                      uint32_t bounce_us) {
+  uint bounces = bounce_us > 0 ? (uint)random_us(7) : 0;
+  for (uint i = 0; i < bounces; ++i) {
+    edges[count++] = (struct edge){time_us, index, state};
+    time_us += 50 + random_us(bounce_us / 7);
+    edges[count++] = (struct edge){time_us, index, !state};
+    time_us += 50 + random_us(bounce_us / 7);
+  }
+  edges[count++] = (struct edge){time_us, index, state};
+  return count;
+}
+
+static int compare_edges(const void* a, const void* b) {
+  const struct edge* ea = a;
+  const struct edge* eb = b;
+  return ea->time_us < eb->time_us ? -1 : ea->time_us > eb->time_us;
+}
+
+static void scan() {
+  l61_host_set_time_us(now_us);
+  l61_debounce_update(raw, l61_host_pressed, (uint32_t)now_us);
+  l61_steno_task();
+}
+
+static int compare_latency(const void* a, const void* b) {
+  int32_t la = *(const int32_t*)a;
+  int32_t lb = *(const int32_t*)b;
+  return la < lb ? -1 : la > lb;
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  uint32_t rate_hz = 1000;
+  uint32_t chords = 1000;
+  uint32_t bounce_us = 2000;
+  uint32_t seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    uint32_t value = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+    if (strcmp(argv[i], "-r") == 0 && value > 0)
+      rate_hz = value;
+    else if (strcmp(argv[i], "-n") == 0 && value > 0)
+      chords = value;
+    else if (strcmp(argv[i], "-b") == 0)
+      bounce_us = value;
+    else if (strcmp(argv[i], "-s") == 0)
+      seed = value;
+    else {
+      fprintf(stderr,
+              "usage: %s [-r scan_rate_hz] [-n chords] [-b bounce_us] "
+              "[-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  srand(seed);
+  uint32_t period_us = 1000000 / rate_hz;
+
+  l61_keymap_setup();
+  l61_debounce_init(NULL);
+  l61_steno_set_enabled(true);
+  l61_host_cdc_write = &cdc_write;
+  now_us = 1000000;
+  scan();
+
+  int32_t* latency = calloc(chords, sizeof(*latency));
+  uint32_t received = 0;
+  uint32_t wrong = 0;
+  uint32_t missing = 0;
+
+  for (uint32_t c = 0; c < chords; ++c) {
+    // Pick distinct keys, pressed within 20 ms and held 60 to 90 ms
+    uint8_t expected[L61_STENO_PACKET_SIZE] = {L61_STENO_PACKET_START};
+    struct edge edges[MAX_EDGES];
+    uint edge_count = 0;
+    bool picked[LAYOUT_SIZE] = {false};
+    uint key_count = 1 + random_us(MAX_CHORD_KEYS);
+    uint64_t start_us = now_us;
+    for (uint k = 0; k < key_count; ++k) {
+      uint n = random_us(LAYOUT_SIZE);
+      if (picked[n])
+        continue;
+      picked[n] = true;
+      expected[layout[n].key / 7] |= 0x40 >> (layout[n].key % 7);
+      uint64_t down_us = start_us + random_us(20000);
+      uint64_t up_us = start_us + 60000 + random_us(30000);
+      edge_count = add_edges(edges, edge_count, layout[n].index, true,
+                             down_us, bounce_us);
+      edge_count = add_edges(edges, edge_count, layout[n].index, false,
+                             up_us, bounce_us);
+    }
+    qsort(edges, edge_count, sizeof(edges[0]), compare_edges);
+    uint64_t end_us = edges[edge_count - 1].time_us;
+
+    // Scan until well after the last edge
+    packet_count = 0;
+    uint e = 0;
+    while (now_us < end_us + L61_DEBOUNCE_MAX_US + 10000) {
+      now_us += period_us;
+      for (; e < edge_count && edges[e].time_us <= now_us; ++e)
+        raw[edges[e].index] = edges[e].state;
+      scan();
+    }
+
+    if (packet_count == 0) {
+      printf("chord %u: no packet\n", c);
+      missing++;
+      continue;
+    }
+    if (packet_count > 1 || memcmp(packet, expected, sizeof(packet)) != 0) {
+      printf("chord %u: %u packets, last %02x %02x %02x %02x %02x %02x, "
+             "expected %02x %02x %02x %02x %02x %02x\n",
+             c, packet_count, packet[0], packet[1], packet[2], packet[3],
+             packet[4], packet[5], expected[0], expected[1], expected[2],
+             expected[3], expected[4], expected[5]);
+      wrong++;
+      continue;
+    }
+    latency[received++] = (int32_t)(packet_us - end_us);
+  }
+
+  printf("%u chords at %u Hz, bounce up to %u us: %u right, %u wrong, "
+         "%u missing\n",
+         chords, rate_hz, bounce_us, received, wrong, missing);
+  if (received > 0) {
+    qsort(latency, received, sizeof(*latency), compare_latency);
+    int64_t total = 0;
+    for (uint32_t i = 0; i < received; ++i)
+      total += latency[i];
+    printf("latency: min %d us, mean %lld us, p99 %d us, max %d us\n",
+           latency[0], (long long)(total / received),
+           latency[received * 99 / 100], latency[received - 1]);
+  }
+
+  free(latency);
+  return wrong == 0 && missing == 0 ? 0 : 1;
+}
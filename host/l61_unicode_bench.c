@@ -0,0 +1,258 @@
+/*
+** file: l61_unicode_bench.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Type code points in each Unicode input mode through l61_hid_task, with a
+** simulated USB host polling the keyboard every frame, and measure how
+** many code points per second and reports per code point it takes.
+**
+** The keyboard reports received are decoded back into code points the way
+** each host input method reads them, independently of lard61_unicode.c,
+** and compared with the code points typed. Windows cannot type code points
+** above U+FFFF, which are left out of its run. The exit status is 0 if all
+** code points were decoded right.
+**
+** Usage: l61_unicode_bench [-n code_points] [-s seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "class/hid/hid.h"
+#include "l61_host.h"
+#include "lard61_hid.h"
+#include "lard61_keymap.h"
+#include "lard61_report.h"
+#include "lard61_unicode.h"
+
+// USB full speed frame, the polling interval of the HID endpoint
+#define FRAME_US 1000
+#define MAX_DIGITS 8
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static const char* const mode_names[L61_UNICODE_MODE_COUNT] = {
+    [L61_UNICODE_LINUX] = "linux",
+    [L61_UNICODE_MACOS] = "macos",
+    [L61_UNICODE_WINDOWS] = "windows",
+    [L61_UNICODE_WINCOMPOSE] = "wincompose",
+};
+
+static enum l61_unicode_mode mode;
+
+// Keys of the previous keyboard report
+static uint8_t previous[6];
+
+// Hex digits typed since the start of the current sequence
+static char digits[MAX_DIGITS * 2 + 1];
+static uint digit_count = 0;
+static bool in_sequence = false;
+
+static uint32_t* decoded;
+static uint32_t decoded_count = 0;
+static uint32_t reports = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static bool has_key(const uint8_t* keys, uint8_t key) {
+  for (uint i = 0; i < 6; ++i) {
+    if (keys[i] == key)
+      return true;
+  }
+  return false;
+}
+
+// Hex digit of a key, or -1
+static int key_digit(uint8_t key) {
+  if (key >= HID_KEY_A && key <= HID_KEY_F)
+    return 10 + key - HID_KEY_A;
+  if (key == HID_KEY_0 || key == HID_KEY_KEYPAD_0)
+    return 0;
+  if (key >= HID_KEY_1 && key <= HID_KEY_9)
+    return 1 + key - HID_KEY_1;
+  if (key >= HID_KEY_KEYPAD_1 && key <= HID_KEY_KEYPAD_9)
+    return 1 + key - HID_KEY_KEYPAD_1;
+  return -1;
+}
+
+static void start_sequence() {
+  in_sequence = true;
+  digit_count = 0;
+}
+
+static void end_sequence() {
+  if (!in_sequence)
+    return;
+  in_sequence = false;
+  digits[digit_count] = '\0';
+  uint32_t value = (uint32_t)strtoul(digits, NULL, 16);
+  if (mode == L61_UNICODE_MACOS && digit_count == 8) {
+    // UTF-16 surrogate pair
+    value = 0x10000 + (((value >> 16) - 0xd800) << 10) +
+            ((value & 0xffff) - 0xdc00);
+  }
+  decoded[decoded_count++] = value;
+}
+
+// Follow the key presses and releases like the host input method
+static void keyboard_report(const uint8_t* keys) {
+  bool alt = has_key(keys, HID_KEY_ALT_LEFT);
+  for (uint i = 0; i < 6; ++i) {
+    uint8_t key = keys[i];
+    if (key == HID_KEY_NONE || has_key(previous, key))
+      continue;
+
+    int digit = key_digit(key);
+    if (in_sequence && digit >= 0 && digit_count < MAX_DIGITS * 2) {
+      digits[digit_count++] = "0123456789abcdef"[digit];
+      continue;
+    }
+    switch (mode) {
+      case L61_UNICODE_LINUX:
+        if (key == HID_KEY_U && has_key(keys, HID_KEY_CONTROL_LEFT) &&
+            has_key(keys, HID_KEY_SHIFT_LEFT))
+          start_sequence();
+        else if (key == HID_KEY_SPACE)
+          end_sequence();
+        break;
+      case L61_UNICODE_MACOS:
+        if (key == HID_KEY_ALT_LEFT)
+          start_sequence();
+        break;
+      case L61_UNICODE_WINDOWS:
+        if (key == HID_KEY_KEYPAD_ADD && alt)
+          start_sequence();
+        break;
+      case L61_UNICODE_WINCOMPOSE:
+        if (key == HID_KEY_U && !in_sequence)
+          start_sequence();
+        else if (key == HID_KEY_ENTER)
+          end_sequence();
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Releasing Alt ends the sequence on macOS and Windows
+  if ((mode == L61_UNICODE_MACOS || mode == L61_UNICODE_WINDOWS) && !alt &&
+      has_key(previous, HID_KEY_ALT_LEFT))
+    end_sequence();
+  memcpy(previous, keys, sizeof(previous));
+}
+
+static void hid_report(uint8_t instance,
+                       uint8_t report_id,
+                       const uint8_t* data,
+                       uint16_t len) {
+  if (instance == L61_HID_KEYBOARD && report_id == L61_REPORT_ID_KEYBOARD &&
+      len == 8) {
+    reports++;
+    keyboard_report(&data[2]);
+  }
+}
+
+static uint32_t random_code_point() {
+  for (;;) {
+    uint32_t code_point;
+    switch (rand() % 4) {
+      case 0:
+        code_point = l61_unicode_code_point(rand() % L61_UC_COUNT);
+        break;
+      case 1:
+        code_point = 0x80 + rand() % 0x780;
+        break;
+      case 2:
+        code_point = 0x800 + rand() % 0xf800;
+        break;
+      default:
+        code_point = 0x10000 + rand() % 0x100000;
+        break;
+    }
+    if (code_point < 0xd800 || code_point > 0xdfff)
+      return code_point;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  uint32_t count = 1000;
+  uint32_t seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    uint32_t value = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+    if (strcmp(argv[i], "-n") == 0 && value > 0)
+      count = value;
+    else if (strcmp(argv[i], "-s") == 0)
+      seed = value;
+    else {
+      fprintf(stderr, "usage: %s [-n code_points] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  uint32_t* typed = calloc(count, sizeof(*typed));
+  decoded = calloc(count, sizeof(*decoded));
+  l61_keymap_setup();
+  l61_host_hid_report = &hid_report;
+  uint64_t now_us = 1000000;
+  uint32_t failed = 0;
+
+  for (uint m = 0; m < L61_UNICODE_MODE_COUNT; ++m) {
+    mode = m;
+    l61_unicode_set_mode(mode);
+    srand(seed);
+    for (uint32_t i = 0; i < count; ++i) {
+      do {
+        typed[i] = random_code_point();
+      } while (mode == L61_UNICODE_WINDOWS && typed[i] > 0xffff);
+    }
+
+    decoded_count = 0;
+    reports = 0;
+    in_sequence = false;
+    memset(previous, 0, sizeof(previous));
+
+    // Keep the queue topped up, like a stream of keys typed faster than
+    // they can be sent
+    uint64_t start_us = now_us;
+    uint32_t queued = 0;
+    uint32_t frames = 0;
+    while (decoded_count < count && frames < count * 64) {
+      while (queued < count && l61_unicode_type(typed[queued]))
+        queued++;
+      l61_host_set_time_us(now_us);
+      l61_hid_task();
+      now_us += FRAME_US;
+      l61_host_hid_poll();
+      frames++;
+    }
+
+    uint32_t wrong = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (i >= decoded_count || decoded[i] != typed[i]) {
+        if (wrong++ < 5)
+          printf("%s: code point %u: typed U+%04X, decoded U+%04X\n",
+                 mode_names[mode], i, typed[i],
+                 i < decoded_count ? decoded[i] : 0);
+      }
+    }
+    double seconds = (double)(now_us - start_us) / 1e6;
+    printf("%-10s %u code points: %u wrong, %.0f code points/s, "
+           "%.1f reports per code point\n",
+           mode_names[mode], count, wrong, count / seconds,
+           (double)reports / count);
+    failed += wrong;
+  }
+
+  free(typed);
+  free(decoded);
+  return failed == 0 ? 0 : 1;
+}
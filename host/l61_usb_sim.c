@@ -0,0 +1,881 @@
+/*
+** file: l61_usb_sim.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** A virtual USB host for the firmware, to catch USB mistakes without
+** plugging the keyboard in. The firmware's descriptors and callbacks run
+** under the real TinyUSB device stack and its HID and CDC drivers, on the
+** simulated device controller of l61_dcd.c, and the host talks to them
+** with USB transfers only:
+** - enumeration: the device is reset and addressed, its device,
+**   configuration, string and HID report descriptors are read with
+**   GET_DESCRIPTOR and checked: lengths, interface and endpoint numbers,
+**   polling intervals, the size of each report ID. SET_CONFIGURATION must
+**   mount the device and open every endpoint of the configuration,
+** - SET_REPORT of the keyboard LEDs, with and without report ID, and
+**   SET_PROTOCOL: in boot protocol, keyboard reports must be plain 8-byte
+**   reports with the modifiers in their own byte, and nothing else may be
+**   sent on the keyboard endpoint,
+** - report timing: keyboard, consumer and system keys are pressed while
+**   the host polls the HID endpoints every frame. The frame in which each
+**   report leaves is printed with its delay, showing how long reports wait
+**   for the keyboard endpoint, which the three report types share,
+** - CDC: steno chords must not be sent before a terminal opens the port
+**   with SET_LINE_CODING and SET_CONTROL_LINE_STATE, nor after it closes
+**   it. While it is open, chords filling more than one packet must arrive
+**   whole and in order, and data sent by the host over several packets
+**   must be read back whole by tud_cdc_read.
+**
+** Every report received is also checked against the report descriptor.
+** The exit status is 0 if no check failed.
+**
+** Usage: l61_usb_sim [-v]
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "l61_dcd.h"
+#include "l61_host.h"
+#include "lard61_hid.h"
+#include "lard61_keymap.h"
+#include "lard61_led.h"
+#include "lard61_steno.h"
+#include "tusb.h"
+
+// USB full speed frame, the polling interval of the HID endpoints
+#define FRAME_US 1000
+#define MAX_HID 4
+#define MAX_REPORTS 256
+// Full speed interrupt endpoints carry at most 64 bytes per transaction
+#define FS_MAX_PACKET 64
+#define MAX_CONFIG_SIZE 512
+#define MAX_REPORT_DESC_SIZE 512
+#define DEVICE_ADDRESS 5
+
+// bmRequestType of the requests sent
+#define REQ_DEVICE_IN 0x80
+#define REQ_DEVICE_OUT 0x00
+#define REQ_INTERFACE_IN 0x81
+#define REQ_CLASS_INTERFACE_OUT 0x21
+
+// CDC_REQUEST_SET_CONTROL_LINE_STATE bits
+#define LINE_STATE_DTR 0x01
+#define LINE_STATE_RTS 0x02
+
+// Steno chords typed while the port is open, more than a packet's worth
+#define CDC_CHORDS 12
+// Bytes sent by the host to the CDC interface
+#define CDC_TEXT_SIZE 150
+#define CDC_RECEIVED_SIZE 256
+
+// Key matrix indices used by the scripts, see lard61_keymap_default.cpp
+#define KEY_W 16
+#define KEY_BACKSLASH 27
+#define KEY_A 29
+#define KEY_SHIFT_LEFT 41
+#define KEY_M 48
+
+struct hid_itf {
+  uint8_t number;
+  uint8_t subclass;
+  uint8_t protocol;
+  uint8_t ep_in;
+  uint16_t ep_size;
+  uint8_t interval;
+  uint16_t report_desc_len;
+  bool uses_ids;
+  // Protocol set by the host, HID_PROTOCOL_BOOT or HID_PROTOCOL_REPORT
+  uint8_t mode;
+  // Size of the input and output report of each report ID, in bits
+  uint32_t input_bits[256];
+  uint32_t output_bits[256];
+};
+
+struct cdc_itf {
+  // Communication interface, which receives the class requests
+  uint8_t number;
+  // Endpoints of the data interface
+  uint8_t ep_in;
+  uint8_t ep_out;
+  uint16_t ep_size;
+};
+
+struct report {
+  uint frame;
+  uint8_t instance;
+  uint8_t report_id;
+  uint8_t data[8];
+  uint16_t len;
+};
+
+// Debounced key changes, at a frame
+struct step {
+  uint frame;
+  uint8_t key;
+  bool pressed;
+};
+
+struct steno_key {
+  uint8_t index;
+  uint8_t key;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static bool verbose = false;
+static uint failures = 0;
+
+static struct hid_itf hid[MAX_HID];
+static uint hid_count = 0;
+static struct cdc_itf cdc = {0};
+
+static uint frame = 0;
+static struct report reports[MAX_REPORTS];
+static uint report_count = 0;
+
+// Data received from the CDC interface, and in how many packets
+static uint8_t cdc_received[CDC_RECEIVED_SIZE];
+static uint cdc_received_len = 0;
+static uint cdc_packets = 0;
+
+// Fn+W (up arrow), Fn+M (mute) and Fn+\ (sleep) change the keyboard,
+// consumer and system reports on the same scan
+static const struct step contention_script[] = {
+    {0, KEY_A, true},         {10, KEY_A, false},
+    {20, L61_KEY_FN, true},   {30, KEY_W, true},
+    {30, KEY_M, true},        {30, KEY_BACKSLASH, true},
+    {40, KEY_W, false},       {40, KEY_M, false},
+    {40, KEY_BACKSLASH, false}, {50, KEY_M, true},
+    {51, KEY_W, true},        {60, KEY_M, false},
+    {60, KEY_W, false},       {70, L61_KEY_FN, false},
+};
+#define CONTENTION_STEPS \
+  (sizeof(contention_script) / sizeof(contention_script[0]))
+
+// Number bar keys, 1 to =, and their GeminiPR keys, see lard61_steno.c
+static const struct steno_key number_keys[CDC_CHORDS] = {
+    {1, L61_STENO_N1},  {2, L61_STENO_N2},  {3, L61_STENO_N3},
+    {4, L61_STENO_N4},  {5, L61_STENO_N5},  {6, L61_STENO_N6},
+    {7, L61_STENO_N7},  {8, L61_STENO_N8},  {9, L61_STENO_N9},
+    {10, L61_STENO_NA}, {11, L61_STENO_NB}, {12, L61_STENO_NC},
+};
+
+static const char* const report_names[] = {
+    [L61_REPORT_ID_KEYBOARD] = "keyboard",
+    [L61_REPORT_ID_CONSUMER_CONTROL] = "consumer",
+    [L61_REPORT_ID_SYSTEM_CONTROL] = "system",
+};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void fail(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  printf("FAIL: ");
+  vprintf(fmt, args);
+  printf("\n");
+  va_end(args);
+  failures++;
+}
+
+static void info(const char* fmt, ...) {
+  if (!verbose)
+    return;
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+}
+
+static uint16_t read_u16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+
+// Run a control transfer, return the length of its data stage or -1 if the
+// device stalled it
+static int control(uint8_t type,
+                   uint8_t request,
+                   uint16_t value,
+                   uint16_t index,
+                   void* data,
+                   uint16_t len) {
+  const tusb_control_request_t setup = {
+      .bmRequestType = type,
+      .bRequest = request,
+      .wValue = value,
+      .wIndex = index,
+      .wLength = len,
+  };
+  return l61_dcd_control(&setup, data);
+}
+
+static int get_descriptor(uint8_t type,
+                          uint8_t index,
+                          uint16_t langid,
+                          void* data,
+                          uint16_t len) {
+  return control(REQ_DEVICE_IN, TUSB_REQ_GET_DESCRIPTOR, (type << 8) | index,
+                 langid, data, len);
+}
+
+static void check_string(uint8_t index, const char* what) {
+  if (index == 0)
+    return;
+  uint8_t desc[255];
+  int len = get_descriptor(TUSB_DESC_STRING, index, 0x0409, desc,
+                           sizeof(desc));
+  if (len < 0) {
+    fail("%s string %u is missing", what, index);
+    return;
+  }
+  if (len < 2 || desc[0] != len || desc[1] != TUSB_DESC_STRING ||
+      len % 2 != 0) {
+    fail("%s string %u: bad header in %d bytes", what, index, len);
+    return;
+  }
+  // All strings of the firmware are ASCII
+  char text[64] = {0};
+  for (int i = 1; i < len / 2; ++i) {
+    uint16_t c = read_u16(&desc[2 * i]);
+    if (c < 0x20 || c > 0x7e) {
+      fail("%s string %u: character %d is U+%04X, not printable ASCII", what,
+           index, i - 1, c);
+      return;
+    }
+    if (i - 1 < (int)sizeof(text) - 1)
+      text[i - 1] = (char)c;
+  }
+  info("  %s string %u: \"%s\"\n", what, index, text);
+}
+
+static void parse_report_descriptor(struct hid_itf* itf,
+                                    const uint8_t* desc,
+                                    uint16_t len) {
+  uint32_t size = 0;
+  uint32_t count = 0;
+  uint8_t id = 0;
+  int depth = 0;
+  for (uint i = 0; i < len;) {
+    uint8_t prefix = desc[i];
+    if (prefix == 0xfe) {
+      // Long item, unused by HID 1.11 devices
+      i += i + 1 < len ? 3 + desc[i + 1] : 1;
+      continue;
+    }
+    uint n = prefix & 3;
+    if (n == 3)
+      n = 4;
+    if (i + 1 + n > len) {
+      fail("interface %u: item at byte %u runs past the report descriptor",
+           itf->number, i);
+      return;
+    }
+    uint32_t value = 0;
+    for (uint k = 0; k < n; ++k)
+      value |= (uint32_t)desc[i + 1 + k] << (8 * k);
+
+    switch (prefix & 0xfc) {
+      case 0x74:  // Report Size
+        size = value;
+        break;
+      case 0x94:  // Report Count
+        count = value;
+        break;
+      case 0x84:  // Report ID
+        if (value == 0 || value > 255)
+          fail("interface %u: invalid report ID %u", itf->number, value);
+        id = (uint8_t)value;
+        itf->uses_ids = true;
+        break;
+      case 0x80:  // Input
+        itf->input_bits[id] += size * count;
+        break;
+      case 0x90:  // Output
+        itf->output_bits[id] += size * count;
+        break;
+      case 0xa0:  // Collection
+        depth++;
+        break;
+      case 0xc0:  // End Collection
+        if (--depth < 0)
+          fail("interface %u: End Collection without Collection", itf->number);
+        break;
+      default:
+        break;
+    }
+    i += 1 + n;
+  }
+  if (depth != 0)
+    fail("interface %u: %d collections are not closed", itf->number, depth);
+
+  for (uint r = 0; r < 256; ++r) {
+    if (itf->input_bits[r] % 8 != 0 || itf->output_bits[r] % 8 != 0)
+      fail("interface %u: report %u is not a whole number of bytes",
+           itf->number, r);
+    if (itf->input_bits[r] > 0)
+      info("  interface %u report %u: %u input bytes\n", itf->number, r,
+           itf->input_bits[r] / 8);
+    if (itf->output_bits[r] > 0)
+      info("  interface %u report %u: %u output bytes\n", itf->number, r,
+           itf->output_bits[r] / 8);
+    uint packet = itf->input_bits[r] / 8 + (itf->uses_ids ? 1 : 0);
+    if (itf->input_bits[r] > 0 && packet > itf->ep_size)
+      fail("interface %u: report %u takes %u bytes, the endpoint only %u",
+           itf->number, r, packet, itf->ep_size);
+  }
+}
+
+
+static void enumerate() {
+  info("enumeration\n");
+  l61_dcd_bus_reset();
+  // Like Windows, read up to a whole packet of the device descriptor first
+  uint8_t dev[FS_MAX_PACKET];
+  int len = get_descriptor(TUSB_DESC_DEVICE, 0, 0, dev, sizeof(dev));
+  if (len != 18) {
+    fail("device descriptor: %d bytes read instead of 18", len);
+    return;
+  }
+  if (control(REQ_DEVICE_OUT, TUSB_REQ_SET_ADDRESS, DEVICE_ADDRESS, 0, NULL,
+              0) < 0)
+    fail("SET_ADDRESS stalled");
+  len = get_descriptor(TUSB_DESC_DEVICE, 0, 0, dev, 18);
+  if (len != 18 || dev[0] != 18 || dev[1] != TUSB_DESC_DEVICE)
+    fail("device descriptor: %d bytes, length %u, type %u", len, dev[0],
+         dev[1]);
+  if (dev[7] != 8 && dev[7] != 16 && dev[7] != 32 && dev[7] != 64)
+    fail("device descriptor: endpoint 0 size %u", dev[7]);
+  if (dev[17] != 1)
+    fail("device descriptor: %u configurations", dev[17]);
+  info("  USB %x.%02x, %04x:%04x\n", dev[3], dev[2], read_u16(&dev[8]),
+       read_u16(&dev[10]));
+
+  uint8_t langid[4];
+  len = get_descriptor(TUSB_DESC_STRING, 0, 0, langid, sizeof(langid));
+  if (len != 4 || langid[0] != 4 || langid[1] != TUSB_DESC_STRING ||
+      read_u16(&langid[2]) != 0x0409)
+    fail("string 0 does not list US English");
+  check_string(dev[14], "manufacturer");
+  check_string(dev[15], "product");
+  check_string(dev[16], "serial");
+
+  static uint8_t cfg[MAX_CONFIG_SIZE];
+  len = get_descriptor(TUSB_DESC_CONFIGURATION, 0, 0, cfg, 9);
+  if (len != 9 || cfg[0] != 9 || cfg[1] != TUSB_DESC_CONFIGURATION) {
+    fail("configuration descriptor: %d bytes, length %u, type %u", len,
+         cfg[0], cfg[1]);
+    return;
+  }
+  uint16_t total = read_u16(&cfg[2]);
+  if (total > sizeof(cfg)) {
+    fail("configuration descriptor: %u bytes", total);
+    return;
+  }
+  len = get_descriptor(TUSB_DESC_CONFIGURATION, 0, 0, cfg, total);
+  if (len != total) {
+    fail("configuration descriptor: %d bytes read instead of %u", len, total);
+    return;
+  }
+  uint8_t config_value = cfg[5];
+  uint8_t itf_count = cfg[4];
+  uint32_t itf_seen = 0;
+  bool ep_seen[256] = {false};
+  struct hid_itf* current = NULL;
+  bool cdc_data = false;
+
+  uint offset = 0;
+  while (offset < total) {
+    const uint8_t* d = &cfg[offset];
+    if (d[0] < 2 || offset + d[0] > total) {
+      fail("descriptor at byte %u: length %u runs past %u bytes", offset,
+           d[0], total);
+      return;
+    }
+    switch (d[1]) {
+      case TUSB_DESC_INTERFACE:
+        current = NULL;
+        cdc_data = false;
+        if (d[3] != 0)
+          break;
+        if (d[2] >= itf_count || (itf_seen & (1u << d[2])))
+          fail("interface %u is out of range or repeated", d[2]);
+        itf_seen |= 1u << d[2];
+        check_string(d[8], "interface");
+        if (d[5] == TUSB_CLASS_HID && hid_count < MAX_HID) {
+          current = &hid[hid_count++];
+          current->number = d[2];
+          current->subclass = d[6];
+          current->protocol = d[7];
+          current->mode = HID_PROTOCOL_REPORT;
+        } else if (d[5] == TUSB_CLASS_CDC) {
+          cdc.number = d[2];
+        } else if (d[5] == TUSB_CLASS_CDC_DATA) {
+          cdc_data = true;
+        }
+        break;
+      case HID_DESC_TYPE_HID:
+        if (current == NULL || d[6] != HID_DESC_TYPE_REPORT)
+          fail("HID descriptor at byte %u is misplaced", offset);
+        else
+          current->report_desc_len = read_u16(&d[7]);
+        break;
+      case TUSB_DESC_ENDPOINT: {
+        uint8_t addr = d[2];
+        uint16_t size = read_u16(&d[4]);
+        if (ep_seen[addr])
+          fail("endpoint %02x is used twice", addr);
+        ep_seen[addr] = true;
+        if (size > FS_MAX_PACKET)
+          fail("endpoint %02x: %u bytes is too large at full speed", addr,
+               size);
+        if ((d[3] & 3) == TUSB_XFER_INTERRUPT && d[6] == 0)
+          fail("endpoint %02x: interrupt endpoint without interval", addr);
+        if (current != NULL && (addr & TUSB_DIR_IN_MASK)) {
+          current->ep_in = addr;
+          current->ep_size = size;
+          current->interval = d[6];
+        } else if (cdc_data) {
+          if (addr & TUSB_DIR_IN_MASK)
+            cdc.ep_in = addr;
+          else
+            cdc.ep_out = addr;
+          cdc.ep_size = size;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    offset += d[0];
+  }
+  if (itf_seen != (1u << itf_count) - 1)
+    fail("configuration lists %u interfaces, found %08x", itf_count,
+         itf_seen);
+
+  if (control(REQ_DEVICE_OUT, TUSB_REQ_SET_CONFIGURATION, config_value, 0,
+              NULL, 0) < 0 ||
+      !tud_mounted()) {
+    fail("device not mounted by SET_CONFIGURATION");
+    return;
+  }
+  for (uint addr = 1; addr < 256; ++addr) {
+    if (ep_seen[addr] && !l61_dcd_is_open((uint8_t)addr))
+      fail("endpoint %02x was not opened by SET_CONFIGURATION", addr);
+  }
+
+  if (hid_count <= L61_HID_MOUSE) {
+    fail("%u HID interfaces, expected a keyboard and a mouse", hid_count);
+    return;
+  }
+  for (uint i = 0; i < hid_count; ++i) {
+    struct hid_itf* itf = &hid[i];
+    info("  HID %u: interface %u, endpoint %02x, %u bytes every %u ms\n", i,
+         itf->number, itf->ep_in, itf->ep_size, itf->interval);
+    if (itf->ep_in == 0)
+      fail("HID %u has no IN endpoint", i);
+    if (itf->interval != 1)
+      fail("HID %u is polled every %u ms instead of every frame", i,
+           itf->interval);
+
+    static uint8_t report_desc[MAX_REPORT_DESC_SIZE];
+    len = itf->report_desc_len <= sizeof(report_desc)
+              ? control(REQ_INTERFACE_IN, TUSB_REQ_GET_DESCRIPTOR,
+                        HID_DESC_TYPE_REPORT << 8, itf->number, report_desc,
+                        itf->report_desc_len)
+              : -1;
+    if (len != itf->report_desc_len)
+      fail("HID %u: %d bytes of report descriptor read instead of %u", i,
+           len, itf->report_desc_len);
+    else
+      parse_report_descriptor(itf, report_desc, itf->report_desc_len);
+    // Hosts only want reports on changes
+    if (control(REQ_CLASS_INTERFACE_OUT, HID_REQ_CONTROL_SET_IDLE, 0,
+                itf->number, NULL, 0) < 0)
+      fail("HID %u: SET_IDLE stalled", i);
+  }
+
+  struct hid_itf* keyboard = &hid[L61_HID_KEYBOARD];
+  if (keyboard->subclass != HID_SUBCLASS_BOOT ||
+      keyboard->protocol != HID_ITF_PROTOCOL_KEYBOARD)
+    fail("HID %u is not a boot keyboard", L61_HID_KEYBOARD);
+  if (keyboard->input_bits[L61_REPORT_ID_KEYBOARD] != 8 * 8)
+    fail("keyboard report is not 8 bytes");
+  if (keyboard->output_bits[L61_REPORT_ID_KEYBOARD] != 8)
+    fail("keyboard LED report is not 1 byte");
+  if (hid[L61_HID_MOUSE].input_bits[0] != 8 * sizeof(hid_mouse_report_t))
+    fail("mouse report is not %u bytes",
+         (uint)sizeof(hid_mouse_report_t));
+  if (cdc.ep_in == 0 || cdc.ep_out == 0)
+    fail("no CDC data endpoints");
+}
+
+// Check each report against the report descriptor and keep it
+static void hid_report(uint8_t instance,
+                       uint8_t report_id,
+                       const uint8_t* data,
+                       uint16_t len) {
+  bool boot = hid[instance].mode == HID_PROTOCOL_BOOT;
+  if (boot) {
+    if (report_id != 0 || len != 8)
+      fail("frame %u: boot protocol report with ID %u, %u bytes", frame,
+           report_id, len);
+  } else if (hid[instance].uses_ids != (report_id != 0) ||
+             hid[instance].input_bits[report_id] != 8u * len) {
+    fail("frame %u: HID %u report %u has %u bytes, the descriptor %u",
+         frame, instance, report_id, len,
+         hid[instance].input_bits[report_id] / 8);
+  }
+
+  if (report_count == MAX_REPORTS)
+    return;
+  struct report* r = &reports[report_count++];
+  r->frame = frame;
+  r->instance = instance;
+  r->report_id = report_id;
+  r->len = len < sizeof(r->data) ? len : sizeof(r->data);
+  memset(r->data, 0, sizeof(r->data));
+  memcpy(r->data, data, r->len);
+}
+
+// Split a packet from a HID endpoint into its report ID and report. There
+// is no report ID in boot protocol.
+static void hid_packet(uint8_t instance, const uint8_t* packet, uint16_t len) {
+  uint8_t report_id = 0;
+  if (hid[instance].uses_ids && hid[instance].mode == HID_PROTOCOL_REPORT) {
+    if (len == 0) {
+      fail("frame %u: empty packet from HID %u", frame, instance);
+      return;
+    }
+    report_id = packet[0];
+    packet++;
+    len--;
+  }
+  hid_report(instance, report_id, packet, len);
+}
+
+// Poll the HID endpoints once, and the CDC one until it has nothing left
+static void poll_endpoints() {
+  uint8_t packet[FS_MAX_PACKET];
+  for (uint8_t i = 0; i < hid_count; ++i) {
+    int len = l61_dcd_in(hid[i].ep_in, packet);
+    if (len >= 0)
+      hid_packet(i, packet, (uint16_t)len);
+  }
+
+  int len;
+  while (cdc.ep_in != 0 && (len = l61_dcd_in(cdc.ep_in, packet)) >= 0) {
+    cdc_packets++;
+    uint kept = sizeof(cdc_received) - cdc_received_len;
+    if ((uint)len < kept)
+      kept = (uint)len;
+    memcpy(&cdc_received[cdc_received_len], packet, kept);
+    cdc_received_len += kept;
+  }
+}
+
+// Run the main loop for `count` frames, the host polling once per frame
+static void run_frames(uint count) {
+  for (uint i = 0; i < count; ++i) {
+    l61_host_set_time_us(1000000 + (uint64_t)frame * FRAME_US);
+    tud_task();
+    l61_hid_task();
+    l61_steno_task();
+    poll_endpoints();
+    frame++;
+  }
+}
+
+static bool has_key(const uint8_t* keycode, uint8_t key) {
+  for (uint i = 0; i < 6; ++i) {
+    if (keycode[i] == key)
+      return true;
+  }
+  return false;
+}
+
+
+// SET_REPORT of a one byte report. With a report ID, the data starts with
+// it.
+static void set_report(uint8_t instance,
+                       uint8_t type,
+                       uint8_t report_id,
+                       uint8_t value) {
+  uint8_t data[2] = {report_id, value};
+  uint16_t len = report_id != 0 ? 2 : 1;
+  if (control(REQ_CLASS_INTERFACE_OUT, HID_REQ_CONTROL_SET_REPORT,
+              (type << 8) | report_id, hid[instance].number,
+              report_id != 0 ? data : &data[1], len) != len)
+    fail("SET_REPORT of HID %u report %u stalled", instance, report_id);
+}
+
+static void set_protocol(uint8_t instance, uint8_t protocol) {
+  if (control(REQ_CLASS_INTERFACE_OUT, HID_REQ_CONTROL_SET_PROTOCOL, protocol,
+              hid[instance].number, NULL, 0) < 0)
+    fail("SET_PROTOCOL of HID %u stalled", instance);
+  hid[instance].mode = protocol;
+  if (tud_hid_n_get_protocol(instance) != protocol)
+    fail("HID %u: protocol %u after SET_PROTOCOL %u", instance,
+         tud_hid_n_get_protocol(instance), protocol);
+}
+
+static void set_line_state(uint16_t state) {
+  if (control(REQ_CLASS_INTERFACE_OUT, CDC_REQUEST_SET_CONTROL_LINE_STATE,
+              state, cdc.number, NULL, 0) < 0)
+    fail("SET_CONTROL_LINE_STATE %u stalled", state);
+}
+
+// Type steno chords of a single number bar key each, from number_keys[0]
+static void type_chords(uint count) {
+  uint32_t now_us = 1000000 + frame * FRAME_US;
+  for (uint i = 0; i < count; ++i) {
+    l61_steno_key(number_keys[i].index, true, now_us);
+    l61_steno_key(number_keys[i].index, false, now_us);
+  }
+}
+
+static void test_set_report() {
+  info("SET_REPORT\n");
+  // Report protocol: TinyUSB passes the report ID, and strips it from the
+  // data
+  uint8_t leds = KEYBOARD_LED_CAPSLOCK;
+  set_report(L61_HID_KEYBOARD, HID_REPORT_TYPE_OUTPUT, L61_REPORT_ID_KEYBOARD,
+             leds);
+  if (l61_led_get_host_leds() != leds)
+    fail("LEDs %02x after SET_REPORT %02x", l61_led_get_host_leds(), leds);
+
+  // Boot protocol: no report ID
+  leds = KEYBOARD_LED_NUMLOCK | KEYBOARD_LED_SCROLLLOCK;
+  set_report(L61_HID_KEYBOARD, HID_REPORT_TYPE_OUTPUT, 0, leds);
+  if (l61_led_get_host_leds() != leds)
+    fail("LEDs %02x after boot SET_REPORT %02x", l61_led_get_host_leds(),
+         leds);
+
+  // Not the LEDs
+  set_report(L61_HID_KEYBOARD, HID_REPORT_TYPE_FEATURE, L61_REPORT_ID_KEYBOARD,
+             0xff);
+  set_report(L61_HID_MOUSE, HID_REPORT_TYPE_OUTPUT, 0, 0xff);
+  if (l61_led_get_host_leds() != leds)
+    fail("LEDs changed by a report which is not the keyboard LEDs");
+  info("  LEDs %02x\n", l61_led_get_host_leds());
+}
+
+static void test_set_protocol() {
+  info("SET_PROTOCOL\n");
+  set_protocol(L61_HID_KEYBOARD, HID_PROTOCOL_BOOT);
+  uint first = report_count;
+  l61_host_pressed[KEY_SHIFT_LEFT] = true;
+  l61_host_pressed[KEY_A] = true;
+  run_frames(5);
+  // A consumer key, which boot protocol hosts cannot receive
+  l61_host_pressed[L61_KEY_FN] = true;
+  l61_host_pressed[KEY_M] = true;
+  run_frames(5);
+  memset(l61_host_pressed, 0, sizeof(l61_host_pressed));
+  run_frames(5);
+
+  bool shift_a = false;
+  for (uint i = first; i < report_count; ++i) {
+    const struct report* r = &reports[i];
+    if (r->instance != L61_HID_KEYBOARD)
+      continue;
+    if (r->report_id != 0) {
+      fail("report %u sent in boot protocol", r->report_id);
+      continue;
+    }
+    for (uint k = 2; k < 8; ++k) {
+      if (r->data[k] >= HID_KEY_CONTROL_LEFT)
+        fail("boot protocol report with modifier %02x in the key array",
+             r->data[k]);
+    }
+    if (r->data[0] == KEYBOARD_MODIFIER_LEFTSHIFT &&
+        has_key(&r->data[2], HID_KEY_A))
+      shift_a = true;
+  }
+  if (!shift_a)
+    fail("no boot protocol report for Shift+A");
+
+  // Back to the report protocol, which needs a fresh keyboard report
+  set_protocol(L61_HID_KEYBOARD, HID_PROTOCOL_REPORT);
+  first = report_count;
+  run_frames(5);
+  if (report_count == first ||
+      reports[first].report_id != L61_REPORT_ID_KEYBOARD)
+    fail("no keyboard report after switching back to report protocol");
+}
+
+static void test_contention() {
+  info("report timing\n");
+  uint start = frame;
+  uint first = report_count;
+  uint step = 0;
+  uint last_change = 0;
+  while (frame - start <= contention_script[CONTENTION_STEPS - 1].frame + 5) {
+    for (; step < CONTENTION_STEPS &&
+           contention_script[step].frame == frame - start;
+         ++step) {
+      l61_host_pressed[contention_script[step].key] =
+          contention_script[step].pressed;
+      last_change = frame;
+    }
+    run_frames(1);
+  }
+
+  // Delay of each report from the last key change before it, in frames
+  uint32_t count[4] = {0};
+  uint32_t max_delay[4] = {0};
+  uint32_t total_delay[4] = {0};
+  last_change = start;
+  step = 0;
+  for (uint i = first; i < report_count; ++i) {
+    const struct report* r = &reports[i];
+    if (r->instance != L61_HID_KEYBOARD || r->report_id == 0 ||
+        r->report_id > L61_REPORT_ID_SYSTEM_CONTROL)
+      continue;
+    for (; step < CONTENTION_STEPS &&
+           start + contention_script[step].frame <= r->frame;
+         ++step)
+      last_change = start + contention_script[step].frame;
+    uint delay = r->frame - last_change + 1;
+    info("  frame %3u: %-8s report, %u frame(s) after the key change\n",
+         r->frame - start, report_names[r->report_id], delay);
+    count[r->report_id]++;
+    total_delay[r->report_id] += delay;
+    if (delay > max_delay[r->report_id])
+      max_delay[r->report_id] = delay;
+  }
+  for (uint id = L61_REPORT_ID_KEYBOARD; id <= L61_REPORT_ID_SYSTEM_CONTROL;
+       ++id) {
+    printf("%-8s reports: %u, delay mean %.1f frames, max %u\n",
+           report_names[id], count[id],
+           count[id] ? (double)total_delay[id] / count[id] : 0.0,
+           max_delay[id]);
+  }
+  // Keystrokes always go first
+  if (max_delay[L61_REPORT_ID_KEYBOARD] > 1)
+    fail("a keyboard report waited %u frames for the endpoint",
+         max_delay[L61_REPORT_ID_KEYBOARD]);
+}
+
+
+static void test_cdc() {
+  info("CDC\n");
+  if (cdc.ep_in == 0 || cdc.ep_out == 0)
+    return;
+  l61_steno_set_enabled(true);
+
+  // Port closed: steno waits for it to be opened
+  run_frames(1);
+  type_chords(CDC_CHORDS);
+  run_frames(2);
+  if (tud_cdc_connected() || cdc_received_len > 0)
+    fail("%u CDC bytes sent before the port was opened", cdc_received_len);
+
+  // Opened like a terminal does: line coding, then DTR and RTS
+  cdc_line_coding_t coding = {
+      .bit_rate = 115200, .stop_bits = 0, .parity = 0, .data_bits = 8};
+  if (control(REQ_CLASS_INTERFACE_OUT, CDC_REQUEST_SET_LINE_CODING, 0,
+              cdc.number, &coding, sizeof(coding)) != sizeof(coding))
+    fail("SET_LINE_CODING stalled");
+  set_line_state(LINE_STATE_DTR | LINE_STATE_RTS);
+  if (!tud_cdc_connected())
+    fail("CDC port not open after SET_CONTROL_LINE_STATE");
+  run_frames(1);
+
+  // Chords typed within a frame, more than one packet of them
+  uint packets = cdc_packets;
+  type_chords(CDC_CHORDS);
+  run_frames(2);
+  packets = cdc_packets - packets;
+  if (cdc_received_len != CDC_CHORDS * L61_STENO_PACKET_SIZE)
+    fail("%u CDC bytes received for %u steno chords", cdc_received_len,
+         CDC_CHORDS);
+  for (uint i = 0; i < CDC_CHORDS &&
+                   (i + 1) * L61_STENO_PACKET_SIZE <= cdc_received_len;
+       ++i) {
+    uint8_t expected[L61_STENO_PACKET_SIZE] = {0};
+    uint key = number_keys[i].key;
+    expected[key / 7] |= 0x40 >> (key % 7);
+    expected[0] |= L61_STENO_PACKET_START;
+    if (memcmp(&cdc_received[i * L61_STENO_PACKET_SIZE], expected,
+               sizeof(expected)) != 0)
+      fail("steno chord %u does not match its GeminiPR packet", i);
+  }
+  info("  %u steno chords in %u bytes, %u USB packets\n", CDC_CHORDS,
+       cdc_received_len, packets);
+
+  // From the host, over several packets
+  uint8_t text[CDC_TEXT_SIZE];
+  for (uint i = 0; i < sizeof(text); ++i)
+    text[i] = (uint8_t)('a' + i % 26);
+  for (uint sent = 0; sent < sizeof(text);) {
+    uint16_t len = sizeof(text) - sent < cdc.ep_size
+                       ? (uint16_t)(sizeof(text) - sent)
+                       : cdc.ep_size;
+    if (!l61_dcd_out(cdc.ep_out, &text[sent], len)) {
+      fail("CDC OUT endpoint not ready after %u bytes", sent);
+      break;
+    }
+    sent += len;
+  }
+  uint8_t read[CDC_TEXT_SIZE + 1];
+  uint32_t available = tud_cdc_available();
+  uint32_t len = tud_cdc_read(read, sizeof(read));
+  if (available != sizeof(text) || len != sizeof(text) ||
+      memcmp(read, text, sizeof(text)) != 0)
+    fail("%u bytes read back from CDC, %u available, of the %u sent", len,
+         available, (uint)sizeof(text));
+  info("  %u bytes received from the host\n", len);
+
+  // Port closed again
+  set_line_state(0);
+  if (tud_cdc_connected())
+    fail("CDC port still open after clearing DTR");
+  run_frames(1);
+  uint received = cdc_received_len;
+  type_chords(CDC_CHORDS);
+  run_frames(2);
+  if (cdc_received_len != received)
+    fail("%u CDC bytes sent after the port was closed",
+         cdc_received_len - received);
+  l61_steno_set_enabled(false);
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  l61_keymap_setup();
+  tud_init(BOARD_TUD_RHPORT);
+  enumerate();
+  if (hid_count <= L61_HID_MOUSE || !tud_mounted()) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  // Initial reports
+  run_frames(5);
+
+  test_set_report();
+  test_set_protocol();
+  test_contention();
+  test_cdc();
+
+  printf("%u check(s) failed\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+/*
+** file: class/cdc/cdc_device.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the TinyUSB CDC device API. Nothing is ever
+** received, the port is always open, and output goes to stdout or to
+** l61_host_cdc_write (see l61_host.h).
+*/
+
+#ifndef _L61_HOST_CDC_DEVICE_H
+#define _L61_HOST_CDC_DEVICE_H
+
+#include "pico/types.h"
+
+uint32_t tud_cdc_available(void);
+uint32_t tud_cdc_read(void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
+bool tud_cdc_connected(void);
+
+#endif /* _L61_HOST_CDC_DEVICE_H */
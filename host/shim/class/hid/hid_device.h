@@ -0,0 +1,46 @@
+/*
+** file: class/hid/hid_device.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the TinyUSB HID device API. Reports wait on their
+** endpoint until the simulated host polls it with l61_host_hid_poll (see
+** l61_host.h). The protocol is the report protocol unless set with
+** l61_host_hid_set_protocol.
+*/
+
+#ifndef _L61_HOST_HID_DEVICE_H
+#define _L61_HOST_HID_DEVICE_H
+
+#include "class/hid/hid.h"
+#include "pico/types.h"
+
+bool tud_hid_n_ready(uint8_t instance);
+uint8_t tud_hid_n_get_protocol(uint8_t instance);
+bool tud_hid_n_report(uint8_t instance,
+                      uint8_t report_id,
+                      void const* report,
+                      uint16_t len);
+bool tud_hid_n_keyboard_report(uint8_t instance,
+                               uint8_t report_id,
+                               uint8_t modifier,
+                               const uint8_t keycode[6]);
+
+// Callbacks of the firmware, in lard61_usb.c
+uint16_t tud_hid_get_report_cb(uint8_t itf,
+                               uint8_t report_id,
+                               hid_report_type_t report_type,
+                               uint8_t* buffer,
+                               uint16_t reqlen);
+void tud_hid_set_report_cb(uint8_t itf,
+                           uint8_t report_id,
+                           hid_report_type_t report_type,
+                           uint8_t const* buffer,
+                           uint16_t bufsize);
+void tud_hid_report_complete_cb(uint8_t instance,
+                                uint8_t const* report,
+                                uint16_t len);
+// Defined in usb_descriptors.c
+uint8_t const* tud_hid_descriptor_report_cb(uint8_t itf);
+
+#endif /* _L61_HOST_HID_DEVICE_H */
@@ -0,0 +1,28 @@
+/*
+** file: device/usbd.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the TinyUSB device API. The device is mounted
+** unless set otherwise with l61_host_set_mounted (see l61_host.h).
+*/
+
+#ifndef _L61_HOST_USBD_H
+#define _L61_HOST_USBD_H
+
+#include "pico/types.h"
+
+bool tud_mounted(void);
+
+// Callbacks of the firmware, in lard61_usb.c
+void tud_mount_cb(void);
+void tud_umount_cb(void);
+void tud_suspend_cb(bool remote_wakeup_en);
+void tud_resume_cb(void);
+
+// Defined in usb_descriptors.c
+uint8_t const* tud_descriptor_device_cb(void);
+uint8_t const* tud_descriptor_configuration_cb(uint8_t index);
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid);
+
+#endif /* _L61_HOST_USBD_H */
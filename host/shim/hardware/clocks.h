@@ -0,0 +1,24 @@
+/*
+** file: hardware/clocks.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header, for the simulated core of
+** l61_cycles_target.c. It runs at the firmware's 125 MHz system clock.
+*/
+
+#ifndef _L61_HOST_HARDWARE_CLOCKS_H
+#define _L61_HOST_HARDWARE_CLOCKS_H
+
+#include "pico/types.h"
+
+enum clock_index {
+  clk_sys,
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clock) {
+  (void)clock;
+  return 125000000;
+}
+
+#endif /* _L61_HOST_HARDWARE_CLOCKS_H */
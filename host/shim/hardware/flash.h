@@ -0,0 +1,16 @@
+/*
+** file: hardware/flash.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header. There is no flash on the host:
+** the config store is stubbed out in l61_host.c.
+*/
+
+#ifndef _L61_HOST_HARDWARE_FLASH_H
+#define _L61_HOST_HARDWARE_FLASH_H
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+#endif /* _L61_HOST_HARDWARE_FLASH_H */
@@ -0,0 +1,29 @@
+/*
+** file: hardware/structs/systick.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header, for the simulated core of
+** l61_cycles_target.c. l61_m0.c maps SysTick at the same address as the
+** Cortex-M0+.
+*/
+
+#ifndef _L61_HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define _L61_HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico/types.h"
+
+#define M0PLUS_SYST_CSR_ENABLE_BITS 0x00000001u
+#define M0PLUS_SYST_CSR_CLKSOURCE_BITS 0x00000004u
+#define M0PLUS_SYST_RVR_BITS 0x00ffffffu
+
+typedef struct {
+  volatile uint32_t csr;
+  volatile uint32_t rvr;
+  volatile uint32_t cvr;
+  volatile uint32_t calib;
+} systick_hw_t;
+
+#define systick_hw ((systick_hw_t*)0xe000e010u)
+
+#endif /* _L61_HOST_HARDWARE_STRUCTS_SYSTICK_H */
@@ -0,0 +1,23 @@
+/*
+** file: hardware/sync.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header of the same name. There are no
+** interrupts on the host.
+*/
+
+#ifndef _L61_HOST_HARDWARE_SYNC_H
+#define _L61_HOST_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+  return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+  (void)status;
+}
+
+#endif /* _L61_HOST_HARDWARE_SYNC_H */
@@ -0,0 +1,22 @@
+/*
+** file: pico/bootrom.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header of the same name.
+*/
+
+#ifndef _L61_HOST_PICO_BOOTROM_H
+#define _L61_HOST_PICO_BOOTROM_H
+
+#include "pico/types.h"
+
+#ifndef PICO_DEFAULT_LED_PIN
+#define PICO_DEFAULT_LED_PIN 25
+#endif
+
+// Exits, there is no BOOTSEL mode to restart into
+void reset_usb_boot(uint32_t gpio_activity_pin_mask,
+                    uint32_t disable_interface_mask);
+
+#endif /* _L61_HOST_PICO_BOOTROM_H */
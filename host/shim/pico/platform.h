@@ -0,0 +1,15 @@
+/*
+** file: pico/platform.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header. Code placement attributes are
+** not used on the host, see lard61_hot.h.
+*/
+
+#ifndef _L61_HOST_PICO_PLATFORM_H
+#define _L61_HOST_PICO_PLATFORM_H
+
+#include "pico/types.h"
+
+#endif /* _L61_HOST_PICO_PLATFORM_H */
@@ -0,0 +1,19 @@
+/*
+** file: pico/time.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header. Time is simulated, see
+** l61_host_set_time_us.
+*/
+
+#ifndef _L61_HOST_PICO_TIME_H
+#define _L61_HOST_PICO_TIME_H
+
+#include "pico/types.h"
+
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint32_t time_us_32(void);
+
+#endif /* _L61_HOST_PICO_TIME_H */
@@ -0,0 +1,20 @@
+/*
+** file: pico/types.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Host replacement for the pico SDK header of the same name, providing
+** only what the firmware modules built for the host use.
+*/
+
+#ifndef _L61_HOST_PICO_TYPES_H
+#define _L61_HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#endif /* _L61_HOST_PICO_TYPES_H */
@@ -13,7 +13,14 @@
 // Adding this delay multiplier fixes the issue.
 // Empirically, 4 is enough to eliminate the problem in 90% of boots,
 // so 8 should be safe.
+// The XOSC STABLE flag only tells that this startup delay has elapsed, so
+// there is no finer-grained stability check to replace it with. Each unit
+// costs about 1ms of boot time, before the timer used by the boot log
+// (`boot` shell command) starts counting. To experiment with other values,
+// add -DPICO_XOSC_STARTUP_DELAY_MULTIPLIER=n to CMAKE_C_FLAGS.
+#ifndef PICO_XOSC_STARTUP_DELAY_MULTIPLIER
 #define PICO_XOSC_STARTUP_DELAY_MULTIPLIER 8
+#endif
 
 // --- FLASH ---
 #define PICO_BOOT_STAGE2_CHOOSE_W25Q080 1
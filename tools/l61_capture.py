@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Save the lard61 key event capture from its CDC serial port.
+
+    tools/l61_capture.py /dev/ttyACM0 capture.bin
+    build-host/l61_replay capture.bin
+
+The capture holds the last raw and debounced key events with a checkpoint of
+the debouncer state (see usb_device/lard61_capture.h). Dumping it starts a
+new capture on the keyboard.
+"""
+
+import argparse
+import struct
+import sys
+
+from l61_serial import Port
+
+MAGIC = 0x6C363163
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="CDC serial port of the keyboard")
+    parser.add_argument("output", help="file to write the capture to")
+    args = parser.parse_args()
+
+    port = Port(args.port)
+    port.command("capture dump")
+    size = int(port.expect(r"^binary (\d+)$").group(1))
+    data = port.read(size, timeout=10.0)
+
+    magic, version, keys, words = struct.unpack_from("<IHHI", data)
+    if magic != MAGIC:
+        sys.exit("the keyboard did not send a capture")
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+    print(f"{args.output}: version {version}, {keys} keys, {words} words")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Read the lard61 cycle counts, save them or compare them with a saved run.
+
+    tools/l61_cycles.py /dev/ttyACM0 --reset 60 --save flash.json
+    tools/l61_cycles.py /dev/ttyACM0 --reset 60 --compare flash.json
+    tools/l61_cycles.py --sim build-host/l61_cycles_target.elf \
+        --compare host/cycles_baseline.json
+
+The keyboard counts the processor cycles of its key path functions for idle
+scans and with one, up to six or more keys held (see
+usb_device/lard61_cycles.h). With --reset, the counts are cleared and read
+back after that many seconds, to be filled by typing, holding several keys
+at once, or running tools/l61_selfbench.py.
+
+With --sim, the counts come from the fixed key matrix states of
+host/l61_cycles_target.c run on the simulated Cortex-M0+ of l61_cycles_sim
+instead, which is found next to the program. They are the same on every
+run, so they can be compared in CI without a board.
+
+--compare prints the change of the minimum and mean of every count seen at
+least --min-calls times in both runs, and exits with a non-zero status if
+one grew by more than --tolerance percent. Maxima include interrupts and are
+not compared.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+from l61_serial import Port
+
+# Must match enum l61_cycles_probe and enum l61_cycles_load
+PROBES = ["scan", "debounce", "report", "hid_task"]
+LOADS = ["idle", "1key", "6keys", "more"]
+COMPARED = ["min", "mean"]
+
+
+class Simulation:
+    """Output of l61_cycles_target.elf on l61_cycles_sim, read like a Port.
+
+    The program prints its counts once and exits, so commands are ignored.
+    """
+
+    def __init__(self, elf):
+        sim = os.path.join(os.path.dirname(os.path.abspath(elf)),
+                           "l61_cycles_sim")
+        result = subprocess.run([sim, elf], capture_output=True, text=True)
+        if result.returncode != 0:
+            sys.exit(result.stderr.strip() or
+                     f"{elf} exited with status {result.returncode}")
+        self.lines = result.stdout.splitlines()
+
+    def command(self, line):
+        pass
+
+    def expect(self, pattern):
+        while self.lines:
+            match = re.search(pattern, self.lines.pop(0))
+            if match:
+                return match
+        sys.exit(f"l61_cycles_sim printed no '{pattern}'")
+
+
+def read_counts(port):
+    port.command("cycles")
+    header = port.expect(r"^cycles at (\d+) MHz, probe overhead (\d+)$")
+    port.expect(r"^probe\s+load")
+    counts = {"mhz": int(header.group(1)),
+              "overhead": int(header.group(2)), "probes": {}}
+    for probe in PROBES:
+        for load in LOADS:
+            m = port.expect(rf"^{probe}\s+{load}\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)$")
+            calls, low, mean, high = (int(g) for g in m.groups())
+            counts["probes"][f"{probe} {load}"] = {
+                "calls": calls, "min": low, "mean": mean, "max": high}
+    return counts
+
+
+def show(counts):
+    print(f"cycles at {counts['mhz']} MHz, probe overhead "
+          f"{counts['overhead']}")
+    print(f"{'probe':<15} {'calls':>9} {'min':>7} {'mean':>7} {'max':>8}")
+    for name, c in counts["probes"].items():
+        if c["calls"]:
+            print(f"{name:<15} {c['calls']:>9} {c['min']:>7} {c['mean']:>7} "
+                  f"{c['max']:>8}")
+
+
+def compare(old, new, tolerance, min_calls):
+    """Print the changes from `old` to `new`, return the regressions."""
+    regressions = 0
+    print(f"{'probe':<15} {'min':<20} {'mean':<20}")
+    for name, n in new["probes"].items():
+        o = old["probes"].get(name)
+        if not o or o["calls"] < min_calls or n["calls"] < min_calls:
+            continue
+        cells = []
+        for key in COMPARED:
+            change = (n[key] - o[key]) * 100 / o[key] if o[key] else 0
+            flag = ""
+            if change > tolerance:
+                flag = "!"
+                regressions += 1
+            cells.append(f"{o[key]:>6}->{n[key]:<6} {change:+4.0f}%{flag}")
+        print(f"{name:<15} " + " ".join(cells))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?",
+                        help="CDC serial port of the keyboard")
+    parser.add_argument("--sim", metavar="ELF",
+                        help="count on l61_cycles_sim running this program "
+                        "instead of the keyboard")
+    parser.add_argument("--reset", type=float, metavar="SECONDS",
+                        help="clear the counts and read them this much later")
+    parser.add_argument("--save", help="write the counts to this JSON file")
+    parser.add_argument("--compare", help="JSON file of a previous run")
+    parser.add_argument("--tolerance", type=float, default=5.0,
+                        help="allowed growth in percent (default 5)")
+    parser.add_argument("--min-calls", type=int, default=100,
+                        help="fewest calls of a count to compare it")
+    args = parser.parse_args()
+    if (args.port is None) == (args.sim is None):
+        parser.error("give either the keyboard's port or --sim")
+    if args.sim and args.reset is not None:
+        parser.error("--reset is for the keyboard only")
+
+    port = Simulation(args.sim) if args.sim else Port(args.port)
+    if args.reset is not None:
+        port.command("cycles reset")
+        port.expect(r"^cycle counts cleared$")
+        print(f"counting for {args.reset:.0f} s, type or hold keys now",
+              file=sys.stderr)
+        time.sleep(args.reset)
+    counts = read_counts(port)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(counts, f, indent=2)
+            f.write("\n")
+    if not args.compare:
+        show(counts)
+        return 0
+
+    with open(args.compare) as f:
+        old = json.load(f)
+    if old["mhz"] != counts["mhz"]:
+        print(f"warning: {old['mhz']} MHz before, {counts['mhz']} MHz now",
+              file=sys.stderr)
+    regressions = compare(old, counts, args.tolerance, args.min_calls)
+    print(f"{regressions} regression(s) above {args.tolerance:g}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
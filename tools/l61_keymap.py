@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Dump or replace the lard61 keymap over its CDC serial port.
+
+    tools/l61_keymap.py /dev/ttyACM0 dump > keymap.txt
+    tools/l61_keymap.py /dev/ttyACM0 upload keymap.txt
+
+The text format is the one printed by the `keymap dump` shell command: a
+[base] and a [fn] section, each with one 16-bit entry per key matrix index
+(see usb_device/lard61_keycodes.h). Anything after a '#' is a comment.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+from l61_serial import Port
+
+LAYERS = ["base", "fn"]
+KEYS = 5 * 14
+
+
+def parse(text):
+    layers = {}
+    current = None
+    for number, line in enumerate(text.splitlines(), 1):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        if line.startswith("[") and line.endswith("]"):
+            current = line[1:-1]
+            if current not in LAYERS:
+                sys.exit(f"line {number}: unknown layer '{current}'")
+            layers[current] = []
+            continue
+        if current is None:
+            sys.exit(f"line {number}: entry outside of a layer")
+        for token in line.split():
+            value = int(token, 0)
+            if not 0 <= value <= 0xFFFF:
+                sys.exit(f"line {number}: {token} does not fit in 16 bits")
+            layers[current].append(value)
+
+    entries = []
+    for layer in LAYERS:
+        if len(layers.get(layer, [])) != KEYS:
+            sys.exit(f"layer [{layer}] must have {KEYS} entries")
+        entries += layers[layer]
+    return struct.pack(f"<{len(entries)}H", *entries)
+
+
+def dump(port):
+    port.command("keymap dump")
+    port.expect(r"^\[base\]$")
+    print("[base]")
+    lines = KEYS // 14
+    for _ in range(lines):
+        print(port.expect(r"^0x").string)
+    print(port.expect(r"^\[fn\]$").string)
+    for _ in range(lines):
+        print(port.expect(r"^0x").string)
+
+
+def upload(port, path):
+    with open(path) as f:
+        keymap = parse(f.read())
+    crc = zlib.crc32(keymap)
+    port.command(f"keymap upload {crc:08x}")
+    size = int(port.expect(r"^ready (\d+)$").group(1))
+    if size != len(keymap):
+        sys.exit(f"the keyboard expects {size} bytes, not {len(keymap)}")
+    port.write(keymap)
+    result = port.expect(r"keymap: .*").group(0)
+    print(result)
+    if result != "keymap: ok":
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="CDC serial port of the keyboard")
+    sub = parser.add_subparsers(dest="action", required=True)
+    sub.add_parser("dump", help="print the active keymap")
+    upload_parser = sub.add_parser("upload", help="activate a new keymap")
+    upload_parser.add_argument("file", help="keymap in the dump format")
+    args = parser.parse_args()
+
+    port = Port(args.port)
+    if args.action == "dump":
+        dump(port)
+    else:
+        upload(port, args.file)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Live key tester for the lard61, from its key matrix stream.
+
+    tools/l61_keytest.py /dev/ttyACM0
+
+Shows the raw and debounced state of every key as it is scanned, with:
+
+    .  up           #  down
+    r  raw down, not registered yet (or bouncing)
+    d  registered down, raw already up (release being debounced)
+
+and counts, per key, registered presses, bounces (raw edges which did not
+change the debounced state), chatter (registered presses shorter than
+25 ms) and possible ghosts (a key going down while three other keys held
+down form a rectangle with it in the matrix). See usb_device/lard61_stream.h
+for the stream format. Stop with Ctrl-C.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import time
+
+from l61_serial import Port
+
+VERSION = 1
+ROWS = 5
+COLS = 14
+KEYS = ROWS * COLS
+BITMAP_SIZE = (KEYS + 7) // 8
+MAX_CHANGES = 2 * KEYS
+DEBOUNCED = 0x80
+SNAPSHOT = 0xF5
+SNAPSHOT_2 = 0x61
+SNAPSHOT_SIZE = 2 + 4 + 2 * BITMAP_SIZE + 1
+LOST = 0xFE
+
+# Must match L61_CHATTER_SHORT_PRESS_US in usb_device/lard61_debounce.h
+SHORT_PRESS_US = 25000
+# First key index of each row, from n_keys_in_row in lard61_keymatrix.c
+ROW_OFFSETS = [0, 14, 28, 41, 53]
+REDRAW_S = 0.05
+LOG_LINES = 12
+
+
+def position(key):
+    """Row and column of a key index."""
+    row = max(r for r in range(ROWS) if ROW_OFFSETS[r] <= key)
+    return row, key - ROW_OFFSETS[row]
+
+
+def key_at(row, col):
+    key = ROW_OFFSETS[row] + col
+    if key >= KEYS or position(key) != (row, col):
+        return None
+    return key
+
+
+class Tester:
+    def __init__(self):
+        self.synced = False
+        self.time_us = 0
+        self.raw = [False] * KEYS
+        self.debounced = [False] * KEYS
+        self.presses = [0] * KEYS
+        self.bounces = [0] * KEYS
+        self.chatter = [0] * KEYS
+        self.ghosts = [0] * KEYS
+        # Raw edges since the last debounced change, and press times
+        self.edges = [0] * KEYS
+        self.press_us = [0] * KEYS
+        self.frames = 0
+        self.lost = 0
+        self.resyncs = 0
+        self.log = []
+
+    def note(self, text):
+        self.log.append(f"{self.time_us / 1e6:10.3f} s  {text}")
+        del self.log[:-LOG_LINES]
+
+    def parse(self, data):
+        """Consume complete frames from `data`, return what is left."""
+        while data:
+            first = data[0]
+            if not self.synced or first == SNAPSHOT:
+                index = data.find(bytes([SNAPSHOT, SNAPSHOT_2]))
+                if index < 0:
+                    return data[-1:]
+                if len(data) < index + SNAPSHOT_SIZE:
+                    return data[index:]
+                frame = data[index:index + SNAPSHOT_SIZE]
+                check = 0
+                for byte in frame[:-1]:
+                    check ^= byte
+                if check != frame[-1]:
+                    data = data[index + 1:]
+                    self.synced = False
+                    continue
+                self.snapshot(frame)
+                data = data[index + SNAPSHOT_SIZE:]
+            elif first == LOST:
+                if len(data) < 3:
+                    return data
+                self.lost += struct.unpack_from("<H", data, 1)[0]
+                self.synced = False
+                data = data[3:]
+            elif 1 <= first <= MAX_CHANGES:
+                size = 3 + first
+                if len(data) < size:
+                    return data
+                (low,) = struct.unpack_from("<H", data, 1)
+                self.time_us += (low - self.time_us) & 0xFFFF
+                for change in data[3:size]:
+                    self.change(change & ~DEBOUNCED, bool(change & DEBOUNCED))
+                self.frames += 1
+                data = data[size:]
+            else:
+                # Text or garbage, wait for the next snapshot
+                self.synced = False
+                self.resyncs += 1
+                data = data[1:]
+        return data
+
+    def snapshot(self, frame):
+        (self.time_us,) = struct.unpack_from("<I", frame, 2)
+        bitmaps = frame[6:6 + 2 * BITMAP_SIZE]
+        for key in range(KEYS):
+            raw = bool(bitmaps[key // 8] & (1 << (key % 8)))
+            debounced = bool(bitmaps[BITMAP_SIZE + key // 8] & (1 << (key % 8)))
+            if self.synced and (raw != self.raw[key] or
+                                debounced != self.debounced[key]):
+                self.note(f"key {key:2d}: state fixed by snapshot")
+            self.raw[key] = raw
+            self.debounced[key] = debounced
+        self.synced = True
+        self.frames += 1
+
+    def change(self, key, debounced):
+        if key >= KEYS:
+            return
+        if not debounced:
+            self.raw[key] = not self.raw[key]
+            self.edges[key] += 1
+            if self.raw[key]:
+                self.check_ghost(key)
+            return
+
+        state = not self.debounced[key]
+        self.debounced[key] = state
+        # One edge is the registered change, the others bounced
+        self.bounces[key] += max(self.edges[key] - 1, 0)
+        self.edges[key] = 0
+        if state:
+            self.presses[key] += 1
+            self.press_us[key] = self.time_us
+        elif self.time_us - self.press_us[key] < SHORT_PRESS_US:
+            self.chatter[key] += 1
+            held = (self.time_us - self.press_us[key]) / 1000
+            self.note(f"key {key:2d}: chatter, {held:.1f} ms press")
+
+    def check_ghost(self, key):
+        row, col = position(key)
+        for other_row in range(ROWS):
+            for other_col in range(COLS):
+                if other_row == row or other_col == col:
+                    continue
+                corners = [key_at(row, other_col), key_at(other_row, col),
+                           key_at(other_row, other_col)]
+                if all(k is not None and self.raw[k] for k in corners):
+                    self.ghosts[key] += 1
+                    self.note(f"key {key:2d}: possible ghost with "
+                              f"{corners[0]}, {corners[1]}, {corners[2]}")
+                    return
+
+    def draw(self):
+        out = ["\x1b[H\x1b[J"]
+        status = "synced" if self.synced else "waiting for snapshot"
+        out.append(f"lard61 key test, {status}, {self.frames} frames, "
+                   f"{self.lost} lost, {self.resyncs} resyncs\n\n")
+        for row in range(ROWS):
+            cells = []
+            for col in range(COLS):
+                key = key_at(row, col)
+                if key is None:
+                    cells.append(" ")
+                elif self.raw[key] and self.debounced[key]:
+                    cells.append("#")
+                elif self.raw[key]:
+                    cells.append("r")
+                elif self.debounced[key]:
+                    cells.append("d")
+                else:
+                    cells.append(".")
+            out.append("  " + " ".join(cells) + "\n")
+        out.append("\nkey presses bounces chatter ghosts\n")
+        for key in range(KEYS):
+            if self.presses[key] or self.bounces[key] or self.ghosts[key]:
+                flag = " !" if self.chatter[key] or self.ghosts[key] else ""
+                out.append(f"{key:3d} {self.presses[key]:7d} "
+                           f"{self.bounces[key]:7d} {self.chatter[key]:7d} "
+                           f"{self.ghosts[key]:6d}{flag}\n")
+        out.append("\n" + "\n".join(self.log) + "\n")
+        sys.stdout.write("".join(out))
+        sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="CDC serial port of the keyboard")
+    args = parser.parse_args()
+
+    port = Port(args.port)
+    port.command("stream")
+    version = int(port.expect(r"^stream (\d+)$").group(1))
+    if version != VERSION:
+        sys.exit(f"unsupported stream version {version}")
+
+    tester = Tester()
+    data, port.pending = port.pending, b""
+    last_draw = 0.0
+    try:
+        while True:
+            ready, _, _ = select.select([port.fd], [], [], REDRAW_S)
+            if ready:
+                data = tester.parse(data + os.read(port.fd, 4096))
+            now = time.monotonic()
+            if now - last_draw >= REDRAW_S:
+                tester.draw()
+                last_draw = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.command("stream stop")
+
+
+if __name__ == "__main__":
+    main()
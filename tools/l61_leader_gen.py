@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Compile the leader sequence list into the trie tables of lard61_leader.c.
+
+    tools/l61_leader_gen.py usb_device/leader_sequences.txt lard61_leader_table.h
+
+Run by the build. Each line of the list holds a sequence of keys, typed
+after the leader key, and the text it types, in double quotes:
+
+    g c     "git commit "
+    g s     "git status{ENTER}"
+
+Sequence keys are single characters (a key of the US layout, without
+shift) or HID_KEY_* names without the prefix, like ENTER or F5. In the
+text, {NAME} types HID_KEY_NAME, \\" a quote and \\\\ a backslash. Anything
+after a '#' outside of the text is a comment.
+"""
+
+import sys
+
+# US layout: character -> (HID_KEY_* name, shift)
+CHARS = {}
+for c in "abcdefghijklmnopqrstuvwxyz":
+    CHARS[c] = (c.upper(), False)
+    CHARS[c.upper()] = (c.upper(), True)
+for c, shifted in zip("1234567890", "!@#$%^&*()"):
+    CHARS[c] = (c, False)
+    CHARS[shifted] = (c, True)
+for name, plain, shifted in [
+    ("MINUS", "-", "_"),
+    ("EQUAL", "=", "+"),
+    ("BRACKET_LEFT", "[", "{"),
+    ("BRACKET_RIGHT", "]", "}"),
+    ("BACKSLASH", "\\", "|"),
+    ("SEMICOLON", ";", ":"),
+    ("APOSTROPHE", "'", '"'),
+    ("GRAVE", "`", "~"),
+    ("COMMA", ",", "<"),
+    ("PERIOD", ".", ">"),
+    ("SLASH", "/", "?"),
+]:
+    CHARS[plain] = (name, False)
+    CHARS[shifted] = (name, True)
+CHARS[" "] = ("SPACE", False)
+CHARS["\t"] = ("TAB", False)
+CHARS["\n"] = ("ENTER", False)
+
+# Digits are named HID_KEY_0 etc. in TinyUSB
+def usage(name):
+    return f"HID_KEY_{name}"
+
+
+def fail(path, number, message):
+    sys.exit(f"{path}:{number}: {message}")
+
+
+def parse_text(path, number, text):
+    strokes = []
+    i = 0
+    while i < len(text):
+        c = text[i]
+        if c == "{":
+            end = text.find("}", i)
+            if end < 0:
+                fail(path, number, "missing '}'")
+            strokes.append((text[i + 1:end], False))
+            i = end + 1
+            continue
+        if c == "\\":
+            i += 1
+            if i >= len(text):
+                fail(path, number, "dangling backslash")
+            c = text[i]
+        if c not in CHARS:
+            fail(path, number, f"no key types {c!r}")
+        strokes.append(CHARS[c])
+        i += 1
+    return strokes
+
+
+def parse_line(path, number, line):
+    quote = line.find('"')
+    if quote < 0:
+        if line.split("#", 1)[0].strip():
+            fail(path, number, "missing text in double quotes")
+        return None
+
+    keys = []
+    for token in line[:quote].split():
+        if len(token) == 1:
+            if token not in CHARS or CHARS[token][1]:
+                fail(path, number, f"{token!r} is not an unshifted key")
+            keys.append(CHARS[token][0])
+        else:
+            keys.append(token.upper())
+    if not keys:
+        fail(path, number, "empty sequence")
+
+    # Find the closing quote, skipping escaped ones
+    end = quote + 1
+    while end < len(line) and line[end] != '"':
+        end += 2 if line[end] == "\\" else 1
+    if end >= len(line):
+        fail(path, number, "missing closing quote")
+    if line[end + 1:].split("#", 1)[0].strip():
+        fail(path, number, "unexpected text after the closing quote")
+
+    strokes = parse_text(path, number, line[quote + 1:end])
+    if not strokes:
+        fail(path, number, "empty text")
+    return keys, strokes
+
+
+class Node:
+    def __init__(self, key):
+        self.key = key
+        self.children = []
+        self.action = None
+        self.index = 0
+
+
+def build(path):
+    root = Node(None)
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            parsed = parse_line(path, number, line.rstrip("\n"))
+            if parsed is None:
+                continue
+            keys, strokes = parsed
+            node = root
+            for key in keys:
+                child = next((c for c in node.children if c.key == key), None)
+                if child is None:
+                    child = Node(key)
+                    node.children.append(child)
+                node = child
+            if node.action is not None:
+                fail(path, number, "sequence defined twice")
+            node.action = strokes
+    return root
+
+
+def generate(root, source):
+    # Breadth first, so that the children of a node are contiguous
+    nodes = [root]
+    for node in nodes:
+        nodes.extend(node.children)
+    for index, node in enumerate(nodes):
+        node.index = index
+    if len(nodes) >= 0xFFFF:
+        sys.exit("too many leader sequences")
+
+    actions = []
+    strokes = []
+    lines = [
+        f"// Generated by tools/l61_leader_gen.py from {source}, do not edit",
+        "",
+        "static const struct l61_leader_node leader_nodes[] = {",
+    ]
+    for node in nodes:
+        action = "L61_LEADER_NO_ACTION"
+        if node.action is not None:
+            action = str(len(actions))
+            actions.append((len(strokes), len(node.action)))
+            strokes.extend(node.action)
+        first = node.children[0].index if node.children else 0
+        key = usage(node.key) if node.key else "HID_KEY_NONE"
+        lines.append(f"    {{{first}, {action}, {key}, {len(node.children)}}},")
+    lines.append("};")
+    # Actions are indexed by 16-bit values, L61_LEADER_NO_ACTION excluded,
+    # and the strokes of each end at a 16-bit index
+    if len(actions) >= 0xFFFF:
+        sys.exit(f"too many leader actions: {len(actions)}, at most 65534")
+    if len(strokes) > 0xFFFF:
+        sys.exit(f"too many leader strokes: {len(strokes)}, at most 65535")
+    lines.append("")
+    lines.append("static const struct l61_leader_action leader_actions[] = {")
+    for first, count in actions:
+        lines.append(f"    {{{first}, {count}}},")
+    if not actions:
+        lines.append("    {0, 0},")
+    lines.append("};")
+    lines.append("")
+    lines.append("static const uint16_t leader_strokes[] = {")
+    for name, shift in strokes:
+        prefix = "L61_LEADER_SHIFT | " if shift else ""
+        lines.append(f"    {prefix}{usage(name)},")
+    if not strokes:
+        lines.append("    HID_KEY_NONE,")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    source, output = sys.argv[1:]
+    text = generate(build(source), source.split("/")[-1])
+    with open(output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
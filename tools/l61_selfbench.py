@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Run the lard61 self-benchmark and check its keystrokes on the host.
+
+    sudo tools/l61_selfbench.py /dev/ttyACM0 2000 200
+
+Starts `selfbench <strokes> <hz>` on the keyboard, which types letters
+through its real USB path (see usb_device/lard61_selfbench.h), and reads
+them back from the keyboard's input device, grabbed so that they are not
+typed anywhere else. Every keystroke is checked against the sequence the
+keyboard types, and the lost, extra and misordered ones are reported along
+with the intervals between presses seen by the host and the keyboard's own
+results. Reading input devices usually requires root.
+"""
+
+import argparse
+import difflib
+import fcntl
+import os
+import select
+import struct
+import sys
+import time
+
+from l61_serial import Port
+
+# struct input_event on 64-bit Linux, and its event type for keys
+EVENT = struct.Struct("llHHi")
+EV_KEY = 1
+EVIOCGRAB = 0x40044590
+# Linux key codes of the letters a to z
+LETTER_CODES = [30, 48, 46, 32, 18, 33, 34, 35, 23, 36, 37, 38, 50, 49, 24,
+                25, 16, 19, 31, 20, 22, 47, 17, 45, 21, 44]
+# Must match L61_SELFBENCH_SETTLE_US in usb_device/lard61_selfbench.h
+SETTLE_S = 0.05
+
+
+def letter(i):
+    """Letter typed by stroke `i`, as L61_SELFBENCH_LETTER."""
+    return (i * 11) % 26
+
+
+def find_keyboard():
+    """Event device of the lard61 input device which has letter keys."""
+    name = ""
+    handlers = []
+    with open("/proc/bus/input/devices") as f:
+        for line in f.read().splitlines() + [""]:
+            if line.startswith("N: Name="):
+                name = line[8:].strip('"')
+            elif line.startswith("H: Handlers="):
+                handlers = line[12:].split()
+            elif line.startswith("B: KEY="):
+                words = [int(w, 16) for w in line[7:].split()][::-1]
+                bit = LETTER_CODES[0]
+                has_letters = len(words) > bit // 64 and \
+                    words[bit // 64] >> (bit % 64) & 1
+                events = [h for h in handlers if h.startswith("event")]
+                if "lard61" in name and has_letters and events:
+                    return "/dev/input/" + events[0]
+            elif not line:
+                name, handlers = "", []
+    sys.exit("no lard61 keyboard input device found")
+
+
+def percentile(values, p):
+    return sorted(values)[min(len(values) - 1, len(values) * p // 100)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="CDC serial port of the keyboard")
+    parser.add_argument("strokes", type=int, help="number of letters to type")
+    parser.add_argument("hz", type=int, help="strokes per second")
+    parser.add_argument("--input", help="input device, found if not given")
+    args = parser.parse_args()
+
+    device = args.input or find_keyboard()
+    evfd = os.open(device, os.O_RDONLY)
+    fcntl.ioctl(evfd, EVIOCGRAB, 1)
+
+    port = Port(args.port)
+    port.command(f"selfbench {args.strokes} {args.hz}")
+    port.expect(r"^selfbench: typing")
+
+    # Collect presses until the keyboard prints its results
+    presses = []
+    pending = b""
+    deadline = time.monotonic() + args.strokes / args.hz + SETTLE_S + 10.0
+    while b"main loop:" not in port.pending:
+        remaining = deadline - time.monotonic()
+        if remaining <= 0:
+            sys.exit("timed out waiting for the benchmark to finish")
+        ready, _, _ = select.select([evfd, port.fd], [], [], remaining)
+        if evfd in ready:
+            pending += os.read(evfd, EVENT.size * 64)
+            while len(pending) >= EVENT.size:
+                sec, usec, type_, code, value = EVENT.unpack_from(pending)
+                pending = pending[EVENT.size:]
+                if type_ == EV_KEY and value == 1 and code in LETTER_CODES:
+                    presses.append((sec + usec / 1e6,
+                                    LETTER_CODES.index(code)))
+        if port.fd in ready:
+            port.pending += os.read(port.fd, 4096)
+    fcntl.ioctl(evfd, EVIOCGRAB, 0)
+
+    # The keyboard reports a stopped benchmark's actual stroke count
+    summary = port.expect(r"^selfbench: (\d+) strokes.*$")
+    strokes = int(summary.group(1))
+    expected = [letter(i) for i in range(strokes)]
+    received = [p[1] for p in presses]
+    lost = extra = misordered = 0
+    matcher = difflib.SequenceMatcher(None, expected, received, autojunk=False)
+    for tag, i1, i2, j1, j2 in matcher.get_opcodes():
+        if tag == "delete":
+            lost += i2 - i1
+        elif tag == "insert":
+            extra += j2 - j1
+        elif tag == "replace":
+            misordered += min(i2 - i1, j2 - j1)
+            lost += max(0, (i2 - i1) - (j2 - j1))
+            extra += max(0, (j2 - j1) - (i2 - i1))
+
+    print(f"host: {len(received)}/{strokes} presses, {lost} lost, "
+          f"{extra} extra, {misordered} misordered")
+    if len(presses) > 1:
+        intervals = [(b[0] - a[0]) * 1e6 for a, b in zip(presses, presses[1:])]
+        print(f"host press interval: expected {1e6 / args.hz:.0f} us, "
+              f"min {min(intervals):.0f} us, p50 {percentile(intervals, 50):.0f}"
+              f" us, p99 {percentile(intervals, 99):.0f} us, "
+              f"max {max(intervals):.0f} us")
+    print(summary.group(0))
+    for pattern in (r"^reports:.*$", r"^endpoint busy:.*$",
+                    r"^main loop:.*$"):
+        print(port.expect(pattern).group(0))
+    return 0 if lost == 0 and extra == 0 and misordered == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
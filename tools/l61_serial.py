@@ -0,0 +1,56 @@
+"""Line-oriented access to the lard61 CDC shell, shared by the tools."""
+
+import os
+import re
+import select
+import sys
+import termios
+import time
+import tty
+
+
+class Port:
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.pending = b""
+
+    def write(self, data):
+        view = memoryview(data)
+        while view:
+            n = os.write(self.fd, view)
+            view = view[n:]
+
+    def expect(self, pattern, timeout=5.0):
+        """Read lines until one matches `pattern` and return the match."""
+        deadline = time.monotonic() + timeout
+        while True:
+            while b"\n" in self.pending:
+                line, self.pending = self.pending.split(b"\n", 1)
+                text = line.decode(errors="replace").strip("\r")
+                match = re.search(pattern, text)
+                if match:
+                    return match
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit(f"timed out waiting for '{pattern}'")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                self.pending += os.read(self.fd, 4096)
+
+    def read(self, size, timeout=5.0):
+        """Read exactly `size` bytes, after any line already received."""
+        deadline = time.monotonic() + timeout
+        while len(self.pending) < size:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit(f"timed out after {len(self.pending)}/{size} bytes")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                self.pending += os.read(self.fd, 4096)
+        data, self.pending = self.pending[:size], self.pending[size:]
+        return data
+
+    def command(self, line):
+        self.write(line.encode() + b"\r")
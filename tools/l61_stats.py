@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Export the lard61 keystroke counters from its CDC serial port.
+
+    tools/l61_stats.py /dev/ttyACM0
+    tools/l61_stats.py /dev/ttyACM0 --save stats.bin
+    tools/l61_stats.py --load stats.bin
+
+Prints the presses of every key laid out as the key matrix, per layer, and
+the histograms of the time between presses and of how long keys are held.
+The binary format is struct l61_analytics, see
+usb_device/lard61_analytics.h.
+"""
+
+import argparse
+import struct
+import sys
+
+from l61_serial import Port
+
+MAGIC = 0x6C363173
+VERSION = 1
+ROWS = 5
+COLS = 14
+LAYERS = ["base", "fn"]
+HIST_BINS = 16
+# First key index of each row, from n_keys_in_row in lard61_keymatrix.c
+ROW_OFFSETS = [0, 14, 28, 41, 53, 53 + COLS]
+
+
+def decode(data):
+    magic, version, keys, layers = struct.unpack_from("<IHBB", data)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("not a version 1 keystroke counter dump")
+    offset = 8
+    presses = []
+    for _ in range(layers):
+        presses.append(struct.unpack_from(f"<{keys}I", data, offset))
+        offset += 4 * keys
+    interval = struct.unpack_from(f"<{HIST_BINS}I", data, offset)
+    hold = struct.unpack_from(f"<{HIST_BINS}I", data, offset + 4 * HIST_BINS)
+    return presses, interval, hold
+
+
+def bin_name(i):
+    if i == 0:
+        return "< 1 ms"
+    if i == HIST_BINS - 1:
+        return f">= {1 << (i - 1)} ms"
+    return f"{1 << (i - 1)}-{(1 << i) - 1} ms"
+
+
+def print_hist(title, hist):
+    total = sum(hist)
+    print(f"\n{title} ({total}):")
+    if total == 0:
+        return
+    for i, count in enumerate(hist):
+        if count:
+            bar = "#" * max(1, round(40 * count / max(hist)))
+            print(f"  {bin_name(i):>12} {count:8d} {bar}")
+
+
+def show(data):
+    presses, interval, hold = decode(data)
+    for layer, counts in enumerate(presses):
+        name = LAYERS[layer] if layer < len(LAYERS) else str(layer)
+        print(f"[{name}] {sum(counts)} presses")
+        for row in range(ROWS):
+            first, last = ROW_OFFSETS[row], ROW_OFFSETS[row + 1]
+            print(" ".join(f"{counts[k]:6d}" for k in range(first, last)))
+    print_hist("time between presses", interval)
+    print_hist("hold time", hold)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?", help="CDC serial port")
+    parser.add_argument("--save", help="also write the binary dump here")
+    parser.add_argument("--load", help="show a saved dump instead")
+    args = parser.parse_args()
+
+    if args.load:
+        with open(args.load, "rb") as f:
+            data = f.read()
+    elif args.port:
+        port = Port(args.port)
+        port.command("stats dump")
+        size = int(port.expect(r"^binary (\d+)$").group(1))
+        data = port.read(size)
+    else:
+        parser.error("a port or --load is needed")
+
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+    show(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""Update the lard61 firmware over its CDC serial port.
+
+The keyboard must run a firmware built with -DL61_AB_UPDATE=ON. It reports
+which slot it is not running from, and this script sends the image linked
+for that slot from the build directory:
+
+    tools/l61_update.py /dev/ttyACM0 build/usb_device
+"""
+
+import argparse
+import os
+import sys
+import time
+import zlib
+
+from l61_serial import Port
+
+IMAGES = {"a": "usb_device.bin", "b": "usb_device_slot_b.bin"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="CDC serial port of the keyboard")
+    parser.add_argument("build_dir", help="directory with the usb_device images")
+    args = parser.parse_args()
+
+    port = Port(args.port)
+    port.command("update")
+    slot = port.expect(r"update slot ([ab])|update: not supported")
+    if not slot.group(1):
+        sys.exit("the keyboard firmware was built without L61_AB_UPDATE")
+    slot = slot.group(1)
+
+    path = os.path.join(args.build_dir, IMAGES[slot])
+    with open(path, "rb") as f:
+        image = f.read()
+    crc = zlib.crc32(image)
+    print(f"sending {path} ({len(image)} bytes, crc {crc:08x}) to slot {slot}")
+
+    start = time.monotonic()
+    port.command(f"update {len(image)} {crc:08x}")
+    reply = port.expect(r"^ready$|update: .*").group(0)
+    if reply != "ready":
+        sys.exit(reply)
+    port.write(image)
+    result = port.expect(r"update: .*", timeout=30.0).group(0)
+    print(f"{result} ({time.monotonic() - start:.1f}s)")
+    if "ok" not in result:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+/*
+** file: lard61_analytics.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** l61_analytics_key runs in the scan, possibly from an alarm interrupt, so
+** it only increments counters. Saving copies them with interrupts disabled
+** first, so the copy written to flash is consistent.
+*/
+
+#include "lard61_analytics.h"
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_hot.h"
+#include "lard61_selfbench.h"
+#include "pico/time.h"
+
+_Static_assert(sizeof(struct l61_analytics) <= L61_CONFIG_ITEM_MAX_SIZE,
+               "analytics must fit in a config item");
+
+// Number of keys listed by l61_analytics_print
+#define TOP_KEYS 8
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct l61_analytics counters;
+// Copy being written to flash
+static struct l61_analytics saved;
+
+// Time of the last press of each key, and of any key
+static uint32_t press_us[L61_ANALYTICS_KEY_COUNT];
+static uint32_t last_press_us = 0;
+static bool pressed_once = false;
+
+// Time of the last key state change, and of the last save in ms
+static volatile uint32_t activity_us = 0;
+static uint32_t saved_ms = 0;
+static volatile bool dirty = false;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t now_ms() {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+static void L61_HOT_FUNC(record)(uint32_t* hist, uint32_t us) {
+  uint32_t ms = us / 1000;
+  uint bin = ms == 0 ? 0 : 32 - __builtin_clz(ms);
+  if (bin >= L61_ANALYTICS_HIST_BINS)
+    bin = L61_ANALYTICS_HIST_BINS - 1;
+  hist[bin]++;
+}
+
+static void init_header(struct l61_analytics* a) {
+  a->magic = L61_ANALYTICS_MAGIC;
+  a->version = L61_ANALYTICS_VERSION;
+  a->key_count = L61_ANALYTICS_KEY_COUNT;
+  a->layer_count = L61_LAYER_COUNT;
+}
+
+static uint32_t key_presses(uint key) {
+  uint32_t total = 0;
+  for (uint layer = 0; layer < L61_LAYER_COUNT; ++layer)
+    total += counters.presses[layer][key];
+  return total;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_analytics_setup() {
+  if (!l61_config_load(L61_CONFIG_ANALYTICS, &counters, sizeof(counters)) ||
+      counters.magic != L61_ANALYTICS_MAGIC ||
+      counters.version != L61_ANALYTICS_VERSION) {
+    memset(&counters, 0, sizeof(counters));
+    init_header(&counters);
+  }
+  saved_ms = now_ms();
+}
+
+void L61_HOT_FUNC(l61_analytics_key)(uint key,
+                                     bool pressed,
+                                     uint32_t now_us) {
+  if (l61_selfbench_is_active())
+    return;
+  if (pressed) {
+    uint layer = l61_keymatrix_is_fn_key_pressed() ? L61_LAYER_FN
+                                                   : L61_LAYER_BASE;
+    counters.presses[layer][key]++;
+    if (pressed_once)
+      record(counters.interval_hist, now_us - last_press_us);
+    pressed_once = true;
+    last_press_us = now_us;
+    press_us[key] = now_us;
+  } else {
+    record(counters.hold_hist, now_us - press_us[key]);
+  }
+  activity_us = now_us;
+  dirty = true;
+}
+
+void l61_analytics_task() {
+  if (!dirty)
+    return;
+  uint32_t idle_us = time_us_32() - activity_us;
+  if (now_ms() - saved_ms >= L61_ANALYTICS_SAVE_INTERVAL_MS &&
+      idle_us >= L61_ANALYTICS_IDLE_MS * 1000) {
+    l61_analytics_save();
+  }
+}
+
+void l61_analytics_save() {
+  uint32_t status = save_and_disable_interrupts();
+  saved = counters;
+  dirty = false;
+  restore_interrupts(status);
+
+  l61_config_store(L61_CONFIG_ANALYTICS, &saved, sizeof(saved));
+  saved_ms = now_ms();
+}
+
+void l61_analytics_reset() {
+  uint32_t status = save_and_disable_interrupts();
+  memset(&counters, 0, sizeof(counters));
+  init_header(&counters);
+  pressed_once = false;
+  dirty = false;
+  restore_interrupts(status);
+
+  l61_config_clear(L61_CONFIG_ANALYTICS);
+}
+
+void l61_analytics_print() {
+  uint32_t total[L61_LAYER_COUNT] = {0};
+  for (uint layer = 0; layer < L61_LAYER_COUNT; ++layer) {
+    for (uint key = 0; key < L61_ANALYTICS_KEY_COUNT; ++key)
+      total[layer] += counters.presses[layer][key];
+  }
+  l61_printf("presses: %lu base, %lu fn%s\n", total[L61_LAYER_BASE],
+             total[L61_LAYER_FN], dirty ? " (not saved yet)" : "");
+
+  // Selection of the most pressed keys, without sorting the whole table
+  bool listed[L61_ANALYTICS_KEY_COUNT] = {false};
+  l61_printf("top keys:");
+  for (uint n = 0; n < TOP_KEYS; ++n) {
+    int best = -1;
+    for (uint key = 0; key < L61_ANALYTICS_KEY_COUNT; ++key) {
+      if (!listed[key] && key_presses(key) > 0 &&
+          (best < 0 || key_presses(key) > key_presses(best)))
+        best = key;
+    }
+    if (best < 0)
+      break;
+    listed[best] = true;
+    l61_printf(" %d:%lu", best, key_presses(best));
+  }
+  l61_printf("\n");
+}
+
+uint32_t l61_analytics_read(uint32_t offset, void* data, uint32_t len) {
+  if (offset >= sizeof(counters))
+    return 0;
+  if (len > sizeof(counters) - offset)
+    len = sizeof(counters) - offset;
+  // Counters may be incremented meanwhile, which makes the dump slightly
+  // inconsistent at worst
+  memcpy(data, (const uint8_t*)&counters + offset, len);
+  return len;
+}
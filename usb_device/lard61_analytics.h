@@ -0,0 +1,71 @@
+/*
+** file: lard61_analytics.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Keystroke counters, to make layout decisions and estimate switch wear:
+** presses per key and layer, and histograms of the time between two
+** presses and of how long keys are held.
+**
+** Counting is done in RAM by the scan. The counters are saved to the
+** config area in batches, at most every L61_ANALYTICS_SAVE_INTERVAL_MS and
+** only once the keyboard has been idle for L61_ANALYTICS_IDLE_MS, since
+** writing the flash stalls the keyboard.
+**
+** `stats dump` sends struct l61_analytics as is (little endian) with
+** l61_cdc_send_binary, see tools/l61_stats.py.
+*/
+
+#ifndef _LARD61_ANALYTICS_H
+#define _LARD61_ANALYTICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+
+#define L61_ANALYTICS_MAGIC 0x6c363173
+#define L61_ANALYTICS_VERSION 1
+
+#define L61_ANALYTICS_KEY_COUNT (N_ROWS * N_COLS)
+// Histogram bin 0 counts times under 1 ms, bin i times in
+// [2^(i-1), 2^i) ms, and the last bin anything longer
+#define L61_ANALYTICS_HIST_BINS 16
+
+#define L61_ANALYTICS_SAVE_INTERVAL_MS (15 * 60 * 1000)
+#define L61_ANALYTICS_IDLE_MS 5000
+
+struct l61_analytics {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t key_count;
+  uint8_t layer_count;
+  // Registered presses, by the layer active when the key went down
+  uint32_t presses[L61_LAYER_COUNT][L61_ANALYTICS_KEY_COUNT];
+  // Time between two consecutive presses, of any keys
+  uint32_t interval_hist[L61_ANALYTICS_HIST_BINS];
+  // Time between the press and release of a key
+  uint32_t hold_hist[L61_ANALYTICS_HIST_BINS];
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the saved counters
+void l61_analytics_setup();
+// Count a registered key state change, called by the debouncer
+void l61_analytics_key(uint key, bool pressed, uint32_t now_us);
+// Save the counters when due and the keyboard is idle
+void l61_analytics_task();
+// Save the counters now
+void l61_analytics_save();
+// Zero the counters, in RAM and in flash
+void l61_analytics_reset();
+
+// Print the total and most pressed keys via l61_printf
+void l61_analytics_print();
+// Read function for l61_cdc_send_binary
+uint32_t l61_analytics_read(uint32_t offset, void* data, uint32_t len);
+
+#endif /* _LARD61_ANALYTICS_H */
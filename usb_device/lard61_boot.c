@@ -0,0 +1,102 @@
+/*
+** file: lard61_boot.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Timestamps come from the microsecond timer, which only starts ticking
+** once clocks_init has brought up the crystal oscillator. Time spent in
+** boot2, in the ROM and waiting for the XOSC (see lard61.h) is therefore
+** not included: the first phase shows how long the rest of the SDK runtime
+** initialisation took.
+**
+** The logs live in uninitialised RAM. A power cycle leaves garbage in it,
+** which the magic number lets us detect; a watchdog or software reset keeps
+** it, so the log of the previous boot remains readable.
+*/
+
+#include "lard61_boot.h"
+
+#include <string.h>
+#include "hardware/timer.h"
+#include "lard61_cdc.h"
+#include "pico/platform.h"
+
+#define BOOT_LOG_MAGIC 0x6c363162  // "l61b"
+
+struct boot_log {
+  uint32_t magic;
+  // Number of boots since the last power cycle
+  uint32_t boot_count;
+  // Bitmask of the phases recorded in time_us
+  uint32_t marked;
+  uint32_t time_us[L61_BOOT_PHASE_COUNT];
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// [0] is the log of the current boot, [1] the log of the previous one
+static struct boot_log __uninitialized_ram(boot_logs)[2];
+
+static const char* const phase_names[L61_BOOT_PHASE_COUNT] = {
+    [L61_BOOT_MAIN] = "main",
+    [L61_BOOT_USB_INIT] = "usb init",
+    [L61_BOOT_KEYMATRIX_SETUP] = "keymatrix setup",
+    [L61_BOOT_MAIN_LOOP] = "main loop",
+    [L61_BOOT_FIRST_SOF] = "first SOF",
+    [L61_BOOT_MOUNTED] = "mounted",
+    [L61_BOOT_FIRST_REPORT] = "first report",
+    [L61_BOOT_FIRST_KEY] = "first keypress",
+};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void print_log(const struct boot_log* log) {
+  for (uint i = 0; i < L61_BOOT_PHASE_COUNT; ++i) {
+    if (log->marked & (1u << i)) {
+      l61_printf("  %-16s %8lu us\n", phase_names[i], log->time_us[i]);
+    } else {
+      l61_printf("  %-16s        -\n", phase_names[i]);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_boot_init() {
+  uint32_t now = time_us_32();
+
+  if (boot_logs[0].magic == BOOT_LOG_MAGIC) {
+    boot_logs[1] = boot_logs[0];
+    boot_logs[0].boot_count++;
+  } else {
+    // Power cycle: nothing to keep
+    memset(boot_logs, 0, sizeof(boot_logs));
+    boot_logs[0].magic = BOOT_LOG_MAGIC;
+    boot_logs[0].boot_count = 1;
+  }
+
+  boot_logs[0].marked = 1u << L61_BOOT_MAIN;
+  boot_logs[0].time_us[L61_BOOT_MAIN] = now;
+}
+
+void l61_boot_mark(enum l61_boot_phase phase) {
+  if (boot_logs[0].marked & (1u << phase))
+    return;
+  boot_logs[0].time_us[phase] = time_us_32();
+  boot_logs[0].marked |= 1u << phase;
+}
+
+void l61_boot_print_log() {
+  l61_printf("boot #%lu since power on:\n", boot_logs[0].boot_count);
+  print_log(&boot_logs[0]);
+  if (boot_logs[1].magic == BOOT_LOG_MAGIC) {
+    l61_printf("previous boot:\n");
+    print_log(&boot_logs[1]);
+  }
+}
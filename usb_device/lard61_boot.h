@@ -0,0 +1,46 @@
+/*
+** file: lard61_boot.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Boot phase timestamps, kept in a RAM log which is not cleared on reset,
+** so the previous boot can also be inspected after a soft reboot.
+*/
+
+#ifndef _LARD61_BOOT_H
+#define _LARD61_BOOT_H
+
+#include "pico/types.h"
+
+enum l61_boot_phase {
+  // Entered main()
+  L61_BOOT_MAIN,
+  // tud_init returned, the device is visible on the bus
+  L61_BOOT_USB_INIT,
+  // Key matrix GPIOs and scan scheduling are set up
+  L61_BOOT_KEYMATRIX_SETUP,
+  // Remaining setup done, entering the main loop
+  L61_BOOT_MAIN_LOOP,
+  // First start of frame from the host
+  L61_BOOT_FIRST_SOF,
+  // USB configuration set by the host
+  L61_BOOT_MOUNTED,
+  // First keyboard report sent
+  L61_BOOT_FIRST_REPORT,
+  // First keyboard report with a key pressed
+  L61_BOOT_FIRST_KEY,
+  L61_BOOT_PHASE_COUNT
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Start a new boot log. Must be the first thing called in main().
+void l61_boot_init();
+// Timestamp a boot phase. Only the first call for each phase is recorded.
+void l61_boot_mark(enum l61_boot_phase phase);
+// Print the boot log of this boot and of the previous one via l61_printf
+void l61_boot_print_log();
+
+#endif /* _LARD61_BOOT_H */
@@ -0,0 +1,109 @@
+/*
+** file: lard61_bootctl.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Records are appended, one per flash page, to one of two sectors. When the
+** current sector is full, the other one is erased and written to instead,
+** so the latest record survives a power loss in the middle of an erase.
+** Reading scans both sectors for the valid record with the highest seq.
+*/
+
+#include "lard61_bootctl.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "lard61_crc.h"
+#include "lard61_flash.h"
+
+#define RECORDS_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define RECORD_COUNT (L61_FLASH_BOOTCTL_SIZE / FLASH_PAGE_SIZE)
+
+_Static_assert(sizeof(struct l61_bootctl) <= FLASH_PAGE_SIZE,
+               "boot control record must fit in a flash page");
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t record_offset(uint index) {
+  return L61_FLASH_BOOTCTL_OFFSET + index * FLASH_PAGE_SIZE;
+}
+
+static uint32_t record_crc(const struct l61_bootctl* ctl) {
+  return l61_crc32(L61_CRC32_INIT, ctl, offsetof(struct l61_bootctl, crc));
+}
+
+static bool record_valid(const struct l61_bootctl* ctl) {
+  return ctl->magic == L61_BOOTCTL_MAGIC && ctl->crc == record_crc(ctl) &&
+         ctl->active_slot < L61_FLASH_SLOT_COUNT &&
+         ctl->previous_slot < L61_FLASH_SLOT_COUNT;
+}
+
+static bool record_erased(const struct l61_bootctl* ctl) {
+  const uint8_t* bytes = (const uint8_t*)ctl;
+  for (uint i = 0; i < sizeof(*ctl); ++i) {
+    if (bytes[i] != 0xff)
+      return false;
+  }
+  return true;
+}
+
+// Index of the latest valid record, or -1 if there is none
+static int find_latest() {
+  int latest = -1;
+  uint32_t latest_seq = 0;
+  for (uint i = 0; i < RECORD_COUNT; ++i) {
+    const struct l61_bootctl* ctl = l61_flash_ptr(record_offset(i));
+    if (record_valid(ctl) && (latest < 0 || ctl->seq > latest_seq)) {
+      latest = i;
+      latest_seq = ctl->seq;
+    }
+  }
+  return latest;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+bool l61_bootctl_read(struct l61_bootctl* ctl) {
+  int latest = find_latest();
+  if (latest < 0) {
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->magic = L61_BOOTCTL_MAGIC;
+    ctl->confirmed = 1;
+    return false;
+  }
+  memcpy(ctl, l61_flash_ptr(record_offset(latest)), sizeof(*ctl));
+  return true;
+}
+
+void l61_bootctl_write(struct l61_bootctl* ctl) {
+  int latest = find_latest();
+  uint next = 0;
+  ctl->seq = 0;
+  if (latest >= 0) {
+    const struct l61_bootctl* prev = l61_flash_ptr(record_offset(latest));
+    next = (latest + 1) % RECORD_COUNT;
+    ctl->seq = prev->seq + 1;
+  }
+  ctl->magic = L61_BOOTCTL_MAGIC;
+  ctl->crc = record_crc(ctl);
+
+  // A dirty page (e.g. from an interrupted write) cannot be programmed:
+  // move on to the other sector, which does not hold the latest record
+  if (next % RECORDS_PER_SECTOR != 0 &&
+      !record_erased(l61_flash_ptr(record_offset(next)))) {
+    next = (next - next % RECORDS_PER_SECTOR + RECORDS_PER_SECTOR) %
+           RECORD_COUNT;
+  }
+  if (next % RECORDS_PER_SECTOR == 0) {
+    l61_flash_erase(record_offset(next), FLASH_SECTOR_SIZE);
+  }
+
+  uint8_t page[FLASH_PAGE_SIZE];
+  memset(page, 0xff, sizeof(page));
+  memcpy(page, ctl, sizeof(*ctl));
+  l61_flash_program(record_offset(next), page, sizeof(page));
+}
@@ -0,0 +1,55 @@
+/*
+** file: lard61_bootctl.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Boot control record, shared between the bootloader and the firmware.
+**
+** It tells the bootloader which slot to start, and whether the image in
+** that slot has been confirmed to work. An unconfirmed image is started at
+** most L61_BOOTCTL_MAX_ATTEMPTS times, under a watchdog, before the
+** bootloader falls back to the previous slot.
+*/
+
+#ifndef _LARD61_BOOTCTL_H
+#define _LARD61_BOOTCTL_H
+
+#include "pico/types.h"
+
+#define L61_BOOTCTL_MAGIC 0x6c366263
+// Number of times an unconfirmed image is started before rolling back
+#define L61_BOOTCTL_MAX_ATTEMPTS 3
+// Watchdog timeout while running an unconfirmed image. The RP2040 watchdog
+// counts up to about 8.3s.
+#define L61_BOOTCTL_TRIAL_WATCHDOG_MS 8000
+
+struct l61_bootctl {
+  uint32_t magic;
+  // Incremented on every write, the record with the highest value wins
+  uint32_t seq;
+  // Slot to start, 0 (A) or 1 (B)
+  uint8_t active_slot;
+  // Whether the image in the active slot has run successfully
+  uint8_t confirmed;
+  // Number of times the unconfirmed image was started
+  uint8_t boot_attempts;
+  // Slot to go back to if the active one fails
+  uint8_t previous_slot;
+  // Size and CRC-32 of the image in each slot, 0 if unknown
+  uint32_t image_size[2];
+  uint32_t image_crc[2];
+  // CRC-32 of all the fields above
+  uint32_t crc;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Read the latest valid record. If there is none, fill `ctl` with the
+// default (slot A, confirmed) and return false.
+bool l61_bootctl_read(struct l61_bootctl* ctl);
+// Store `ctl` as the new latest record, updating its seq and crc
+void l61_bootctl_write(struct l61_bootctl* ctl);
+
+#endif /* _LARD61_BOOTCTL_H */
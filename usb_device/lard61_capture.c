@@ -0,0 +1,232 @@
+/*
+** file: lard61_capture.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Events are only recorded from the scan, which never runs concurrently
+** with itself, so the ring has a single writer. Dumps read it from the main
+** loop after setting `frozen`, which the scan checks before writing.
+**
+** The debouncer learns as it goes, so its output for a given raw input
+** depends on everything it saw before. To replay a capture exactly, each
+** segment starts with a checkpoint of the debouncer state, saved at the
+** beginning of a scan. A new segment is started when the current one might
+** not have room for the words of one more scan: at most two events per key,
+** raw and debounced in eager mode, or a quiet scan word, plus a time
+** extension word and a settings word.
+*/
+
+#include "lard61_capture.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "lard61_hot.h"
+
+_Static_assert(sizeof(struct l61_capture_header) % sizeof(uint32_t) == 0,
+               "event words must stay aligned after the header");
+
+_Static_assert(L61_DEBOUNCE_KEY_COUNT <= L61_CAPTURE_KEY_SETTINGS,
+               "key indices must not collide with the special words");
+
+#define SCAN_MAX_WORDS (2 * L61_DEBOUNCE_KEY_COUNT + 2)
+
+_Static_assert(SCAN_MAX_WORDS <= L61_CAPTURE_SEGMENT_WORDS,
+               "a segment must hold the words of a whole scan");
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct {
+  uint32_t words[L61_CAPTURE_SEGMENT_WORDS];
+  uint32_t count;
+  // Time the first delta is relative to, and time of the checkpoint
+  uint32_t base_time_us;
+  uint32_t checkpoint_time_us;
+  struct l61_debounce_state checkpoint;
+} segments[2];
+
+// Segment being written, and whether the other one holds older events
+static uint current = 0;
+static bool wrapped = false;
+// Cleared to start a new capture at the next scan
+static volatile bool started = false;
+
+// Time of the last event
+static uint32_t last_time_us = 0;
+
+// Average scan period, in 1/16 us
+static uint32_t scan_period_16 = 0;
+static uint32_t last_scan_us = 0;
+
+static volatile bool frozen = false;
+static struct l61_capture_header frozen_header;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static struct l61_debounce_state* L61_HOT_FUNC(start_segment)(
+    uint index,
+    uint32_t now_us) {
+  segments[index].count = 0;
+  segments[index].base_time_us = last_time_us;
+  segments[index].checkpoint_time_us = now_us;
+  return &segments[index].checkpoint;
+}
+
+static void L61_HOT_FUNC(push)(uint32_t word) {
+  // Never reached while SCAN_MAX_WORDS holds, but the scan runs in an
+  // interrupt and must not write past the segment
+  if (segments[current].count < L61_CAPTURE_SEGMENT_WORDS)
+    segments[current].words[segments[current].count++] = word;
+}
+
+// Push the word for an event at `now_us`, with `bits` giving its key and
+// flags, preceded by a time extension word if needed
+static void L61_HOT_FUNC(record)(uint32_t bits, uint32_t now_us) {
+  if (frozen || !started)
+    return;
+
+  uint32_t delta = now_us - last_time_us;
+  last_time_us = now_us;
+
+  if (delta > L61_CAPTURE_DELTA_MAX) {
+    push(L61_CAPTURE_KEY_TIME | (delta >> 20) << L61_CAPTURE_DELTA_SHIFT);
+    delta &= L61_CAPTURE_DELTA_MAX;
+  }
+  push(bits | delta << L61_CAPTURE_DELTA_SHIFT);
+}
+
+// Segment holding the oldest events
+static uint oldest() {
+  return wrapped ? current ^ 1 : current;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+struct l61_debounce_state* L61_HOT_FUNC(l61_capture_scan)(uint32_t now_us) {
+  if (last_scan_us != 0) {
+    uint32_t period_16 = (now_us - last_scan_us) << 4;
+    if (scan_period_16 == 0)
+      scan_period_16 = period_16;
+    else
+      scan_period_16 += ((int32_t)(period_16 - scan_period_16)) / 16;
+  }
+  last_scan_us = now_us;
+
+  if (frozen)
+    return NULL;
+
+  if (!started) {
+    started = true;
+    current = 0;
+    wrapped = false;
+    last_time_us = now_us;
+    return start_segment(current, now_us);
+  }
+
+  if (segments[current].count + SCAN_MAX_WORDS > L61_CAPTURE_SEGMENT_WORDS) {
+    current ^= 1;
+    wrapped = true;
+    return start_segment(current, now_us);
+  }
+  return NULL;
+}
+
+void L61_HOT_FUNC(l61_capture_event)(uint8_t key,
+                                     bool debounced,
+                                     bool state,
+                                     uint32_t now_us) {
+  record((key & L61_CAPTURE_KEY_MASK) | (state ? L61_CAPTURE_STATE_BIT : 0) |
+             (debounced ? L61_CAPTURE_DEBOUNCED_BIT : 0),
+         now_us);
+}
+
+void L61_HOT_FUNC(l61_capture_quiet_scan)(uint32_t now_us) {
+  record(L61_CAPTURE_KEY_SCAN, now_us);
+}
+
+void L61_HOT_FUNC(l61_capture_settings)(enum l61_debounce_mode mode,
+                                        uint16_t window_us) {
+  if (frozen || !started)
+    return;
+  // The next event word carries the time
+  push(L61_CAPTURE_KEY_SETTINGS |
+       (mode == L61_DEBOUNCE_EAGER ? L61_CAPTURE_SETTINGS_EAGER_BIT : 0) |
+       (uint32_t)window_us << L61_CAPTURE_SETTINGS_WINDOW_SHIFT);
+}
+
+void l61_capture_clear() {
+  // The next scan starts over with a new checkpoint
+  started = false;
+}
+
+uint32_t l61_capture_freeze() {
+  frozen = true;
+
+  struct l61_capture_header* h = &frozen_header;
+  memset(h, 0, sizeof(*h));
+  h->magic = L61_CAPTURE_MAGIC;
+  h->version = L61_CAPTURE_VERSION;
+  h->key_count = L61_DEBOUNCE_KEY_COUNT;
+  h->scan_period_us = scan_period_16 >> 4;
+  if (started) {
+    const uint old = oldest();
+    h->word_count = l61_capture_get_word_count();
+    h->checkpoint_time_us = segments[old].checkpoint_time_us;
+    h->base_time_us = segments[old].base_time_us;
+    h->checkpoint = segments[old].checkpoint;
+  }
+  return sizeof(*h) + h->word_count * sizeof(uint32_t);
+}
+
+uint32_t l61_capture_read(uint32_t offset, void* data, uint32_t len) {
+  uint8_t* out = data;
+  uint32_t copied = 0;
+
+  // Header first
+  if (offset < sizeof(frozen_header)) {
+    uint32_t n = sizeof(frozen_header) - offset;
+    if (n > len)
+      n = len;
+    memcpy(out, (const uint8_t*)&frozen_header + offset, n);
+    copied += n;
+    offset += n;
+  }
+
+  if (offset < sizeof(frozen_header))
+    return copied;
+
+  // Then the words, oldest first. Words are copied whole or not at all.
+  const uint old = oldest();
+  const uint32_t old_count = wrapped ? segments[old].count : 0;
+  uint32_t word = (offset - sizeof(frozen_header)) / sizeof(uint32_t);
+  while (word < frozen_header.word_count &&
+         len - copied >= sizeof(uint32_t)) {
+    const uint32_t* src = word < old_count
+                              ? &segments[old].words[word]
+                              : &segments[current].words[word - old_count];
+    memcpy(out + copied, src, sizeof(uint32_t));
+    copied += sizeof(uint32_t);
+    word++;
+  }
+  return copied;
+}
+
+void l61_capture_resume() {
+  l61_capture_clear();
+  frozen = false;
+}
+
+uint32_t l61_capture_get_word_count() {
+  if (!started)
+    return 0;
+  return segments[current].count + (wrapped ? segments[current ^ 1].count : 0);
+}
+
+uint32_t l61_capture_get_scan_period_us() {
+  return scan_period_16 >> 4;
+}
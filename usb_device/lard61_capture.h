@@ -0,0 +1,111 @@
+/*
+** file: lard61_capture.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Always-on capture of the last L61_CAPTURE_WORDS raw and debounced key
+** events, to reproduce missed or doubled keys reported from the field.
+**
+** Events are recorded by lard61_debounce.c and stored as 32-bit words with
+** the time elapsed since the previous event. The ring is made of two
+** segments. Each one starts with a checkpoint of the debouncer state, and
+** when the current segment is full, the older one is overwritten. A capture
+** is serialized as a struct l61_capture_header holding the checkpoint of
+** its oldest segment, followed by the event words, oldest first, all little
+** endian. host/l61_replay replays it through the firmware's debounce and
+** report code from that checkpoint.
+**
+** The window override, and a change of debounce mode between two
+** checkpoints, are recorded in a settings word. It has no delta of its own
+** and applies from the scan of the next event word.
+*/
+
+#ifndef _LARD61_CAPTURE_H
+#define _LARD61_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_debounce.h"
+
+// Capacity of the ring, in two segments. Most events take one word.
+#define L61_CAPTURE_WORDS 4096
+#define L61_CAPTURE_SEGMENT_WORDS (L61_CAPTURE_WORDS / 2)
+
+#define L61_CAPTURE_MAGIC 0x6c363163
+#define L61_CAPTURE_VERSION 2
+
+// Layout of an event word
+#define L61_CAPTURE_KEY_MASK 0x7fu
+// Key state after the event
+#define L61_CAPTURE_STATE_BIT (1u << 7)
+// Set for debounced events, clear for raw ones
+#define L61_CAPTURE_DEBOUNCED_BIT (1u << 8)
+// Microseconds since the previous event
+#define L61_CAPTURE_DELTA_SHIFT 12
+#define L61_CAPTURE_DELTA_MAX 0xfffffu
+// Key value of a word which records the debounce settings, see
+// l61_capture_settings. It holds flags instead of a delta.
+#define L61_CAPTURE_KEY_SETTINGS 0x7du
+#define L61_CAPTURE_SETTINGS_EAGER_BIT (1u << L61_CAPTURE_DELTA_SHIFT)
+// Window override of every key, 0 for the learned windows
+#define L61_CAPTURE_SETTINGS_WINDOW_SHIFT (L61_CAPTURE_DELTA_SHIFT + 1)
+// Key value of a word which only records a scan, see l61_capture_quiet_scan
+#define L61_CAPTURE_KEY_SCAN 0x7eu
+// Key value of a word which only carries the upper bits of the delta of the
+// next event, when it does not fit in L61_CAPTURE_DELTA_MAX
+#define L61_CAPTURE_KEY_TIME 0x7fu
+
+struct l61_capture_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t key_count;
+  // Number of event words following the header
+  uint32_t word_count;
+  // Time the checkpoint was taken
+  uint32_t checkpoint_time_us;
+  // Time the delta of the first event is relative to. This is the time of
+  // the event preceding it, or the checkpoint time.
+  uint32_t base_time_us;
+  // Average time between two scans
+  uint32_t scan_period_us;
+  // Debouncer state before the first event
+  struct l61_debounce_state checkpoint;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Record that a scan happened, to estimate the scan period.
+// When a new segment starts, return where the debouncer must save its
+// current state, before recording any event of this scan. Otherwise NULL.
+struct l61_debounce_state* l61_capture_scan(uint32_t now_us);
+// Record a raw or debounced key state change
+void l61_capture_event(uint8_t key,
+                       bool debounced,
+                       bool state,
+                       uint32_t now_us);
+// Record a scan which found a key bouncing but produced no event. Such scans
+// decide when bursts end, so replaying needs their times. Other scans
+// without events do not change the debouncer state.
+void l61_capture_quiet_scan(uint32_t now_us);
+// Record the debounce mode and window override used from the next event on
+void l61_capture_settings(enum l61_debounce_mode mode, uint16_t window_us);
+// Forget all the events
+void l61_capture_clear();
+
+// Stop recording and snapshot the header, so the capture can be read
+// consistently. Return its size in bytes.
+uint32_t l61_capture_freeze();
+// Copy up to `len` bytes of the frozen capture from `offset`.
+// Return the number of bytes copied.
+uint32_t l61_capture_read(uint32_t offset, void* data, uint32_t len);
+// Start a new capture after l61_capture_freeze. The events missed while
+// frozen would make the old one impossible to replay.
+void l61_capture_resume();
+
+// Number of event words currently held, and average scan period
+uint32_t l61_capture_get_word_count();
+uint32_t l61_capture_get_scan_period_us();
+
+#endif /* _LARD61_CAPTURE_H */
@@ -17,6 +17,26 @@
 #include <stdarg.h>
 
 #include "class/cdc/cdc_device.h"
+#include "lard61_analytics.h"
+#include "lard61_boot.h"
+#include "lard61_capture.h"
+#include "lard61_cycles.h"
+#include "lard61_debounce.h"
+#include "lard61_health.h"
+#include "lard61_hid.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+#include "lard61_led.h"
+#include "lard61_macro.h"
+#include "lard61_mousekeys.h"
+#include "lard61_profile.h"
+#include "lard61_scan.h"
+#include "lard61_selfbench.h"
+#include "lard61_socd.h"
+#include "lard61_steno.h"
+#include "lard61_stream.h"
+#include "lard61_unicode.h"
+#include "lard61_update.h"
 
 //-----------------------------------------------------------------------------
 // Static variables
@@ -29,25 +49,52 @@ static struct {
   char* write;
 } command_buf = {.buffer = {0}, .write = command_buf.buffer};
 
-//-----------------------------------------------------------------------------
-// Public API
-//-----------------------------------------------------------------------------
-
-void l61_cdc_setup() {
-  tud_cdc_set_wanted_char('\r');
-}
+// See l61_cdc_set_raw
+static bool raw_mode = false;
 
-void l61_printf(const char* fmt, ...) {
-  static char buffer[LARD61_PRINTF_BUFFER_SIZE];
+// The help message is too long for the TX FIFO, see print_help
+static const char* const help_lines[] = {
+    "Available commands:\n",
+    "- hi: greet\n",
+    "- help: you don't need help\n",
+    "- flash: restart in bootsel mode\n",
+    "- boot: boot phase timings\n",
+    "- health: faults and events of this boot and the previous one\n",
+    "- hid: HID report counters\n",
+    "- capture [dump|clear]: raw and debounced key event capture\n",
+    "- cycles [reset]: processor cycles of the key path functions\n",
+    "- debounce [save|reset]: per-key debounce and chatter\n",
+    "- keymap [dump|reset|upload <crc>]: active keymap\n",
+    "- led: host lock LEDs and USB state\n",
+    "- macro [save|clear]: dynamic macro slots\n",
+    "- mouse linear|quadratic: mouse keys acceleration\n",
+    "- profile [<name>|stats|clear|defaults|set <field> <value>]: "
+    "performance profiles\n",
+    "- scan [free|sof|timer <hz>|reset]: scan statistics and mode\n",
+    "- selfbench <strokes> <hz>|stop: type letters to benchmark USB\n",
+    "- socd [off|last|first|neutral|pair <key> <key>|clear]: "
+    "opposite direction keys\n",
+    "- stats [dump|save|reset]: keystroke counters\n",
+    "- steno [on|off]: GeminiPR steno mode\n",
+    "- stream [stop]: live binary key matrix state\n",
+    "- unicode [linux|macos|windows|wincompose|type <hex>]: "
+    "Unicode input mode\n",
+    "- update [<size> <crc>]: firmware slots, receive an image\n",
+    "Magic reflash combination is: Ctrl + Alt + Fn + R\n",
+};
+#define HELP_LINE_COUNT (sizeof(help_lines) / sizeof(help_lines[0]))
 
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(buffer, LARD61_PRINTF_BUFFER_SIZE, fmt, args);
-  va_end(args);
+// Next line of the help message to print, or -1 if not printing it
+static int help_line = -1;
 
-  tud_cdc_write_str(buffer);
-  tud_cdc_write_flush();
-}
+// Binary data being sent, see l61_cdc_send_binary
+static struct {
+  bool active;
+  uint32_t size;
+  uint32_t sent;
+  l61_cdc_read_fn read;
+  void (*done)();
+} binary = {0};
 
 //-----------------------------------------------------------------------------
 // Internal API
@@ -60,13 +107,21 @@ void print_welcome() {
     l61_printf("- RP2040 rom version: %d\n\n", rp2040_rom_version());
 }
 
-// Display the help message
+// Start printing the help message, a line at a time from l61_cdc_task
 void print_help() {
-    l61_printf("Available commands:\n");
-    l61_printf("- hi: greet\n");
-    l61_printf("- help: you don't need help\n");
-    l61_printf("- flash: restart in bootsel mode\n");
-    l61_printf("Magic reflash combination is: Ctrl + Alt + Fn + R\n");
+  help_line = 0;
+}
+
+// Print the next lines of the help message which fit in the CDC TX FIFO
+static void print_help_lines() {
+  while (help_line >= 0 &&
+         tud_cdc_write_available() >= strlen(help_lines[help_line])) {
+    tud_cdc_write_str(help_lines[help_line]);
+    help_line++;
+    if (help_line == (int)HELP_LINE_COUNT)
+      help_line = -1;
+  }
+  tud_cdc_write_flush();
 }
 
 // Interpet the data in command_buf as an instruction to perform some action
@@ -78,6 +133,206 @@ void process_command_buffer() {
   } else if (strcmp(command_buf.buffer, "flash") == 0) {
     l61_printf("restarting in bootsel mode...\n");
     reset_usb_boot(1 << PICO_DEFAULT_LED_PIN, 0);
+  } else if (strcmp(command_buf.buffer, "boot") == 0) {
+    l61_boot_print_log();
+  } else if (strcmp(command_buf.buffer, "health") == 0) {
+    l61_health_print();
+  } else if (strcmp(command_buf.buffer, "hid") == 0) {
+    l61_hid_print_stats();
+  } else if (strcmp(command_buf.buffer, "cycles") == 0) {
+    l61_cycles_print();
+  } else if (strcmp(command_buf.buffer, "cycles reset") == 0) {
+    l61_cycles_reset();
+    l61_printf("cycle counts cleared\n");
+  } else if (strcmp(command_buf.buffer, "capture") == 0) {
+    l61_printf("capture: %lu/%d words, scan period %lu us\n",
+               l61_capture_get_word_count(), L61_CAPTURE_WORDS,
+               l61_capture_get_scan_period_us());
+  } else if (strcmp(command_buf.buffer, "capture dump") == 0) {
+    l61_cdc_send_binary(l61_capture_freeze(), &l61_capture_read,
+                        &l61_capture_resume);
+  } else if (strcmp(command_buf.buffer, "capture clear") == 0) {
+    l61_capture_clear();
+  } else if (strcmp(command_buf.buffer, "debounce") == 0) {
+    l61_keymatrix_print_debounce();
+  } else if (strcmp(command_buf.buffer, "debounce save") == 0) {
+    if (l61_selfbench_is_active()) {
+      l61_printf("debounce: not saved during a selfbench run\n");
+    } else {
+      l61_keymatrix_save_debounce();
+      l61_printf("debounce table saved\n");
+    }
+  } else if (strcmp(command_buf.buffer, "debounce reset") == 0) {
+    l61_keymatrix_reset_debounce();
+    l61_printf("debounce windows reset to %d us\n", L61_DEBOUNCE_DEFAULT_US);
+  } else if (strcmp(command_buf.buffer, "keymap") == 0) {
+    l61_keymap_print_status();
+  } else if (strcmp(command_buf.buffer, "keymap dump") == 0) {
+    l61_keymap_dump();
+  } else if (strcmp(command_buf.buffer, "keymap reset") == 0) {
+    l61_keymap_reset();
+    l61_printf("default keymap restored\n");
+  } else if (strncmp(command_buf.buffer, "keymap upload ", 14) == 0) {
+    unsigned long crc = 0;
+    if (sscanf(command_buf.buffer, "keymap upload %lx", &crc) == 1) {
+      l61_keymap_upload(crc);
+    } else {
+      l61_printf("usage: keymap upload <crc32 in hex>\n");
+    }
+  } else if (strcmp(command_buf.buffer, "led") == 0) {
+    l61_led_print();
+  } else if (strcmp(command_buf.buffer, "macro") == 0) {
+    l61_macro_print();
+  } else if (strcmp(command_buf.buffer, "macro save") == 0) {
+    l61_macro_save();
+    l61_printf("macros saved\n");
+  } else if (strcmp(command_buf.buffer, "macro clear") == 0) {
+    l61_macro_clear();
+    l61_printf("macros cleared\n");
+  } else if (strcmp(command_buf.buffer, "mouse linear") == 0) {
+    l61_mousekeys_set_curve(L61_MOUSEKEYS_CURVE_LINEAR);
+  } else if (strcmp(command_buf.buffer, "mouse quadratic") == 0) {
+    l61_mousekeys_set_curve(L61_MOUSEKEYS_CURVE_QUADRATIC);
+  } else if (strcmp(command_buf.buffer, "profile") == 0) {
+    l61_profile_print();
+  } else if (strcmp(command_buf.buffer, "profile stats") == 0) {
+    l61_profile_print_stats();
+  } else if (strcmp(command_buf.buffer, "profile clear") == 0) {
+    l61_profile_reset_stats();
+    l61_printf("profile statistics cleared\n");
+  } else if (strcmp(command_buf.buffer, "profile defaults") == 0) {
+    l61_profile_restore_defaults();
+    l61_profile_print();
+  } else if (strncmp(command_buf.buffer, "profile set ", 12) == 0) {
+    char field[16], value[16];
+    if (sscanf(command_buf.buffer, "profile set %15s %15s", field, value) ==
+            2 &&
+        l61_profile_set(field, value)) {
+      l61_profile_print();
+    } else {
+      l61_printf("usage: profile set name <name>|scan free|sof|timer|"
+                 "rate <hz>|idle <hz>|debounce deferred|eager|"
+                 "window <us>|throttle on|off\n");
+    }
+  } else if (strncmp(command_buf.buffer, "profile ", 8) == 0) {
+    int index = l61_profile_find(command_buf.buffer + 8);
+    if (index >= 0 && l61_profile_select((uint)index)) {
+      l61_profile_print();
+    } else {
+      l61_printf("unknown profile\n");
+    }
+  } else if (strcmp(command_buf.buffer, "scan") == 0) {
+    l61_scan_print_stats();
+  } else if (strcmp(command_buf.buffer, "scan free") == 0) {
+    l61_scan_set_mode(L61_SCAN_FREE_RUNNING);
+    l61_printf("scanning from the main loop\n");
+  } else if (strcmp(command_buf.buffer, "scan sof") == 0) {
+    l61_scan_set_mode(L61_SCAN_SOF_ALIGNED);
+    l61_printf("scanning %d us before each SOF\n", L61_SOF_SCAN_LEAD_US);
+  } else if (strncmp(command_buf.buffer, "scan timer", 10) == 0) {
+    uint hz = L61_SCAN_RATE_DEFAULT_HZ;
+    sscanf(command_buf.buffer, "scan timer %u", &hz);
+    if (l61_scan_set_rate(hz)) {
+      l61_scan_set_mode(L61_SCAN_TIMER);
+      l61_printf("scanning at %u Hz\n", hz);
+    } else {
+      l61_printf("rate must be between %d and %d Hz\n", L61_SCAN_RATE_MIN_HZ,
+                 L61_SCAN_RATE_MAX_HZ);
+    }
+  } else if (strcmp(command_buf.buffer, "scan reset") == 0) {
+    l61_scan_reset_stats();
+  } else if (strcmp(command_buf.buffer, "selfbench stop") == 0) {
+    l61_selfbench_stop();
+  } else if (strncmp(command_buf.buffer, "selfbench", 9) == 0) {
+    unsigned long strokes = 0, hz = 0;
+    if (sscanf(command_buf.buffer, "selfbench %lu %lu", &strokes, &hz) == 2 &&
+        l61_selfbench_start(strokes, hz)) {
+      l61_printf("selfbench: typing %lu strokes at %lu Hz\n", strokes, hz);
+    } else {
+      l61_printf("usage: selfbench <1-%d strokes> <1-%d hz>, at most %d s, "
+                 "fewer hz with slow timer scans\n",
+                 L61_SELFBENCH_MAX_STROKES, L61_SELFBENCH_MAX_RATE_HZ,
+                 L61_SELFBENCH_MAX_DURATION_US / 1000000);
+    }
+  } else if (strcmp(command_buf.buffer, "socd") == 0) {
+    l61_socd_print();
+  } else if (strcmp(command_buf.buffer, "socd off") == 0) {
+    l61_socd_set_mode(L61_SOCD_OFF);
+    l61_socd_print();
+  } else if (strcmp(command_buf.buffer, "socd last") == 0) {
+    l61_socd_set_mode(L61_SOCD_LAST);
+    l61_socd_print();
+  } else if (strcmp(command_buf.buffer, "socd first") == 0) {
+    l61_socd_set_mode(L61_SOCD_FIRST);
+    l61_socd_print();
+  } else if (strcmp(command_buf.buffer, "socd neutral") == 0) {
+    l61_socd_set_mode(L61_SOCD_NEUTRAL);
+    l61_socd_print();
+  } else if (strcmp(command_buf.buffer, "socd clear") == 0) {
+    l61_socd_clear_pairs();
+    l61_socd_print();
+  } else if (strncmp(command_buf.buffer, "socd pair ", 10) == 0) {
+    uint a = 0, b = 0;
+    if (sscanf(command_buf.buffer, "socd pair %u %u", &a, &b) == 2 &&
+        l61_socd_add_pair(a, b)) {
+      l61_socd_print();
+    } else {
+      l61_printf("usage: socd pair <key> <key>, unpaired key indices, "
+                 "at most %d pairs\n", L61_SOCD_MAX_PAIRS);
+    }
+  } else if (strcmp(command_buf.buffer, "stats") == 0) {
+    l61_analytics_print();
+  } else if (strcmp(command_buf.buffer, "stats dump") == 0) {
+    l61_cdc_send_binary(sizeof(struct l61_analytics), &l61_analytics_read,
+                        NULL);
+  } else if (strcmp(command_buf.buffer, "stats save") == 0) {
+    l61_analytics_save();
+    l61_printf("keystroke counters saved\n");
+  } else if (strcmp(command_buf.buffer, "stats reset") == 0) {
+    l61_analytics_reset();
+    l61_printf("keystroke counters reset\n");
+  } else if (strcmp(command_buf.buffer, "steno") == 0) {
+    l61_steno_print();
+  } else if (strcmp(command_buf.buffer, "steno on") == 0) {
+    l61_steno_set_enabled(true);
+    l61_printf("steno mode on\n");
+  } else if (strcmp(command_buf.buffer, "steno off") == 0) {
+    l61_steno_set_enabled(false);
+    l61_printf("steno mode off\n");
+  } else if (strcmp(command_buf.buffer, "stream") == 0) {
+    l61_stream_start();
+  } else if (strcmp(command_buf.buffer, "stream stop") == 0) {
+    l61_stream_stop();
+  } else if (strcmp(command_buf.buffer, "unicode") == 0) {
+    l61_unicode_print();
+  } else if (strcmp(command_buf.buffer, "unicode linux") == 0) {
+    l61_unicode_set_mode(L61_UNICODE_LINUX);
+    l61_unicode_print();
+  } else if (strcmp(command_buf.buffer, "unicode macos") == 0) {
+    l61_unicode_set_mode(L61_UNICODE_MACOS);
+    l61_unicode_print();
+  } else if (strcmp(command_buf.buffer, "unicode windows") == 0) {
+    l61_unicode_set_mode(L61_UNICODE_WINDOWS);
+    l61_unicode_print();
+  } else if (strcmp(command_buf.buffer, "unicode wincompose") == 0) {
+    l61_unicode_set_mode(L61_UNICODE_WINCOMPOSE);
+    l61_unicode_print();
+  } else if (strncmp(command_buf.buffer, "unicode type ", 13) == 0) {
+    unsigned long code_point = 0;
+    if (sscanf(command_buf.buffer, "unicode type %lx", &code_point) != 1 ||
+        !l61_unicode_type(code_point)) {
+      l61_printf("usage: unicode type <code point in hex>, up to %x\n",
+                 L61_UNICODE_MAX);
+    }
+  } else if (strcmp(command_buf.buffer, "update") == 0) {
+    l61_update_print_status();
+  } else if (strncmp(command_buf.buffer, "update ", 7) == 0) {
+    unsigned long size = 0, crc = 0;
+    if (sscanf(command_buf.buffer, "update %lu %lx", &size, &crc) == 2) {
+      l61_update_start(size, crc);
+    } else {
+      l61_printf("usage: update <size> <crc32 in hex>\n");
+    }
   } else if (strcmp(command_buf.buffer, "help") == 0) {
     print_help();
   } else if (strlen(command_buf.buffer) == 0) {
@@ -91,29 +346,113 @@ void process_command_buffer() {
   command_buf.buffer[0] = '\0';
 }
 
-//-----------------------------------------------------------------------------
-// USB CDC callbacks
-//-----------------------------------------------------------------------------
-
-void tud_cdc_rx_cb(uint8_t itf) {
-  (void)itf;
-
-  // Store the new data in the command buffer
+// Move the received characters to the command buffer, up to the end of the
+// command. Return true if a whole command was read. The characters after it
+// stay in the FIFO, in case the command switches to raw mode.
+static bool read_command() {
   while (tud_cdc_available()) {
-    if (command_buf.write < command_buf.buffer + LARD61_COMMAND_BUFFER_SIZE - 1) {
+    if (command_buf.write <
+        command_buf.buffer + LARD61_COMMAND_BUFFER_SIZE - 1) {
       int32_t c = tud_cdc_read_char();
       if (c == '\r')
-        continue;
+        return true;
       (*command_buf.write) = c;
-      // tud_cdc_write_char(*command_buf.write);
       command_buf.write++;
       (*command_buf.write) = '\0';
     } else {
-      l61_printf("\nToo many chars in command_buf ! Can't process next command\n");
+      l61_printf(
+          "\nToo many chars in command_buf ! Can't process next command\n");
       // Reset the write ptr to the start of the buffer
       command_buf.write = command_buf.buffer;
     }
   }
+  return false;
+}
+
+// Read and run every complete command received, until raw mode
+static void process_input() {
+  while (!raw_mode && read_command()) {
+    tud_cdc_write_char('\n');
+    process_command_buffer();
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_cdc_setup() {
+  tud_cdc_set_wanted_char('\r');
+}
+
+void l61_printf(const char* fmt, ...) {
+  static char buffer[LARD61_PRINTF_BUFFER_SIZE];
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buffer, LARD61_PRINTF_BUFFER_SIZE, fmt, args);
+  va_end(args);
+
+  tud_cdc_write_str(buffer);
+  tud_cdc_write_flush();
+}
+
+void l61_cdc_send_binary(uint32_t size, l61_cdc_read_fn read, void (*done)()) {
+  l61_printf("binary %lu\n", size);
+  binary.active = true;
+  binary.size = size;
+  binary.sent = 0;
+  binary.read = read;
+  binary.done = done;
+}
+
+void l61_cdc_task() {
+  if (!binary.active) {
+    if (help_line >= 0)
+      print_help_lines();
+    return;
+  }
+
+  uint8_t chunk[64];
+  bool stop = !tud_cdc_connected();
+  while (!stop && binary.sent < binary.size &&
+         tud_cdc_write_available() >= sizeof(chunk)) {
+    uint32_t len = binary.size - binary.sent;
+    if (len > sizeof(chunk))
+      len = sizeof(chunk);
+    len = binary.read(binary.sent, chunk, len);
+    // The source ran out of data early
+    stop = len == 0;
+    tud_cdc_write(chunk, len);
+    binary.sent += len;
+  }
+  tud_cdc_write_flush();
+
+  if (stop || binary.sent >= binary.size) {
+    binary.active = false;
+    if (binary.done)
+      binary.done();
+  }
+}
+
+void l61_cdc_set_raw(bool raw) {
+  raw_mode = raw;
+  // Forget the partial command typed before the raw data
+  command_buf.write = command_buf.buffer;
+  command_buf.buffer[0] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+// USB CDC callbacks
+//-----------------------------------------------------------------------------
+
+void tud_cdc_rx_cb(uint8_t itf) {
+  (void)itf;
+
+  if (raw_mode)
+    return;
+
+  process_input();
   l61_printf("\r=> %s", command_buf.buffer);
   tud_cdc_write_flush();
 }
@@ -132,8 +471,7 @@ void tud_cdc_rx_wanted_cb(uint8_t itf, char wanted_char) {
   (void)itf;
   (void)wanted_char;
 
-  tud_cdc_write_char('\n');
-
-  // Consume the contents of the command buffer
-  process_command_buffer();
-}
\ No newline at end of file
+  // Invoked before tud_cdc_rx_cb, with the command still in the FIFO when
+  // it came in the same packet as its '\r'
+  process_input();
+}
@@ -10,6 +10,9 @@
 #ifndef _LARD61_CDC_H
 #define _LARD61_CDC_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 // Max length + 1 of a string formatted by lard61_printf
 #define LARD61_PRINTF_BUFFER_SIZE 256
 // Max char count + 1 in the command buffer
@@ -25,4 +28,19 @@ void l61_cdc_setup();
 // Formatted print via the lard61 CDC USB interface
 void l61_printf(const char* fmt, ...);
 
+// Source of the data sent by l61_cdc_send_binary: copy up to `len` bytes
+// from `offset` into `data` and return how many were copied
+typedef uint32_t (*l61_cdc_read_fn)(uint32_t offset, void* data, uint32_t len);
+
+// Send a "binary <size>" line followed by `size` bytes from `read`, as fast
+// as the TX FIFO drains, from l61_cdc_task. `done` is called at the end, or
+// if the host disconnects. Nothing else must be printed meanwhile.
+void l61_cdc_send_binary(uint32_t size, l61_cdc_read_fn read, void (*done)());
+// Make progress on sending binary data
+void l61_cdc_task();
+
+// In raw mode, received data is not interpreted as commands but left in the
+// CDC FIFO, to be read with tud_cdc_read by whoever enabled it
+void l61_cdc_set_raw(bool raw);
+
 #endif /* _LARD61_CDC_H */
@@ -0,0 +1,120 @@
+/*
+** file: lard61_config.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Data is programmed from the second page of the sector, then the header in
+** the first page. A header can only be valid once all the data is written.
+*/
+
+#include "lard61_config.h"
+
+#include <string.h>
+#include "lard61_crc.h"
+#include "lard61_flash.h"
+
+#define CONFIG_MAGIC 0x6c366366
+#define SECTORS_PER_ITEM 2
+
+struct record_header {
+  uint32_t magic;
+  uint32_t item;
+  // Incremented on every write, the copy with the highest value wins
+  uint32_t seq;
+  uint32_t size;
+  // CRC-32 of the data
+  uint32_t crc;
+};
+
+_Static_assert(L61_CONFIG_ITEM_COUNT * SECTORS_PER_ITEM * FLASH_SECTOR_SIZE <=
+                   L61_FLASH_CONFIG_SIZE,
+               "config items do not fit in the config area");
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t sector_offset(enum l61_config_item item, uint copy) {
+  return L61_FLASH_CONFIG_OFFSET +
+         (item * SECTORS_PER_ITEM + copy) * FLASH_SECTOR_SIZE;
+}
+
+static const struct record_header* header(enum l61_config_item item,
+                                          uint copy) {
+  return l61_flash_ptr(sector_offset(item, copy));
+}
+
+static const void* record_data(enum l61_config_item item, uint copy) {
+  return l61_flash_ptr(sector_offset(item, copy) + FLASH_PAGE_SIZE);
+}
+
+static bool copy_valid(enum l61_config_item item, uint copy) {
+  const struct record_header* h = header(item, copy);
+  return h->magic == CONFIG_MAGIC && h->item == item &&
+         h->size <= L61_CONFIG_ITEM_MAX_SIZE &&
+         h->crc == l61_crc32(L61_CRC32_INIT, record_data(item, copy), h->size);
+}
+
+// Index of the copy holding the latest value of `item`, or -1 if none
+static int latest_copy(enum l61_config_item item) {
+  int latest = -1;
+  for (uint copy = 0; copy < SECTORS_PER_ITEM; ++copy) {
+    if (copy_valid(item, copy) &&
+        (latest < 0 || header(item, copy)->seq > header(item, latest)->seq)) {
+      latest = copy;
+    }
+  }
+  return latest;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+bool l61_config_load(enum l61_config_item item, void* data, uint32_t size) {
+  int copy = latest_copy(item);
+  if (copy < 0 || header(item, copy)->size != size)
+    return false;
+  memcpy(data, record_data(item, copy), size);
+  return true;
+}
+
+void l61_config_store(enum l61_config_item item,
+                      const void* data,
+                      uint32_t size) {
+  if (size > L61_CONFIG_ITEM_MAX_SIZE)
+    return;
+
+  int latest = latest_copy(item);
+  uint copy = latest < 0 ? 0 : 1 - latest;
+  uint32_t offset = sector_offset(item, copy);
+  l61_flash_erase(offset, FLASH_SECTOR_SIZE);
+
+  // Whole pages straight from `data`, then the padded remainder
+  uint32_t whole = size - size % FLASH_PAGE_SIZE;
+  if (whole > 0)
+    l61_flash_program(offset + FLASH_PAGE_SIZE, data, whole);
+
+  uint8_t page[FLASH_PAGE_SIZE];
+  if (whole < size) {
+    memset(page, 0xff, sizeof(page));
+    memcpy(page, (const uint8_t*)data + whole, size - whole);
+    l61_flash_program(offset + FLASH_PAGE_SIZE + whole, page, sizeof(page));
+  }
+
+  struct record_header h = {
+      .magic = CONFIG_MAGIC,
+      .item = item,
+      .seq = latest < 0 ? 0 : header(item, latest)->seq + 1,
+      .size = size,
+      .crc = l61_crc32(L61_CRC32_INIT, data, size),
+  };
+  memset(page, 0xff, sizeof(page));
+  memcpy(page, &h, sizeof(h));
+  l61_flash_program(offset, page, sizeof(page));
+}
+
+void l61_config_clear(enum l61_config_item item) {
+  l61_flash_erase(sector_offset(item, 0),
+                  SECTORS_PER_ITEM * FLASH_SECTOR_SIZE);
+}
@@ -0,0 +1,57 @@
+/*
+** file: lard61_config.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Persistent settings, kept in the config area at the end of flash (see
+** lard61_flash.h).
+**
+** Each item has two sectors to itself and is written to whichever does not
+** hold its latest copy, so a power loss during a write leaves the previous
+** value intact.
+*/
+
+#ifndef _LARD61_CONFIG_H
+#define _LARD61_CONFIG_H
+
+#include "hardware/flash.h"
+#include "pico/types.h"
+
+// Largest item that can be stored. The first page of each sector holds the
+// record header.
+#define L61_CONFIG_ITEM_MAX_SIZE (FLASH_SECTOR_SIZE - FLASH_PAGE_SIZE)
+
+enum l61_config_item {
+  // struct l61_keymap uploaded by the host
+  L61_CONFIG_KEYMAP,
+  // struct l61_debounce_table, learned by lard61_debounce.c
+  L61_CONFIG_DEBOUNCE,
+  // struct l61_analytics, counted by lard61_analytics.c
+  L61_CONFIG_ANALYTICS,
+  // struct l61_macro_store, recorded by lard61_macro.c
+  L61_CONFIG_MACROS,
+  // Unicode input mode as a uint32_t, see lard61_unicode.h
+  L61_CONFIG_UNICODE,
+  // SOCD mode and key pairs, see lard61_socd.c
+  L61_CONFIG_SOCD,
+  // Performance profiles and the active one, see lard61_profile.c
+  L61_CONFIG_PROFILE,
+  L61_CONFIG_ITEM_COUNT,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Copy the stored value of `item` into `data`.
+// Return false if nothing valid of that size is stored.
+bool l61_config_load(enum l61_config_item item, void* data, uint32_t size);
+// Store `size` bytes of `data` as the new value of `item`. Interrupts are
+// disabled during the sector erase, for a few tens of milliseconds.
+void l61_config_store(enum l61_config_item item,
+                      const void* data,
+                      uint32_t size);
+// Forget the stored value of `item`
+void l61_config_clear(enum l61_config_item item);
+
+#endif /* _LARD61_CONFIG_H */
@@ -0,0 +1,27 @@
+/*
+** file: lard61_crc.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Uses a 16-entry table, processing 4 bits at a time: a good compromise
+** between the 1KB byte table and the slow bit-by-bit version on the M0+.
+*/
+
+#include "lard61_crc.h"
+
+static const uint32_t crc32_nibble_table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+uint32_t l61_crc32(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* p = data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0xf];
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0xf];
+  }
+  return ~crc;
+}
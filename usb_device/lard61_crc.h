@@ -0,0 +1,27 @@
+/*
+** file: lard61_crc.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** CRC-32 (IEEE 802.3, as computed by zlib.crc32 and `crc32` on the host),
+** used to check firmware images and records stored in flash.
+*/
+
+#ifndef _LARD61_CRC_H
+#define _LARD61_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Start value to pass as `crc` for the first chunk of data
+#define L61_CRC32_INIT 0
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Update `crc` with `len` bytes of data. The data can be passed in
+// several chunks by feeding the result of each call to the next.
+uint32_t l61_crc32(uint32_t crc, const void* data, size_t len);
+
+#endif /* _LARD61_CRC_H */
@@ -0,0 +1,139 @@
+/*
+** file: lard61_cycles.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** SysTick counts down from 2^24 - 1 at the processor clock and wraps about
+** every 134 ms at 125 MHz, far longer than any probed call. The cost of the
+** probe itself, measured once at setup, is taken out of every count.
+**
+** The scan probes may run from the scan alarm interrupt, the others from
+** the main loop: every probe is only recorded from one of them, and the
+** main loop reads and clears them with interrupts disabled.
+*/
+
+#include "lard61_cycles.h"
+
+#include <string.h>
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_hot.h"
+#include "lard61_keymatrix.h"
+
+struct probe_stats {
+  uint32_t calls;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static const char* const probe_names[L61_CYCLES_PROBE_COUNT] = {
+    [L61_CYCLES_SCAN] = "scan",
+    [L61_CYCLES_DEBOUNCE] = "debounce",
+    [L61_CYCLES_REPORT] = "report",
+    [L61_CYCLES_HID_TASK] = "hid_task",
+};
+
+static const char* const load_names[L61_CYCLES_LOAD_COUNT] = {
+    [L61_CYCLES_IDLE] = "idle",
+    [L61_CYCLES_ONE_KEY] = "1key",
+    [L61_CYCLES_SIX_KEYS] = "6keys",
+    [L61_CYCLES_MORE_KEYS] = "more",
+};
+
+// Cycles taken by l61_cycles_now and l61_cycles_record alone
+static uint32_t overhead = 0;
+
+static struct probe_stats stats[L61_CYCLES_PROBE_COUNT][L61_CYCLES_LOAD_COUNT];
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t L61_HOT_FUNC(elapsed)(uint32_t start) {
+  uint32_t cycles = (start - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS;
+  return cycles > overhead ? cycles - overhead : 0;
+}
+
+static enum l61_cycles_load L61_HOT_FUNC(current_load)() {
+  uint keys = l61_keymatrix_get_pressed_count();
+  if (keys == 0)
+    return L61_CYCLES_IDLE;
+  if (keys == 1)
+    return L61_CYCLES_ONE_KEY;
+  return keys <= 6 ? L61_CYCLES_SIX_KEYS : L61_CYCLES_MORE_KEYS;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_cycles_setup() {
+  systick_hw->csr = 0;
+  systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+  // Any write clears the current value
+  systick_hw->cvr = 0;
+  systick_hw->csr =
+      M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+  // An empty call, recorded like l61_cycles_record does
+  uint32_t start = l61_cycles_now();
+  current_load();
+  overhead = elapsed(start);
+  l61_cycles_reset();
+}
+
+uint32_t L61_HOT_FUNC(l61_cycles_now)() {
+  return systick_hw->cvr;
+}
+
+uint32_t L61_HOT_FUNC(l61_cycles_record)(enum l61_cycles_probe probe,
+                                         uint32_t start) {
+  uint32_t cycles = elapsed(start);
+  struct probe_stats* s = &stats[probe][current_load()];
+  s->calls++;
+  s->total += cycles;
+  if (cycles < s->min)
+    s->min = cycles;
+  if (cycles > s->max)
+    s->max = cycles;
+  return cycles;
+}
+
+void l61_cycles_print() {
+  static struct probe_stats copy[L61_CYCLES_PROBE_COUNT][L61_CYCLES_LOAD_COUNT];
+  uint32_t status = save_and_disable_interrupts();
+  memcpy(copy, stats, sizeof(copy));
+  restore_interrupts(status);
+
+  l61_printf("cycles at %lu MHz, probe overhead %lu\n",
+             clock_get_hz(clk_sys) / 1000000, overhead);
+  l61_printf("probe    load     calls    min   mean     max\n");
+  for (uint p = 0; p < L61_CYCLES_PROBE_COUNT; ++p) {
+    for (uint l = 0; l < L61_CYCLES_LOAD_COUNT; ++l) {
+      // Every line is printed, for tools/l61_cycles.py. They all fit in
+      // the CDC TX FIFO.
+      const struct probe_stats* s = &copy[p][l];
+      l61_printf("%-8s %-5s %8lu %6lu %6lu %7lu\n",
+                 probe_names[p], load_names[l], s->calls,
+                 s->calls ? s->min : 0,
+                 s->calls ? (uint32_t)(s->total / s->calls) : 0, s->max);
+    }
+  }
+}
+
+void l61_cycles_reset() {
+  uint32_t status = save_and_disable_interrupts();
+  memset(stats, 0, sizeof(stats));
+  for (uint p = 0; p < L61_CYCLES_PROBE_COUNT; ++p) {
+    for (uint l = 0; l < L61_CYCLES_LOAD_COUNT; ++l)
+      stats[p][l].min = UINT32_MAX;
+  }
+  restore_interrupts(status);
+}
@@ -0,0 +1,59 @@
+/*
+** file: lard61_cycles.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Processor cycles taken by the hot functions of the key path, counted on
+** the board itself with SysTick, as the host tools cannot tell what the
+** Cortex-M0+ makes of them.
+**
+** Each probe times every call of its function and files it by the number of
+** keys held when the call returns: none, one, two to six, or more. Interrupts
+** taken during a call are counted in it, so the minimum is the function's
+** own cost, and the maximum what the key path actually had to wait.
+**
+** `cycles` prints the counts and `cycles reset` clears them. See
+** tools/l61_cycles.py to save them and compare firmware builds.
+*/
+
+#ifndef _LARD61_CYCLES_H
+#define _LARD61_CYCLES_H
+
+#include "pico/types.h"
+
+enum l61_cycles_probe {
+  // l61_keymatrix_update, the whole matrix scan
+  L61_CYCLES_SCAN,
+  // l61_debounce_update, in the scan
+  L61_CYCLES_DEBOUNCE,
+  // l61_report_build, in l61_hid_task
+  L61_CYCLES_REPORT,
+  // l61_hid_task
+  L61_CYCLES_HID_TASK,
+  L61_CYCLES_PROBE_COUNT,
+};
+
+// Keys held at the end of a call
+enum l61_cycles_load {
+  L61_CYCLES_IDLE,
+  L61_CYCLES_ONE_KEY,
+  // Up to a full keyboard report
+  L61_CYCLES_SIX_KEYS,
+  L61_CYCLES_MORE_KEYS,
+  L61_CYCLES_LOAD_COUNT,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Start SysTick from the processor clock. Must be called before any probe.
+void l61_cycles_setup();
+// Cycle counter, to pass to l61_cycles_record at the end of the call
+uint32_t l61_cycles_now();
+// Count the cycles since `start` for `probe`, and return them
+uint32_t l61_cycles_record(enum l61_cycles_probe probe, uint32_t start);
+void l61_cycles_print();
+void l61_cycles_reset();
+
+#endif /* _LARD61_CYCLES_H */
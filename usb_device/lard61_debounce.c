@@ -0,0 +1,282 @@
+/*
+** file: lard61_debounce.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** A key's raw edges are grouped into bursts: a burst starts with the first
+** edge away from the debounced state and ends when the key has been stable
+** for its window, either in a new state (registered) or back in the old one
+** (filtered bounce). The length of a burst, from its first to its last
+** edge, is how long the switch bounced.
+**
+** The window of a key is the longest bounce it showed, plus a margin, once
+** it has been pressed often enough for that to be meaningful, widened
+** according to the share of its presses which were short. An occasional
+** fast tap thus barely counts, and once a wider window stops chatter from
+** getting through, the share goes down and the window narrows again.
+**
+** In eager mode, a burst away from the debounced state registers the new
+** state at its first edge. If the key is then stable in the old state at
+** the end of the window, that was noise: the old state is registered back
+** and the burst counted as a bounce.
+*/
+
+#include "lard61_debounce.h"
+
+#include <string.h>
+#include "lard61_analytics.h"
+#include "lard61_capture.h"
+#include "lard61_hot.h"
+#include "lard61_leader.h"
+#include "lard61_macro.h"
+#include "lard61_profile.h"
+#include "lard61_socd.h"
+#include "lard61_steno.h"
+#include "lard61_unicode.h"
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct l61_debounce_table table;
+static bool dirty = false;
+static volatile enum l61_debounce_mode mode = L61_DEBOUNCE_DEFERRED;
+// Settings last recorded in the capture
+static enum l61_debounce_mode captured_mode = L61_DEBOUNCE_DEFERRED;
+static uint16_t captured_override = 0;
+// Window of every key if not 0, see l61_debounce_set_window_override
+static volatile uint16_t window_override = 0;
+// No key changed or bounced during the last update
+static volatile bool settled = true;
+
+// Runtime state of each key. The `debounced` member is only filled in by
+// l61_debounce_save, the caller owns the debounced states.
+static struct l61_debounce_key_state keys[L61_DEBOUNCE_KEY_COUNT];
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void saturating_increment(uint16_t* counter) {
+  if (*counter < UINT16_MAX)
+    (*counter)++;
+}
+
+static uint16_t derive_window(const struct l61_debounce_key* key) {
+  if (key->presses < L61_DEBOUNCE_LEARN_PRESSES)
+    return L61_DEBOUNCE_DEFAULT_US;
+
+  uint32_t window = key->bounce_max_us + L61_DEBOUNCE_MARGIN_US;
+  uint32_t short_percent = (uint32_t)key->short_presses * 100 / key->presses;
+  window +=
+      short_percent / L61_CHATTER_RATE_STEP_PERCENT * L61_DEBOUNCE_STEP_US;
+
+  if (window < L61_DEBOUNCE_MIN_US)
+    window = L61_DEBOUNCE_MIN_US;
+  if (window > L61_DEBOUNCE_MAX_US)
+    window = L61_DEBOUNCE_MAX_US;
+  return (uint16_t)window;
+}
+
+static void update_window(struct l61_debounce_key* key) {
+  uint16_t window = derive_window(key);
+  if (window != key->window_us) {
+    key->window_us = window;
+    dirty = true;
+  }
+}
+
+// Hand a new debounced state of key `i` to every module which follows them
+static void L61_HOT_FUNC(register_state)(uint i, bool state, uint32_t now_us) {
+  l61_capture_event(i, true, state, now_us);
+  l61_analytics_key(i, state, now_us);
+  l61_leader_key(i, state, now_us);
+  l61_macro_key(i, state);
+  l61_profile_key(i, state, now_us - keys[i].burst_start_us);
+  l61_socd_key(i, state);
+  l61_steno_key(i, state, now_us);
+  l61_unicode_key(i, state);
+}
+
+// Called when a burst ends, with the key stable for its window
+static void L61_HOT_FUNC(end_burst)(uint i, bool registered, bool state) {
+  struct l61_debounce_key* key = &table.key[i];
+  keys[i].bouncing = false;
+
+  uint32_t bounce_us = keys[i].last_edge_us - keys[i].burst_start_us;
+  if (bounce_us > UINT16_MAX)
+    bounce_us = UINT16_MAX;
+  if (bounce_us > key->bounce_max_us)
+    key->bounce_max_us = (uint16_t)bounce_us;
+
+  if (!registered) {
+    saturating_increment(&key->bounces);
+  } else if (state) {
+    saturating_increment(&key->presses);
+    keys[i].press_us = keys[i].last_edge_us;
+  } else if (keys[i].last_edge_us - keys[i].press_us <
+             L61_CHATTER_SHORT_PRESS_US) {
+    saturating_increment(&key->short_presses);
+  }
+  update_window(key);
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+bool l61_debounce_init(const struct l61_debounce_table* learned) {
+  memset(keys, 0, sizeof(keys));
+  dirty = false;
+
+  if (learned != NULL) {
+    bool valid = true;
+    for (uint i = 0; i < L61_DEBOUNCE_KEY_COUNT; ++i) {
+      if (learned->key[i].window_us < L61_DEBOUNCE_MIN_US ||
+          learned->key[i].window_us > L61_DEBOUNCE_MAX_US)
+        valid = false;
+    }
+    if (valid) {
+      table = *learned;
+      return true;
+    }
+  }
+
+  l61_debounce_reset();
+  dirty = false;
+  return learned == NULL;
+}
+
+void l61_debounce_reset() {
+  memset(&table, 0, sizeof(table));
+  for (uint i = 0; i < L61_DEBOUNCE_KEY_COUNT; ++i) {
+    table.key[i].window_us = L61_DEBOUNCE_DEFAULT_US;
+  }
+  dirty = true;
+}
+
+void l61_debounce_set_window_override(uint16_t window_us) {
+  window_override = window_us;
+}
+
+void l61_debounce_set_mode(enum l61_debounce_mode new_mode) {
+  mode = new_mode;
+}
+
+enum l61_debounce_mode l61_debounce_get_mode() {
+  return mode;
+}
+
+bool L61_HOT_FUNC(l61_debounce_is_settled)() {
+  return settled;
+}
+
+bool L61_HOT_FUNC(l61_debounce_update)(const volatile bool* raw,
+                                       bool* debounced,
+                                       uint32_t now_us) {
+  // The capture asks for a checkpoint before any event of this update
+  struct l61_debounce_state* checkpoint = l61_capture_scan(now_us);
+  if (checkpoint)
+    l61_debounce_save(checkpoint, debounced);
+  // The checkpoint holds the mode but not the window override, other
+  // changes need a settings word
+  enum l61_debounce_mode current_mode = mode;
+  uint16_t override = window_override;
+  bool record_settings = checkpoint ? override != 0
+                                    : current_mode != captured_mode ||
+                                          override != captured_override;
+  if (record_settings)
+    l61_capture_settings(current_mode, override);
+  captured_mode = current_mode;
+  captured_override = override;
+
+  bool eager = current_mode == L61_DEBOUNCE_EAGER;
+  bool changed = false;
+  bool bouncing = false;
+  bool captured = false;
+  for (uint i = 0; i < L61_DEBOUNCE_KEY_COUNT; ++i) {
+    bool state = raw[i];
+    bouncing |= keys[i].bouncing;
+    if (state != keys[i].raw) {
+      l61_capture_event(i, false, state, now_us);
+      captured = true;
+      keys[i].raw = state;
+      keys[i].last_edge_us = now_us;
+      if (!keys[i].bouncing) {
+        keys[i].bouncing = true;
+        keys[i].burst_start_us = now_us;
+        if (eager && state != debounced[i]) {
+          register_state(i, state, now_us);
+          keys[i].flags |= L61_DEBOUNCE_KEY_EARLY;
+          debounced[i] = state;
+          changed = true;
+        }
+      }
+      continue;
+    }
+
+    uint32_t window = override ? override : table.key[i].window_us;
+    if (!keys[i].bouncing || now_us - keys[i].last_edge_us < window)
+      continue;
+
+    // Stable for the whole window. After an early registration, a change
+    // here takes it back.
+    bool registered = state != debounced[i];
+    if (registered) {
+      register_state(i, state, now_us);
+      captured = true;
+      debounced[i] = state;
+      changed = true;
+    }
+    if (keys[i].flags & L61_DEBOUNCE_KEY_EARLY) {
+      keys[i].flags &= ~L61_DEBOUNCE_KEY_EARLY;
+      registered = !registered;
+    }
+    end_burst(i, registered, state);
+  }
+
+  if (bouncing && !captured)
+    l61_capture_quiet_scan(now_us);
+  settled = !bouncing && !captured;
+  return changed;
+}
+
+void l61_debounce_save(struct l61_debounce_state* state,
+                       const bool* debounced) {
+  state->table = table;
+  for (uint i = 0; i < L61_DEBOUNCE_KEY_COUNT; ++i) {
+    state->key[i] = keys[i];
+    state->key[i].debounced = debounced[i];
+    if (mode == L61_DEBOUNCE_EAGER)
+      state->key[i].flags |= L61_DEBOUNCE_KEY_EAGER;
+  }
+}
+
+void l61_debounce_restore(const struct l61_debounce_state* state,
+                          bool* debounced) {
+  table = state->table;
+  mode = state->key[0].flags & L61_DEBOUNCE_KEY_EAGER ? L61_DEBOUNCE_EAGER
+                                                       : L61_DEBOUNCE_DEFERRED;
+  for (uint i = 0; i < L61_DEBOUNCE_KEY_COUNT; ++i) {
+    keys[i] = state->key[i];
+    keys[i].flags &= ~L61_DEBOUNCE_KEY_EAGER;
+    debounced[i] = state->key[i].debounced;
+  }
+  dirty = false;
+}
+
+const struct l61_debounce_table* l61_debounce_get_table() {
+  return &table;
+}
+
+bool l61_debounce_is_dirty() {
+  return dirty;
+}
+
+void l61_debounce_clear_dirty() {
+  dirty = false;
+}
+
+void l61_debounce_set_dirty() {
+  dirty = true;
+}
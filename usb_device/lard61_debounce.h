@@ -0,0 +1,142 @@
+/*
+** file: lard61_debounce.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Per-key debouncing with chatter monitoring.
+**
+** Each key has its own debounce window: a raw state change is registered
+** once the key has not changed for that long. The monitor counts bounces
+** filtered by the window and presses registered for less than
+** L61_CHATTER_SHORT_PRESS_US, which are most likely chatter that got
+** through. Windows are derived from these observations, within
+** [L61_DEBOUNCE_MIN_US, L61_DEBOUNCE_MAX_US].
+**
+** In eager mode, the first edge of a burst is registered right away, and
+** the window only holds the new state against bounces. This takes the
+** window out of the press latency, at the cost of registering noise which
+** a deferred window would have filtered.
+**
+** This module only depends on the raw key states and a microsecond clock,
+** persistence and reporting are done by lard61_keymatrix.c.
+*/
+
+#ifndef _LARD61_DEBOUNCE_H
+#define _LARD61_DEBOUNCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_keymatrix.h"
+
+// Bounds of the per-key debounce window
+#define L61_DEBOUNCE_MIN_US 1000
+#define L61_DEBOUNCE_MAX_US 15000
+// Window used until a key has been pressed L61_DEBOUNCE_LEARN_PRESSES times
+#define L61_DEBOUNCE_DEFAULT_US 4000
+#define L61_DEBOUNCE_LEARN_PRESSES 50
+// Margin added to the longest bounce seen on a key
+#define L61_DEBOUNCE_MARGIN_US 1000
+// Window increase for every L61_CHATTER_RATE_STEP_PERCENT of a key's
+// presses which were short
+#define L61_DEBOUNCE_STEP_US 1000
+#define L61_CHATTER_RATE_STEP_PERCENT 2
+// Presses shorter than this are counted as chatter. Human taps are longer.
+#define L61_CHATTER_SHORT_PRESS_US 25000
+
+#define L61_DEBOUNCE_KEY_COUNT (N_ROWS * N_COLS)
+
+// Bits of struct l61_debounce_key_state flags
+// The state of the current burst was registered at its first edge
+#define L61_DEBOUNCE_KEY_EARLY 0x01
+// Eager mode was on when the state was saved
+#define L61_DEBOUNCE_KEY_EAGER 0x02
+
+enum l61_debounce_mode {
+  // Register a state once the key has been stable for its window
+  L61_DEBOUNCE_DEFERRED,
+  // Register a state at its first edge, then hold it for the window
+  L61_DEBOUNCE_EAGER,
+  L61_DEBOUNCE_MODE_COUNT,
+};
+
+// What is learned about each key. Counters saturate.
+struct l61_debounce_key {
+  // Current debounce window
+  uint16_t window_us;
+  // Longest time between the first and last edge of a bounce
+  uint16_t bounce_max_us;
+  // Registered presses
+  uint16_t presses;
+  // Raw changes which reverted within the window, and were filtered
+  uint16_t bounces;
+  // Registered presses shorter than L61_CHATTER_SHORT_PRESS_US
+  uint16_t short_presses;
+};
+
+struct l61_debounce_table {
+  struct l61_debounce_key key[L61_DEBOUNCE_KEY_COUNT];
+};
+
+// Runtime state of a key between two updates
+struct l61_debounce_key_state {
+  // Time of the first and last edge of the current burst
+  uint32_t burst_start_us;
+  uint32_t last_edge_us;
+  // Time the current press was registered
+  uint32_t press_us;
+  // Raw state at the last update
+  bool raw;
+  // Whether a burst of edges is in progress
+  bool bouncing;
+  // Debounced state
+  bool debounced;
+  // L61_DEBOUNCE_KEY_* bits. Zero in captures from before eager mode.
+  uint8_t flags;
+};
+
+// Everything the debouncer's output depends on, other than future raw states
+struct l61_debounce_state {
+  struct l61_debounce_table table;
+  struct l61_debounce_key_state key[L61_DEBOUNCE_KEY_COUNT];
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Start from `learned` if not NULL, otherwise from default windows.
+// Return false if `learned` was rejected as invalid.
+bool l61_debounce_init(const struct l61_debounce_table* learned);
+// Forget everything learned
+void l61_debounce_reset();
+// Use `window_us` for every key instead of the learned windows, or the
+// learned windows again if 0
+void l61_debounce_set_window_override(uint16_t window_us);
+// Change the debounce mode. Bursts in progress end as they started.
+void l61_debounce_set_mode(enum l61_debounce_mode mode);
+enum l61_debounce_mode l61_debounce_get_mode();
+// Debounce the `raw` key states sampled at `now_us` into `debounced`.
+// Return true if any debounced state changed.
+bool l61_debounce_update(const volatile bool* raw,
+                         bool* debounced,
+                         uint32_t now_us);
+// Whether no raw or debounced key state changed, and no key was bouncing,
+// during the last update
+bool l61_debounce_is_settled();
+
+// Copy the complete debouncer state, with the `debounced` key states last
+// passed to l61_debounce_update, to `state`
+void l61_debounce_save(struct l61_debounce_state* state, const bool* debounced);
+// Continue from a state saved by l61_debounce_save, in the mode it was
+// saved in, and fill `debounced`
+void l61_debounce_restore(const struct l61_debounce_state* state,
+                          bool* debounced);
+
+// Learned windows and chatter counters
+const struct l61_debounce_table* l61_debounce_get_table();
+// Whether a window changed since the last call to l61_debounce_clear_dirty
+bool l61_debounce_is_dirty();
+void l61_debounce_clear_dirty();
+void l61_debounce_set_dirty();
+
+#endif /* _LARD61_DEBOUNCE_H */
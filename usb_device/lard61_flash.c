@@ -0,0 +1,106 @@
+/*
+** file: lard61_flash.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** The SDK's flash_range_* functions leave the flash in XIP mode when they
+** return, so they can be called from code in flash, but they wait for the
+** operation to complete. A sector erase takes up to ~400ms on the W25Q32,
+** typically 45ms.
+**
+** In copy_to_ram builds nothing is read from flash while the firmware is
+** running, so an erase can be started with flash_do_cmd and left to the
+** flash chip while the main loop carries on. Its status register tells when
+** it is done.
+*/
+
+#include "lard61_flash.h"
+
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+
+// Serial flash commands
+#define FLASH_CMD_WRITE_ENABLE 0x06
+#define FLASH_CMD_READ_STATUS 0x05
+#define FLASH_CMD_SECTOR_ERASE 0x20
+// Write in progress bit of the status register
+#define FLASH_STATUS_BUSY 0x01
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void program_page(uint32_t offset, const uint8_t* data) {
+  l61_flash_program(offset, data, FLASH_PAGE_SIZE);
+}
+
+#if PICO_COPY_TO_RAM
+static void erase_sector_async(uint32_t offset) {
+  const uint8_t write_enable[] = {FLASH_CMD_WRITE_ENABLE};
+  const uint8_t erase[] = {FLASH_CMD_SECTOR_ERASE, offset >> 16, offset >> 8,
+                           offset};
+  uint8_t rx[sizeof(erase)];
+
+  uint32_t status = save_and_disable_interrupts();
+  flash_do_cmd(write_enable, rx, sizeof(write_enable));
+  flash_do_cmd(erase, rx, sizeof(erase));
+  restore_interrupts(status);
+}
+
+static bool erase_busy() {
+  const uint8_t tx[] = {FLASH_CMD_READ_STATUS, 0};
+  uint8_t rx[sizeof(tx)];
+
+  uint32_t status = save_and_disable_interrupts();
+  flash_do_cmd(tx, rx, sizeof(tx));
+  restore_interrupts(status);
+  return rx[1] & FLASH_STATUS_BUSY;
+}
+#else
+static void erase_sector_blocking(uint32_t offset) {
+  l61_flash_erase(offset, FLASH_SECTOR_SIZE);
+}
+
+static bool never_busy() {
+  return false;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+uint32_t l61_flash_slot_offset(uint slot) {
+  return slot == 0 ? L61_FLASH_SLOT_A_OFFSET : L61_FLASH_SLOT_B_OFFSET;
+}
+
+void l61_flash_erase(uint32_t offset, uint32_t len) {
+  // One sector at a time, so that the watchdog does not see a long erase
+  // as a hang
+  for (uint32_t done = 0; done < len; done += FLASH_SECTOR_SIZE) {
+    uint32_t status = save_and_disable_interrupts();
+    flash_range_erase(offset + done, FLASH_SECTOR_SIZE);
+    restore_interrupts(status);
+    watchdog_update();
+  }
+}
+
+void l61_flash_program(uint32_t offset, const void* data, uint32_t len) {
+  uint32_t status = save_and_disable_interrupts();
+  flash_range_program(offset, data, len);
+  restore_interrupts(status);
+}
+
+#if PICO_COPY_TO_RAM
+const struct l61_flash_ops l61_flash_ops = {
+    .erase_sector = &erase_sector_async,
+    .busy = &erase_busy,
+    .program_page = &program_page,
+};
+#else
+const struct l61_flash_ops l61_flash_ops = {
+    .erase_sector = &erase_sector_blocking,
+    .busy = &never_busy,
+    .program_page = &program_page,
+};
+#endif
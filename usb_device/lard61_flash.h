@@ -0,0 +1,74 @@
+/*
+** file: lard61_flash.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Layout of the flash and helpers to erase and program it while the
+** firmware is running.
+**
+** With A/B updates enabled, the flash is split as follows:
+** - the bootloader, with the boot2 stage at its start,
+** - the boot control sectors, telling the bootloader which slot to start,
+** - two slots holding a full firmware image each,
+** - a store for persistent configuration.
+** Without them, the firmware starts at the beginning of flash and the
+** configuration store is at its end.
+** These offsets are mirrored by the top-level CMakeLists.txt, which links
+** the bootloader and the firmware for each slot at the right address.
+*/
+
+#ifndef _LARD61_FLASH_H
+#define _LARD61_FLASH_H
+
+#include "hardware/flash.h"
+#include "lard61_flash_writer.h"
+#include "pico/types.h"
+
+#define L61_FLASH_BOOTLOADER_OFFSET 0x000000
+#define L61_FLASH_BOOTLOADER_SIZE 0x008000
+#define L61_FLASH_BOOTCTL_OFFSET 0x008000
+#define L61_FLASH_BOOTCTL_SIZE (2 * FLASH_SECTOR_SIZE)
+#define L61_FLASH_SLOT_A_OFFSET 0x010000
+#define L61_FLASH_SLOT_B_OFFSET 0x1f0000
+#define L61_FLASH_SLOT_SIZE 0x1e0000
+#define L61_FLASH_CONFIG_SIZE 0x030000
+#ifdef L61_AB_UPDATE
+#define L61_FLASH_CONFIG_OFFSET 0x3d0000
+#else
+#define L61_FLASH_CONFIG_OFFSET (PICO_FLASH_SIZE_BYTES - L61_FLASH_CONFIG_SIZE)
+#endif
+
+#if PICO_FLASH_SIZE_BYTES < L61_FLASH_CONFIG_OFFSET + L61_FLASH_CONFIG_SIZE
+#error "the flash is too small for the config store at L61_FLASH_CONFIG_OFFSET"
+#endif
+
+#define L61_FLASH_SLOT_COUNT 2
+// Offset of the vector table in a firmware image, after the 256 bytes
+// reserved for boot2
+#define L61_FLASH_IMAGE_VECTORS_OFFSET 0x100
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Offset in flash of slot 0 (A) or 1 (B)
+uint32_t l61_flash_slot_offset(uint slot);
+
+// Erase `len` bytes at `offset`, both multiples of FLASH_SECTOR_SIZE.
+// Interrupts are disabled until the erase is done, as no code can run from
+// flash meanwhile.
+void l61_flash_erase(uint32_t offset, uint32_t len);
+// Program `len` bytes at `offset`, both multiples of FLASH_PAGE_SIZE, in
+// erased flash. Interrupts are disabled meanwhile.
+void l61_flash_program(uint32_t offset, const void* data, uint32_t len);
+
+// Read access to the flash contents at `offset`, through XIP
+static inline const void* l61_flash_ptr(uint32_t offset) {
+  return (const void*)(uintptr_t)(XIP_BASE + offset);
+}
+
+// Flash operations for l61_flash_writer. When the whole firmware runs from
+// RAM, sector erases run in the background instead of blocking.
+extern const struct l61_flash_ops l61_flash_ops;
+
+#endif /* _LARD61_FLASH_H */
@@ -0,0 +1,102 @@
+/*
+** file: lard61_flash_writer.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Erasing a 4KB sector takes tens of milliseconds, programming a page less
+** than one. The writer starts erasing the next sector as soon as the flash
+** is idle and there is nothing to program, so erases run ahead of the data
+** instead of waiting for a whole sector to arrive. With asynchronous erase
+** operations, the buffer keeps filling up during an erase and is programmed
+** in one go once the sector is ready.
+*/
+
+#include "lard61_flash_writer.h"
+
+#include <string.h>
+
+#define PAGE L61_FLASH_WRITER_PAGE_SIZE
+#define SECTOR L61_FLASH_WRITER_SECTOR_SIZE
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_flash_writer_init(struct l61_flash_writer* writer,
+                           const struct l61_flash_ops* ops,
+                           uint32_t offset,
+                           uint32_t size) {
+  writer->ops = ops;
+  writer->offset = offset;
+  writer->size = size;
+  writer->received = 0;
+  writer->programmed = 0;
+  writer->erased = 0;
+  writer->erasing = false;
+}
+
+uint32_t l61_flash_writer_push(struct l61_flash_writer* writer,
+                               const uint8_t* data,
+                               uint32_t len) {
+  uint32_t space = l61_flash_writer_space(writer);
+  if (len > space)
+    len = space;
+
+  for (uint32_t i = 0; i < len;) {
+    // Copy up to the end of the ring buffer, then wrap around
+    uint32_t pos = writer->received % L61_FLASH_WRITER_BUFFER_SIZE;
+    uint32_t chunk = L61_FLASH_WRITER_BUFFER_SIZE - pos;
+    if (chunk > len - i)
+      chunk = len - i;
+    memcpy(&writer->buffer[pos], &data[i], chunk);
+    writer->received += chunk;
+    i += chunk;
+  }
+  return len;
+}
+
+uint32_t l61_flash_writer_space(const struct l61_flash_writer* writer) {
+  uint32_t space = L61_FLASH_WRITER_BUFFER_SIZE -
+                   (writer->received - writer->programmed);
+  uint32_t remaining = writer->size - writer->received;
+  return space < remaining ? space : remaining;
+}
+
+void l61_flash_writer_poll(struct l61_flash_writer* writer) {
+  if (writer->erasing) {
+    if (writer->ops->busy())
+      return;
+    writer->erasing = false;
+    writer->erased += SECTOR;
+  }
+
+  // Program all complete pages in erased sectors, and the last partial page
+  // once everything has been received
+  while (writer->programmed < writer->erased &&
+         (writer->received - writer->programmed >= PAGE ||
+          (writer->received == writer->size &&
+           writer->programmed < writer->size))) {
+    uint8_t* page =
+        &writer->buffer[writer->programmed % L61_FLASH_WRITER_BUFFER_SIZE];
+    uint32_t len = writer->received - writer->programmed;
+    if (len < PAGE) {
+      // Pad the last page with the erased value
+      memset(page + len, 0xff, PAGE - len);
+    }
+    writer->ops->program_page(writer->offset + writer->programmed, page);
+    writer->programmed += len < PAGE ? len : PAGE;
+  }
+
+  // Erase the next sector while the data for it is coming in. Stay at most
+  // one sector ahead of the received data, so that blocking erases are
+  // spread over the transfer instead of stalling everything at the start.
+  if (writer->erased < writer->size &&
+      writer->erased < writer->received + SECTOR) {
+    writer->ops->erase_sector(writer->offset + writer->erased);
+    writer->erasing = true;
+  }
+}
+
+bool l61_flash_writer_done(const struct l61_flash_writer* writer) {
+  return writer->programmed == writer->size;
+}
@@ -0,0 +1,73 @@
+/*
+** file: lard61_flash_writer.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Writes a stream of data of known size to a flash region, erasing sectors
+** ahead of the data so that erases overlap with the reception of the next
+** bytes.
+**
+** The writer only talks to the flash through a struct l61_flash_ops and
+** does not depend on the SDK, so it can be built on the host against a
+** flash emulator.
+*/
+
+#ifndef _LARD61_FLASH_WRITER_H
+#define _LARD61_FLASH_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define L61_FLASH_WRITER_PAGE_SIZE 256
+#define L61_FLASH_WRITER_SECTOR_SIZE 4096
+// Data received but not programmed yet. Must be a multiple of the page size.
+// Bytes keep coming in while a sector is being erased until this is full.
+#define L61_FLASH_WRITER_BUFFER_SIZE (4 * L61_FLASH_WRITER_SECTOR_SIZE)
+
+struct l61_flash_ops {
+  // Start erasing the sector at `offset`. May return before the erase is
+  // finished, in which case `busy` must return true until it is.
+  void (*erase_sector)(uint32_t offset);
+  // Whether the last erase is still in progress
+  bool (*busy)(void);
+  // Program one page at `offset`. Only called when `busy` returns false.
+  void (*program_page)(uint32_t offset, const uint8_t* data);
+};
+
+struct l61_flash_writer {
+  const struct l61_flash_ops* ops;
+  // Region being written
+  uint32_t offset;
+  uint32_t size;
+  // Progress, in bytes from `offset`
+  uint32_t received;
+  uint32_t programmed;
+  uint32_t erased;
+  // Whether the sector at `erased` is being erased
+  bool erasing;
+  // Ring buffer of received pages, indexed by (position % size)
+  uint8_t buffer[L61_FLASH_WRITER_BUFFER_SIZE];
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Prepare to write `size` bytes at `offset`, which must be sector aligned
+void l61_flash_writer_init(struct l61_flash_writer* writer,
+                           const struct l61_flash_ops* ops,
+                           uint32_t offset,
+                           uint32_t size);
+// Queue data to be written. Return the number of bytes accepted, which is
+// less than `len` when the buffer is full.
+uint32_t l61_flash_writer_push(struct l61_flash_writer* writer,
+                               const uint8_t* data,
+                               uint32_t len);
+// Number of bytes l61_flash_writer_push can accept right now
+uint32_t l61_flash_writer_space(const struct l61_flash_writer* writer);
+// Make progress on erasing and programming. Call repeatedly.
+void l61_flash_writer_poll(struct l61_flash_writer* writer);
+// Whether all `size` bytes have been programmed
+bool l61_flash_writer_done(const struct l61_flash_writer* writer);
+
+#endif /* _LARD61_FLASH_WRITER_H */
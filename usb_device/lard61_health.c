@@ -0,0 +1,299 @@
+/*
+** file: lard61_health.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Like the boot log, the records live in uninitialised RAM, which a
+** watchdog or software reset keeps. The current record is updated as
+** things happen rather than saved when the boot ends, since a hang gives
+** no chance to: the watchdog resets the chip without running any code.
+**
+** On a reset, l61_health_init tells what ended the previous boot from the
+** cause the record already holds, set on a hard fault or deliberate reboot,
+** and otherwise from the watchdog's reason register. The watchdog being
+** started with watchdog_enable, the SDK can tell its timeouts apart from
+** watchdog_reboot and from the bootrom's own resets.
+*/
+
+#include "lard61_health.h"
+
+#include <string.h>
+#include "class/hid/hid_device.h"
+#include "device/usbd.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "lard61_cdc.h"
+#include "lard61_hid.h"
+#include "lard61_hot.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+
+#define HEALTH_MAGIC 0x6c363168  // "l61h"
+
+// What ended a boot
+enum reset_cause {
+  // Still running, or ended by something which left no trace
+  RESET_UNKNOWN,
+  RESET_POWER_ON,
+  // Reset pin, debugger or bootrom
+  RESET_EXTERNAL,
+  RESET_WATCHDOG,
+  RESET_HARD_FAULT,
+  // l61_health_reboot
+  RESET_REBOOT,
+  RESET_CAUSE_COUNT
+};
+
+struct trace_entry {
+  uint32_t time_us;
+  uint16_t event;
+  uint16_t arg;
+};
+
+struct health_record {
+  uint32_t magic;
+  // enum reset_cause, set when the boot ends
+  uint32_t reset;
+  uint32_t faults[L61_FAULT_COUNT];
+  // Longest time between two feeds of the watchdog
+  uint32_t loop_max_us;
+  // Time the boot ended, and registers stacked by a hard fault
+  uint32_t end_us;
+  uint32_t fault_pc;
+  uint32_t fault_lr;
+  uint32_t fault_xpsr;
+  // Number of events ever traced, the last ones are in `trace`
+  uint32_t trace_count;
+  struct trace_entry trace[L61_HEALTH_TRACE_SIZE];
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// [0] is the record of the current boot, [1] the record of the previous one
+static struct health_record __uninitialized_ram(records)[2];
+
+// Last time the watchdog was fed, 0 until it is started
+static uint32_t fed_us = 0;
+// Set once a reboot is scheduled, to stop feeding the watchdog which does it
+static bool rebooting = false;
+// Since when the HID endpoint has been busy, and whether it was counted
+static bool hid_busy = false;
+static uint32_t hid_busy_since_us = 0;
+static bool hid_stalled = false;
+
+static const char* const fault_names[L61_FAULT_COUNT] = {
+    [L61_FAULT_SCAN_OVERRUN] = "scan overrun",
+    [L61_FAULT_SETTLE_TIMEOUT] = "settle timeout",
+    [L61_FAULT_USB_STALL] = "usb stall",
+    [L61_FAULT_QUEUE_OVERFLOW] = "queue overflow",
+};
+
+static const char* const event_names[L61_HEALTH_EVENT_COUNT] = {
+    [L61_HEALTH_BOOT] = "boot",
+    [L61_HEALTH_FAULT] = "fault",
+    [L61_HEALTH_MOUNT] = "mount",
+    [L61_HEALTH_UNMOUNT] = "unmount",
+    [L61_HEALTH_SUSPEND] = "suspend",
+    [L61_HEALTH_RESUME] = "resume",
+    [L61_HEALTH_REBOOT] = "reboot",
+};
+
+static const char* const reset_names[RESET_CAUSE_COUNT] = {
+    [RESET_UNKNOWN] = "unknown",
+    [RESET_POWER_ON] = "power on",
+    [RESET_EXTERNAL] = "reset",
+    [RESET_WATCHDOG] = "watchdog",
+    [RESET_HARD_FAULT] = "hard fault",
+    [RESET_REBOOT] = "reboot",
+};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Must be called with interrupts disabled
+static void L61_HOT_FUNC(push)(enum l61_health_event event, uint32_t arg) {
+  struct health_record* record = &records[0];
+  struct trace_entry* entry =
+      &record->trace[record->trace_count & (L61_HEALTH_TRACE_SIZE - 1)];
+  entry->time_us = time_us_32();
+  entry->event = event;
+  entry->arg = arg;
+  record->trace_count++;
+}
+
+static void print_event(const struct trace_entry* entry) {
+  if (entry->event >= L61_HEALTH_EVENT_COUNT)
+    return;
+  const char* name = event_names[entry->event];
+  uint32_t t = entry->time_us;
+  switch (entry->event) {
+    case L61_HEALTH_BOOT:
+      l61_printf("  %5lu.%06lu s  %s after %s\n", t / 1000000, t % 1000000,
+                 name,
+                 entry->arg < RESET_CAUSE_COUNT ? reset_names[entry->arg]
+                                                : "?");
+      break;
+    case L61_HEALTH_FAULT:
+      l61_printf("  %5lu.%06lu s  %s\n", t / 1000000, t % 1000000,
+                 entry->arg < L61_FAULT_COUNT ? fault_names[entry->arg] : "?");
+      break;
+    case L61_HEALTH_REBOOT:
+      l61_printf("  %5lu.%06lu s  %s in %u ms\n", t / 1000000, t % 1000000,
+                 name, entry->arg);
+      break;
+    default:
+      l61_printf("  %5lu.%06lu s  %s\n", t / 1000000, t % 1000000, name);
+      break;
+  }
+}
+
+static void print_record(const struct health_record* record) {
+  l61_printf("longest main loop: %lu us\n", record->loop_max_us);
+  for (uint i = 0; i < L61_FAULT_COUNT; ++i)
+    l61_printf("%s: %lu\n", fault_names[i], record->faults[i]);
+
+  uint32_t count = record->trace_count < L61_HEALTH_TRACE_SIZE
+                       ? record->trace_count
+                       : L61_HEALTH_TRACE_SIZE;
+  l61_printf("last %lu events:\n", count);
+  for (uint32_t i = record->trace_count - count; i != record->trace_count; ++i)
+    print_event(&record->trace[i & (L61_HEALTH_TRACE_SIZE - 1)]);
+}
+
+// Called by isr_hardfault with the registers stacked by the exception
+static void __attribute__((used, noinline)) hard_fault(const uint32_t* frame) {
+  struct health_record* record = &records[0];
+  record->fault_lr = frame[5];
+  record->fault_pc = frame[6];
+  record->fault_xpsr = frame[7];
+  record->end_us = time_us_32();
+  record->reset = RESET_HARD_FAULT;
+  watchdog_reboot(0, 0, 1);
+  while (true) {
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_health_init() {
+  uint32_t cause = RESET_POWER_ON;
+  if (records[0].magic == HEALTH_MAGIC) {
+    records[1] = records[0];
+    if (records[1].reset == RESET_UNKNOWN)
+      records[1].reset =
+          watchdog_enable_caused_reboot() ? RESET_WATCHDOG : RESET_EXTERNAL;
+    cause = records[1].reset;
+  } else {
+    // Power cycle: nothing to keep
+    memset(&records[1], 0, sizeof(records[1]));
+  }
+
+  memset(&records[0], 0, sizeof(records[0]));
+  records[0].magic = HEALTH_MAGIC;
+  l61_health_trace(L61_HEALTH_BOOT, cause);
+}
+
+void l61_health_setup() {
+  // Also replaces the bootloader's longer watchdog on a trial boot, see
+  // lard61_bootctl.h
+  watchdog_enable(L61_HEALTH_WATCHDOG_MS, true);
+  fed_us = time_us_32();
+}
+
+void l61_health_task() {
+  uint32_t now_us = time_us_32();
+  if (!rebooting) {
+    watchdog_update();
+    if (now_us - fed_us > records[0].loop_max_us)
+      records[0].loop_max_us = now_us - fed_us;
+    fed_us = now_us;
+  }
+
+  // Count each time the host stops reading reports while the bus is active
+  if (tud_mounted() && !tud_suspended() &&
+      !tud_hid_n_ready(L61_HID_KEYBOARD)) {
+    if (!hid_busy) {
+      hid_busy = true;
+      hid_busy_since_us = now_us;
+    } else if (!hid_stalled &&
+               now_us - hid_busy_since_us >= L61_HEALTH_USB_STALL_MS * 1000) {
+      hid_stalled = true;
+      l61_health_count(L61_FAULT_USB_STALL);
+    }
+  } else {
+    hid_busy = false;
+    hid_stalled = false;
+  }
+}
+
+void L61_HOT_FUNC(l61_health_count)(enum l61_fault fault) {
+  uint32_t status = save_and_disable_interrupts();
+  records[0].faults[fault]++;
+  push(L61_HEALTH_FAULT, fault);
+  restore_interrupts(status);
+}
+
+void L61_HOT_FUNC(l61_health_trace)(enum l61_health_event event,
+                                    uint32_t arg) {
+  uint32_t status = save_and_disable_interrupts();
+  push(event, arg);
+  restore_interrupts(status);
+}
+
+void l61_health_reboot(uint32_t delay_ms) {
+  l61_health_trace(L61_HEALTH_REBOOT, delay_ms);
+  records[0].end_us = time_us_32();
+  records[0].reset = RESET_REBOOT;
+  rebooting = true;
+  watchdog_reboot(0, 0, delay_ms);
+}
+
+void l61_health_print() {
+  l61_printf("this boot, watchdog %d ms:\n", L61_HEALTH_WATCHDOG_MS);
+  print_record(&records[0]);
+
+  const struct health_record* previous = &records[1];
+  if (previous->magic != HEALTH_MAGIC)
+    return;
+  uint32_t cause = previous->reset < RESET_CAUSE_COUNT ? previous->reset
+                                                       : RESET_UNKNOWN;
+  l61_printf("previous boot, ended by %s", reset_names[cause]);
+  if (cause == RESET_HARD_FAULT) {
+    l61_printf(" at %lu us: pc %08lx, lr %08lx, xpsr %08lx\n",
+               previous->end_us, previous->fault_pc, previous->fault_lr,
+               previous->fault_xpsr);
+  } else if (cause == RESET_REBOOT) {
+    l61_printf(" at %lu us\n", previous->end_us);
+  } else {
+    l61_printf("\n");
+  }
+  print_record(previous);
+}
+
+//-----------------------------------------------------------------------------
+// IRQ callbacks
+//-----------------------------------------------------------------------------
+
+// Replaces the SDK's hard fault handler, which only spins. Passes the stack
+// the exception frame was pushed onto, as told by bit 2 of EXC_RETURN, to
+// hard_fault.
+void __attribute__((naked)) isr_hardfault() {
+  __asm volatile(
+      "movs r0, #4\n"
+      "mov r1, lr\n"
+      "tst r0, r1\n"
+      "bne 1f\n"
+      "mrs r0, msp\n"
+      "b 2f\n"
+      "1:\n"
+      "mrs r0, psp\n"
+      "2:\n"
+      "ldr r1, =hard_fault\n"
+      "bx r1\n"
+      ".ltorg\n");
+}
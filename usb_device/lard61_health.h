@@ -0,0 +1,78 @@
+/*
+** file: lard61_health.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Health monitor: a hardware watchdog fed by the main loop, fault counters
+** and a trace of the last notable events.
+**
+** If the main loop stops for L61_HEALTH_WATCHDOG_MS, the watchdog resets
+** the chip, and the keyboard is back on the bus a few milliseconds later. A
+** hard fault reboots right away the same way, after saving the faulting
+** PC. Counters, trace and fault context live in uninitialised RAM, so the
+** `health` command shows them for the previous boot as well, along with
+** what ended it.
+*/
+
+#ifndef _LARD61_HEALTH_H
+#define _LARD61_HEALTH_H
+
+#include "pico/types.h"
+
+// Longest the main loop may go without feeding the watchdog. Flash sector
+// erases, which block everything, take up to 400ms.
+#define L61_HEALTH_WATCHDOG_MS 500
+// Time the keyboard HID endpoint can stay busy while the bus is active
+// before counting a USB stall
+#define L61_HEALTH_USB_STALL_MS 100
+// Number of events kept in the trace, a power of 2
+#define L61_HEALTH_TRACE_SIZE 32
+
+enum l61_fault {
+  // A timer scan was still running when the next one was due
+  L61_FAULT_SCAN_OVERRUN,
+  // A row pin stayed high after its column was turned off
+  L61_FAULT_SETTLE_TIMEOUT,
+  // The host did not read a keyboard report for L61_HEALTH_USB_STALL_MS
+  L61_FAULT_USB_STALL,
+  // An event was dropped because its queue was full
+  L61_FAULT_QUEUE_OVERFLOW,
+  L61_FAULT_COUNT
+};
+
+enum l61_health_event {
+  // Boot, with the reset cause of the previous one as argument
+  L61_HEALTH_BOOT,
+  // Fault, with its enum l61_fault as argument
+  L61_HEALTH_FAULT,
+  L61_HEALTH_MOUNT,
+  L61_HEALTH_UNMOUNT,
+  L61_HEALTH_SUSPEND,
+  L61_HEALTH_RESUME,
+  // Software reboot, with its delay in ms as argument
+  L61_HEALTH_REBOOT,
+  L61_HEALTH_EVENT_COUNT
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Keep the previous boot's record and start a new one. Must be called
+// right after l61_boot_init.
+void l61_health_init();
+// Start the watchdog, just before entering the main loop
+void l61_health_setup();
+// Feed the watchdog and watch the HID endpoint, from the main loop
+void l61_health_task();
+
+// Count a fault, and add it to the trace
+void l61_health_count(enum l61_fault fault);
+void l61_health_trace(enum l61_health_event event, uint32_t arg);
+// Reboot after `delay_ms`, recording it as a deliberate reset
+void l61_health_reboot(uint32_t delay_ms);
+
+// Print the record of this boot and of the previous one via l61_printf
+void l61_health_print();
+
+#endif /* _LARD61_HEALTH_H */
@@ -0,0 +1,236 @@
+/*
+** file: lard61_hid.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** All report types share the keyboard's interrupt IN endpoint, which can
+** only carry one report per frame. Every time the endpoint is ready, we
+** build all the reports from the current key state and send the highest
+** priority one which differs from what the host last received. Changes to
+** a lower priority report made while the endpoint is busy are coalesced:
+** only the latest state is sent. The keyboard report always goes first, so
+** media keys never delay typing.
+*/
+
+#include "lard61_hid.h"
+
+#include <string.h>
+#include "class/hid/hid_device.h"
+#include "lard61_boot.h"
+#include "lard61_cdc.h"
+#include "lard61_cycles.h"
+#include "lard61_hot.h"
+#include "lard61_keymatrix.h"
+#include "lard61_leader.h"
+#include "lard61_macro.h"
+#include "lard61_report.h"
+#include "lard61_selfbench.h"
+#include "lard61_unicode.h"
+#include "pico/bootrom.h"
+#include "pico/time.h"
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// Reports as last sent to the host
+static struct l61_report sent = {0};
+// Whether the host has been sent each report type since the last protocol
+// change. Until then, it has to be sent even if empty.
+static bool sent_once[L61_REPORT_TYPE_COUNT] = {false};
+// Protocol used for the last report, boot or report
+static uint8_t sent_protocol = HID_PROTOCOL_REPORT;
+// Whether a report may only add one key to the previous one
+static bool key_throttle = true;
+
+static struct {
+  uint32_t sent[L61_REPORT_TYPE_COUNT];
+  uint32_t failed;
+} hid_stats;
+
+static const char* const report_type_names[L61_REPORT_TYPE_COUNT] = {
+    [L61_REPORT_KEYBOARD] = "keyboard",
+    [L61_REPORT_CONSUMER_CONTROL] = "consumer",
+    [L61_REPORT_SYSTEM_CONTROL] = "system",
+};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Return false if the report could not be queued
+static bool L61_HOT_FUNC(send_report)(enum l61_report_type type,
+                                      const struct l61_report* report,
+                                      bool boot_protocol) {
+  bool ok = false;
+  switch (type) {
+    case L61_REPORT_KEYBOARD:
+      if (boot_protocol) {
+        // Boot protocol hosts only read modifiers from the modifier byte
+        uint8_t modifier = 0;
+        uint8_t keycode[6] = {0};
+        uint count = 0;
+        for (uint i = 0; i < sizeof(report->keycode); ++i) {
+          uint8_t key = report->keycode[i];
+          if (key == HID_KEY_NONE)
+            continue;
+          if (key >= HID_KEY_CONTROL_LEFT && key <= HID_KEY_GUI_RIGHT)
+            modifier |= 1 << (key - HID_KEY_CONTROL_LEFT);
+          else
+            keycode[count++] = key;
+        }
+        ok = tud_hid_n_keyboard_report(L61_HID_KEYBOARD, 0, modifier,
+                                       keycode);
+      } else {
+        ok = tud_hid_n_keyboard_report(L61_HID_KEYBOARD,
+                                       L61_REPORT_ID_KEYBOARD, 0,
+                                       report->keycode);
+      }
+      if (ok) {
+        l61_boot_mark(L61_BOOT_FIRST_REPORT);
+        if (report->key_count > 0)
+          l61_boot_mark(L61_BOOT_FIRST_KEY);
+        l61_selfbench_report_queued(time_us_32());
+      }
+      break;
+    case L61_REPORT_CONSUMER_CONTROL:
+      ok = tud_hid_n_report(L61_HID_KEYBOARD, L61_REPORT_ID_CONSUMER_CONTROL,
+                            &report->consumer, sizeof(report->consumer));
+      break;
+    case L61_REPORT_SYSTEM_CONTROL:
+      ok = tud_hid_n_report(L61_HID_KEYBOARD, L61_REPORT_ID_SYSTEM_CONTROL,
+                            &report->system, sizeof(report->system));
+      break;
+    default:
+      break;
+  }
+
+  if (!ok) {
+    hid_stats.failed++;
+    return false;
+  }
+
+  hid_stats.sent[type]++;
+  sent_once[type] = true;
+  switch (type) {
+    case L61_REPORT_KEYBOARD:
+      memcpy(sent.keycode, report->keycode, sizeof(sent.keycode));
+      sent.key_count = report->key_count;
+      break;
+    case L61_REPORT_CONSUMER_CONTROL:
+      sent.consumer = report->consumer;
+      break;
+    case L61_REPORT_SYSTEM_CONTROL:
+      sent.system = report->system;
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+static void L61_HOT_FUNC(hid_task)() {
+  // As soon as HID interface is ready, send a report
+  if (!tud_hid_n_ready(L61_HID_KEYBOARD)) {
+    return;
+  }
+
+  // Check for the magic reflash combination:
+  // If user presses Ctrl + Alt + Fn + R, reboot in usb flash mode
+  if (l61_keymatrix_is_key_pressed(L61_KEY_LEFT_CONTROL) &&
+      l61_keymatrix_is_key_pressed(L61_KEY_LEFT_ALT) &&
+      l61_keymatrix_is_key_pressed(L61_KEY_FN) &&
+      l61_keymatrix_is_key_pressed(L61_KEY_R)) {
+    reset_usb_boot(1 << PICO_DEFAULT_LED_PIN, 0);
+  }
+
+  // The host forgets about previous reports when switching protocols
+  uint8_t protocol = tud_hid_n_get_protocol(L61_HID_KEYBOARD);
+  if (protocol != sent_protocol) {
+    sent_protocol = protocol;
+    memset(sent_once, 0, sizeof(sent_once));
+  }
+  bool boot_protocol = protocol == HID_PROTOCOL_BOOT;
+
+  // Leader sequences take their keys out of the reports, and then type
+  // their text instead of the key matrix state
+  l61_leader_update(time_us_32());
+  struct l61_report report;
+  if (l61_leader_get_report(&report)) {
+    if (send_report(L61_REPORT_KEYBOARD, &report, boot_protocol))
+      l61_leader_report_sent();
+    return;
+  }
+  // So does a dynamic macro being played
+  if (l61_macro_get_report(&report)) {
+    if (send_report(L61_REPORT_KEYBOARD, &report, boot_protocol))
+      l61_macro_report_sent();
+    return;
+  }
+  // And Unicode input
+  if (l61_unicode_get_report(&report)) {
+    if (send_report(L61_REPORT_KEYBOARD, &report, boot_protocol))
+      l61_unicode_report_sent();
+    return;
+  }
+
+  // Do not report more than one additional key compared to the previous
+  // report. This prevents multiple keys being repeated.
+  //
+  // Without this, if the user presses and holds Q and W simultaneously,
+  // the host will repeat both q and w, yielding "qwqwqwqwqw...". The expected
+  // behaviour is to repeat the last key that was pressed, so in case of
+  // exactly simultaneous keypresses, give priority to the lowest key index.
+  // Games rather want chords in a single report, see l61_hid_set_key_throttle.
+  uint max_keys = key_throttle ? sent.key_count + 1u : sizeof(report.keycode);
+  uint32_t build_start = l61_cycles_now();
+  l61_report_build(&report, max_keys);
+  l61_cycles_record(L61_CYCLES_REPORT, build_start);
+
+  if (!sent_once[L61_REPORT_KEYBOARD] ||
+      memcmp(report.keycode, sent.keycode, sizeof(report.keycode)) != 0) {
+    send_report(L61_REPORT_KEYBOARD, &report, boot_protocol);
+    return;
+  }
+
+  // Boot protocol hosts only understand the keyboard report
+  if (boot_protocol)
+    return;
+
+  if (!sent_once[L61_REPORT_CONSUMER_CONTROL] ||
+      report.consumer != sent.consumer) {
+    send_report(L61_REPORT_CONSUMER_CONTROL, &report, boot_protocol);
+  } else if (!sent_once[L61_REPORT_SYSTEM_CONTROL] ||
+             report.system != sent.system) {
+    send_report(L61_REPORT_SYSTEM_CONTROL, &report, boot_protocol);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void L61_HOT_FUNC(l61_hid_task)() {
+  uint32_t start = l61_cycles_now();
+  hid_task();
+  l61_cycles_record(L61_CYCLES_HID_TASK, start);
+}
+
+void l61_hid_set_key_throttle(bool throttle) {
+  key_throttle = throttle;
+}
+
+bool l61_hid_get_key_throttle() {
+  return key_throttle;
+}
+
+void l61_hid_print_stats() {
+  for (uint i = 0; i < L61_REPORT_TYPE_COUNT; ++i) {
+    l61_printf("%s reports: %lu\n", report_type_names[i], hid_stats.sent[i]);
+  }
+  l61_printf("failed: %lu\n", hid_stats.failed);
+}
+
+uint32_t l61_hid_get_sent(enum l61_report_type type) {
+  return hid_stats.sent[type];
+}
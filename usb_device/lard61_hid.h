@@ -0,0 +1,53 @@
+/*
+** file: lard61_hid.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Scheduling of the HID reports on the keyboard interrupt endpoint.
+*/
+
+#ifndef _LARD61_HID_H
+#define _LARD61_HID_H
+
+#include "pico/types.h"
+
+// TinyUSB HID instances, in the order of the interfaces in the
+// configuration descriptor
+enum l61_hid_instance {
+  L61_HID_KEYBOARD = 0,
+  L61_HID_MOUSE = 1,
+};
+
+// Report IDs of the keyboard HID interface. Only used in report protocol:
+// in boot protocol, the host expects plain keyboard reports with no ID.
+enum l61_report_id {
+  L61_REPORT_ID_KEYBOARD = 1,
+  L61_REPORT_ID_CONSUMER_CONTROL,
+  L61_REPORT_ID_SYSTEM_CONTROL,
+};
+
+// Report types, in order of priority on the endpoint
+enum l61_report_type {
+  L61_REPORT_KEYBOARD,
+  L61_REPORT_CONSUMER_CONTROL,
+  L61_REPORT_SYSTEM_CONTROL,
+  L61_REPORT_TYPE_COUNT
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Poll the keymatrix state and send a HID report if anything changed
+void l61_hid_task();
+// Whether keyboard reports may only add one key to the previous one, so
+// that the host repeats the last key pressed of a chord (default), or carry
+// every key pressed at once, so that chords reach the host in one report
+void l61_hid_set_key_throttle(bool throttle);
+bool l61_hid_get_key_throttle();
+// Print the number of reports sent for each report type via l61_printf
+void l61_hid_print_stats();
+// Number of reports of `type` sent since power on
+uint32_t l61_hid_get_sent(enum l61_report_type type);
+
+#endif /* _LARD61_HID_H */
@@ -0,0 +1,32 @@
+/*
+** file: lard61_hot.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Placement of the latency-critical code and data.
+**
+** By default, everything runs from the QSPI flash through the XIP cache,
+** so a cache miss in the middle of a scan costs a flash read, and any flash
+** write stalls the scan entirely. When building with the CMake option
+** L61_HOT_PATH_IN_RAM, functions and tables marked with the macros below are
+** copied to SRAM at boot instead.
+**
+** Use as:
+**   void L61_HOT_FUNC(my_function)(uint arg) { ... }
+**   static const uint8_t my_table[4] L61_HOT_DATA(my_table) = { ... };
+*/
+
+#ifndef _LARD61_HOT_H
+#define _LARD61_HOT_H
+
+#include "pico/platform.h"
+
+#ifdef L61_HOT_PATH_IN_RAM
+#define L61_HOT_FUNC(name) __not_in_flash_func(name)
+#define L61_HOT_DATA(name) __not_in_flash(#name)
+#else
+#define L61_HOT_FUNC(name) name
+#define L61_HOT_DATA(name)
+#endif
+
+#endif /* _LARD61_HOT_H */
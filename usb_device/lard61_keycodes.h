@@ -4,199 +4,66 @@
 ** creation date: 12/07/2024
 **
 ** Convert from lard61 keymatrix index to HID keycodes.
+**
+** Keymap entries are 16 bits wide. The top 4 bits select the HID report
+** the entry belongs to, the rest is the usage within that report:
+** - plain HID_KEY_* values go into the keyboard report,
+** - L61_CONSUMER(HID_USAGE_CONSUMER_*) into the consumer control report,
+** - L61_SYSTEM(L61_SYSTEM_*) into the system control report,
+** - L61_MOUSE(L61_MOUSE_*) is handled by the mouse keys,
+** - L61_LEADER starts a leader key sequence (see lard61_leader.h),
+** - L61_MACRO_RECORD(slot) and L61_MACRO_PLAY(slot) record and play a
+**   dynamic macro (see lard61_macro.h),
+** - L61_STENO_TOGGLE turns steno mode on and off (see lard61_steno.h),
+** - L61_UNICODE(L61_UC_*) types a character through the host's Unicode
+**   input method (see lard61_unicode.h),
+** - L61_PROFILE(index) and L61_PROFILE_NEXT switch the performance profile
+**   (see lard61_profile.h).
+**
+** The default keymap is in lard61_keymap_default.cpp.
 */
 
 #ifndef _LARD61_KEYCODES_H
 #define _LARD61_KEYCODES_H
 
 #include "class/hid/hid.h"
-#include "lard61_keymatrix.h"
+#include "lard61_macro.h"
+#include "lard61_mousekeys.h"
+#include "lard61_profile.h"
+#include "lard61_unicode.h"
 
-// Identifiers for specific keys
-// Use as argument to l61_keymatrix_is_key_pressed to check for
-// specific keys
-enum L61_KEY_INDEX {
-  L61_KEY_GRAVE = 0,
-  L61_KEY_R = 18,
-  L61_KEY_LEFT_CONTROL = 53,
-  L61_KEY_LEFT_ALT = 55,
-  L61_KEY_FN = 63,
-};
+#define L61_KC_TYPE_MASK 0xF000
+#define L61_KC_USAGE_MASK 0x0FFF
+#define L61_KC_KEYBOARD 0x0000
+#define L61_KC_CONSUMER 0x1000
+#define L61_KC_SYSTEM 0x2000
+#define L61_KC_MOUSE 0x3000
+#define L61_KC_LEADER 0x4000
+#define L61_KC_MACRO 0x5000
+#define L61_KC_STENO 0x6000
+#define L61_KC_UNICODE 0x7000
+#define L61_KC_PROFILE 0x8000
 
-// HID keycode associated to each key
-// Differences with usual ANSI layout:
-// - Caps lock is replaced by escape
-const uint8_t l61_hid_keycode[N_ROWS * N_COLS] = {
-    // Row 0: index 0-13
-    HID_KEY_GRAVE,
-    HID_KEY_1,
-    HID_KEY_2,
-    HID_KEY_3,
-    HID_KEY_4,
-    HID_KEY_5,
-    HID_KEY_6,
-    HID_KEY_7,
-    HID_KEY_8,
-    HID_KEY_9,
-    HID_KEY_0,
-    HID_KEY_MINUS,
-    HID_KEY_EQUAL,
-    HID_KEY_BACKSPACE,
-    // Row 1: index 14-27
-    HID_KEY_TAB,
-    HID_KEY_Q,
-    HID_KEY_W,
-    HID_KEY_E,
-    HID_KEY_R,
-    HID_KEY_T,
-    HID_KEY_Y,
-    HID_KEY_U,
-    HID_KEY_I,
-    HID_KEY_O,
-    HID_KEY_P,
-    HID_KEY_BRACKET_LEFT,
-    HID_KEY_BRACKET_RIGHT,
-    HID_KEY_BACKSLASH,
-    // Row 2: index 28-40
-    HID_KEY_ESCAPE,  // Caps lock replaced with escape
-    HID_KEY_A,
-    HID_KEY_S,
-    HID_KEY_D,
-    HID_KEY_F,
-    HID_KEY_G,
-    HID_KEY_H,
-    HID_KEY_J,
-    HID_KEY_K,
-    HID_KEY_L,
-    HID_KEY_SEMICOLON,
-    HID_KEY_APOSTROPHE,
-    HID_KEY_ENTER,
-    // Row 3: index 41-52
-    HID_KEY_SHIFT_LEFT,
-    HID_KEY_Z,
-    HID_KEY_X,
-    HID_KEY_C,
-    HID_KEY_V,
-    HID_KEY_B,
-    HID_KEY_N,
-    HID_KEY_M,
-    HID_KEY_COMMA,
-    HID_KEY_PERIOD,
-    HID_KEY_SLASH,
-    HID_KEY_SHIFT_RIGHT,
-    // Row 4: index 53-69
-    HID_KEY_CONTROL_LEFT,
-    HID_KEY_GUI_LEFT,
-    HID_KEY_ALT_LEFT,
-    HID_KEY_SPACE,
-    // Space bar is on column 3, but Right alt is on column 8
-    // So we need some NONE entries to pad
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_ALT_RIGHT,
-    HID_KEY_GUI_RIGHT,
-    HID_KEY_NONE,  // Function/layer key, handled in
-                   // l61_keymatrix_is_fn_key_pressed
-    HID_KEY_CONTROL_RIGHT,
-    // The rest of the keymatrix does not correspond to a key
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-};
+#define L61_CONSUMER(usage) (L61_KC_CONSUMER | (usage))
+#define L61_SYSTEM(usage) (L61_KC_SYSTEM | (usage))
+#define L61_MOUSE(action) (L61_KC_MOUSE | (action))
+#define L61_LEADER L61_KC_LEADER
+#define L61_MACRO_RECORD(slot) \
+  (L61_KC_MACRO | (L61_MACRO_ACTION_RECORD << 8) | (slot))
+#define L61_MACRO_PLAY(slot) \
+  (L61_KC_MACRO | (L61_MACRO_ACTION_PLAY << 8) | (slot))
+#define L61_STENO_TOGGLE L61_KC_STENO
+#define L61_UNICODE(symbol) (L61_KC_UNICODE | (symbol))
+#define L61_PROFILE(index) (L61_KC_PROFILE | (index))
+#define L61_PROFILE_NEXT (L61_KC_PROFILE | L61_PROFILE_USAGE_NEXT)
 
-// Keycode associated with each key, when the function key is also pressed
-// Differences with the table above:
-// - Backtick (GRAVE) on the top left ESC key
-// - F1-F12 keys on the top layer
-// - Directional arrows on WASD, PG_UP on Q, PG_DOWN on E
-// - Directional arrows on PL:" for one-handed motions
-// - Delete key on backspace
-// - HOME on R, END on F
-// - Caps lock on the physical caps lock key
-// - Escape on the top left key (tilde)
-const uint8_t l61_hid_keycode_fn[N_ROWS * N_COLS] = {
-    // Row 0: index 0-13
-    HID_KEY_ESCAPE,  // Tilde becomes secondary Esc
-    HID_KEY_F1,
-    HID_KEY_F2,
-    HID_KEY_F3,
-    HID_KEY_F4,
-    HID_KEY_F5,
-    HID_KEY_F6,
-    HID_KEY_F7,
-    HID_KEY_F8,
-    HID_KEY_F9,
-    HID_KEY_F10,
-    HID_KEY_F11,
-    HID_KEY_F12,
-    HID_KEY_DELETE,
-    // Row 1: index 14-27
-    HID_KEY_TAB,
-    HID_KEY_PAGE_UP,
-    HID_KEY_ARROW_UP,
-    HID_KEY_PAGE_DOWN,
-    HID_KEY_HOME,
-    HID_KEY_T,
-    HID_KEY_Y,
-    HID_KEY_U,
-    HID_KEY_I,
-    HID_KEY_O,
-    HID_KEY_ARROW_UP,
-    HID_KEY_BRACKET_LEFT,
-    HID_KEY_BRACKET_RIGHT,
-    HID_KEY_BACKSLASH,
-    // Row 2: index 28-40
-    HID_KEY_CAPS_LOCK,
-    HID_KEY_ARROW_LEFT,
-    HID_KEY_ARROW_DOWN,
-    HID_KEY_ARROW_RIGHT,
-    HID_KEY_END,
-    HID_KEY_G,
-    HID_KEY_H,
-    HID_KEY_J,
-    HID_KEY_K,
-    HID_KEY_ARROW_LEFT,
-    HID_KEY_ARROW_DOWN,
-    HID_KEY_ARROW_RIGHT,
-    HID_KEY_ENTER,
-    // Row 3: index 41-52
-    HID_KEY_SHIFT_LEFT,
-    HID_KEY_Z,
-    HID_KEY_X,
-    HID_KEY_C,
-    HID_KEY_V,
-    HID_KEY_B,
-    HID_KEY_N,
-    HID_KEY_M,
-    HID_KEY_COMMA,
-    HID_KEY_PERIOD,
-    HID_KEY_SLASH,
-    HID_KEY_SHIFT_RIGHT,
-    // Row 4: index 53-69
-    HID_KEY_CONTROL_LEFT,
-    HID_KEY_GUI_LEFT,
-    HID_KEY_ALT_LEFT,
-    HID_KEY_SPACE,
-    // Space bar is on column 3, but Right alt is on column 8
-    // So we need some NONE entries to pad
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_ALT_RIGHT,
-    HID_KEY_GUI_RIGHT,
-    HID_KEY_NONE,  // Function/layer key
-    HID_KEY_CONTROL_RIGHT,
-    // The rest of the keymatrix does not correspond to a key
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
-    HID_KEY_NONE,
+// Values of the 2-bit system control report
+// (see TUD_HID_REPORT_DESC_SYSTEM_CONTROL)
+enum l61_system_control {
+  L61_SYSTEM_NONE = 0,
+  L61_SYSTEM_POWER_DOWN = 1,
+  L61_SYSTEM_SLEEP = 2,
+  L61_SYSTEM_WAKE_UP = 3,
 };
 
 #endif /* _LARD61_KEYCODES_H */
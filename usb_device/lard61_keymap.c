@@ -0,0 +1,238 @@
+/*
+** file: lard61_keymap.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Two keymap buffers live in RAM. `active` points to the one reports are
+** built from, the other receives uploads. Both the upload and the reports
+** run from the main loop, so swapping the pointer between two reports is
+** atomic with respect to them, and the report path pays for one pointer
+** load per report, as it did for picking the layer table before.
+**
+** Persisting the new keymap to flash happens after the swap: the sector
+** erase stalls the keyboard for a few tens of milliseconds once, but the new
+** keymap is already in use by then.
+*/
+
+#include "lard61_keymap.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "class/cdc/cdc_device.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_crc.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "pico/time.h"
+
+// Keys per line when dumping the keymap
+#define DUMP_KEYS_PER_LINE N_COLS
+// Room needed in the CDC TX FIFO to print one dump line
+#define DUMP_LINE_SIZE (8 * DUMP_KEYS_PER_LINE + 2)
+
+enum keymap_source {
+  KEYMAP_DEFAULT,
+  KEYMAP_STORED,
+  KEYMAP_UPLOADED,
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct l61_keymap keymaps[2];
+static const struct l61_keymap* volatile active = &keymaps[0];
+static enum keymap_source source = KEYMAP_DEFAULT;
+
+// Upload in progress
+static struct {
+  bool receiving;
+  uint32_t crc;
+  uint32_t received;
+  // Time of the last data received, for the timeout
+  uint32_t last_rx_ms;
+} upload;
+
+// Next line to print while dumping, or -1 if not dumping
+static int dump_line = -1;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t now_ms() {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+// Buffer which is not in use by reports
+static struct l61_keymap* inactive() {
+  return active == &keymaps[0] ? &keymaps[1] : &keymaps[0];
+}
+
+// Whether every entry is a keycode that l61_report_build knows about
+static bool keymap_valid(const struct l61_keymap* keymap) {
+  for (uint layer = 0; layer < L61_LAYER_COUNT; ++layer) {
+    for (uint i = 0; i < N_ROWS * N_COLS; ++i) {
+      uint16_t keycode = keymap->keycode[layer][i];
+      uint16_t usage = keycode & L61_KC_USAGE_MASK;
+      switch (keycode & L61_KC_TYPE_MASK) {
+        case L61_KC_KEYBOARD:
+          if (usage > 0xff)
+            return false;
+          break;
+        case L61_KC_CONSUMER:
+          break;
+        case L61_KC_SYSTEM:
+          if (usage > L61_SYSTEM_WAKE_UP)
+            return false;
+          break;
+        case L61_KC_MOUSE:
+          if (usage >= L61_MOUSE_ACTION_COUNT)
+            return false;
+          break;
+        case L61_KC_LEADER:
+        case L61_KC_STENO:
+          if (usage != 0)
+            return false;
+          break;
+        case L61_KC_MACRO:
+          if ((usage >> 8) >= L61_MACRO_ACTION_COUNT ||
+              (usage & 0xff) >= L61_MACRO_SLOT_COUNT)
+            return false;
+          break;
+        case L61_KC_UNICODE:
+          if (usage >= L61_UC_COUNT)
+            return false;
+          break;
+        case L61_KC_PROFILE:
+          if (usage >= L61_PROFILE_COUNT && usage != L61_PROFILE_USAGE_NEXT)
+            return false;
+          break;
+        default:
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void finish_upload() {
+  struct l61_keymap* keymap = inactive();
+  upload.receiving = false;
+  l61_cdc_set_raw(false);
+
+  uint32_t crc = l61_crc32(L61_CRC32_INIT, keymap, sizeof(*keymap));
+  if (crc != upload.crc) {
+    l61_printf("keymap: crc mismatch, got %08lx\n", crc);
+    return;
+  }
+  if (!keymap_valid(keymap)) {
+    l61_printf("keymap: invalid keycodes\n");
+    return;
+  }
+
+  active = keymap;
+  source = KEYMAP_UPLOADED;
+  l61_config_store(L61_CONFIG_KEYMAP, keymap, sizeof(*keymap));
+  l61_printf("keymap: ok\n");
+}
+
+static void receive() {
+  uint8_t* buffer = (uint8_t*)inactive();
+  uint32_t len = sizeof(struct l61_keymap) - upload.received;
+  if (len > 0 && tud_cdc_available()) {
+    upload.received += tud_cdc_read(buffer + upload.received, len);
+    upload.last_rx_ms = now_ms();
+  }
+
+  if (upload.received == sizeof(struct l61_keymap)) {
+    finish_upload();
+  } else if (now_ms() - upload.last_rx_ms > L61_KEYMAP_UPLOAD_TIMEOUT_MS) {
+    l61_printf("keymap: timeout after %lu bytes\n", upload.received);
+    upload.receiving = false;
+    l61_cdc_set_raw(false);
+  }
+}
+
+// Print the next line of the dump if it fits in the CDC TX FIFO
+static void dump_next_line() {
+  const uint lines_per_layer = N_ROWS * N_COLS / DUMP_KEYS_PER_LINE;
+  if (tud_cdc_write_available() < DUMP_LINE_SIZE)
+    return;
+
+  uint layer = dump_line / lines_per_layer;
+  uint line = dump_line % lines_per_layer;
+  if (line == 0)
+    l61_printf("[%s]\n", layer == L61_LAYER_BASE ? "base" : "fn");
+
+  char text[DUMP_LINE_SIZE];
+  char* write = text;
+  for (uint i = 0; i < DUMP_KEYS_PER_LINE; ++i) {
+    write += sprintf(write, "%s0x%04x", i == 0 ? "" : " ",
+                     active->keycode[layer][line * DUMP_KEYS_PER_LINE + i]);
+  }
+  l61_printf("%s\n", text);
+
+  dump_line++;
+  if (dump_line == (int)(L61_LAYER_COUNT * lines_per_layer))
+    dump_line = -1;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_keymap_setup() {
+  if (l61_config_load(L61_CONFIG_KEYMAP, &keymaps[0], sizeof(keymaps[0])) &&
+      keymap_valid(&keymaps[0])) {
+    source = KEYMAP_STORED;
+  } else {
+    keymaps[0] = l61_keymap_default;
+    source = KEYMAP_DEFAULT;
+  }
+  active = &keymaps[0];
+}
+
+const struct l61_keymap* L61_HOT_FUNC(l61_keymap_get)() {
+  return active;
+}
+
+void l61_keymap_task() {
+  if (upload.receiving)
+    receive();
+  else if (dump_line >= 0)
+    dump_next_line();
+}
+
+void l61_keymap_upload(uint32_t crc) {
+  upload.receiving = true;
+  upload.crc = crc;
+  upload.received = 0;
+  upload.last_rx_ms = now_ms();
+  // Anything the host sends from now on is keymap data
+  l61_cdc_set_raw(true);
+  l61_printf("ready %u\n", (uint)sizeof(struct l61_keymap));
+}
+
+void l61_keymap_reset() {
+  struct l61_keymap* keymap = inactive();
+  *keymap = l61_keymap_default;
+  active = keymap;
+  source = KEYMAP_DEFAULT;
+  l61_config_clear(L61_CONFIG_KEYMAP);
+}
+
+void l61_keymap_dump() {
+  dump_line = 0;
+}
+
+void l61_keymap_print_status() {
+  static const char* const source_names[] = {
+      [KEYMAP_DEFAULT] = "default",
+      [KEYMAP_STORED] = "stored",
+      [KEYMAP_UPLOADED] = "uploaded",
+  };
+  l61_printf("keymap: %s, crc %08lx\n", source_names[source],
+             l61_crc32(L61_CRC32_INIT, active, sizeof(*active)));
+}
@@ -0,0 +1,59 @@
+/*
+** file: lard61_keymap.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Keymap held in RAM, which the host can replace at runtime.
+**
+** At boot, the keymap stored in flash is loaded if there is one, otherwise
+** the default one from lard61_keymap_default.cpp. A new keymap is uploaded
+** over the CDC into a second buffer, verified, then activated by swapping a
+** single pointer. Entries follow the format of lard61_keycodes.h.
+*/
+
+#ifndef _LARD61_KEYMAP_H
+#define _LARD61_KEYMAP_H
+
+#include "lard61_keymatrix.h"
+#include "pico/types.h"
+
+// Abort an upload if no data was received for this long
+#define L61_KEYMAP_UPLOAD_TIMEOUT_MS 2000
+
+enum l61_keymap_layer {
+  L61_LAYER_BASE,
+  // Used while the function key is held
+  L61_LAYER_FN,
+  L61_LAYER_COUNT,
+};
+
+// Keycode of each key on each layer
+struct l61_keymap {
+  uint16_t keycode[L61_LAYER_COUNT][N_ROWS * N_COLS];
+};
+
+// Keymap used when none is stored, from lard61_keymap_default.cpp
+extern const struct l61_keymap l61_keymap_default;
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the stored keymap, or the default one
+void l61_keymap_setup();
+// Keymap to build reports from. Callers must read it once per report, so
+// that a report never mixes entries from two keymaps.
+const struct l61_keymap* l61_keymap_get();
+// Receive uploads and print dumps
+void l61_keymap_task();
+
+// Receive a keymap from the host and activate it if its CRC-32 matches
+void l61_keymap_upload(uint32_t crc);
+// Go back to the default keymap and forget the stored one
+void l61_keymap_reset();
+// Print the active keymap in the format accepted by tools/l61_keymap.py
+void l61_keymap_dump();
+// Print where the active keymap comes from and its CRC
+void l61_keymap_print_status();
+
+#endif /* _LARD61_KEYMAP_H */
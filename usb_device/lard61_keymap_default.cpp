@@ -0,0 +1,161 @@
+/*
+** file: lard61_keymap_default.cpp
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Default keymap, written key by key in physical order and laid out into
+** the matrix at compile time (see lard61_layout.hpp).
+*/
+
+#include "lard61_layout.hpp"
+
+// Differences with usual ANSI layout:
+// - Caps lock is replaced by escape
+constexpr auto base_layer = l61::layer(
+    l61::row(HID_KEY_GRAVE,
+             HID_KEY_1,
+             HID_KEY_2,
+             HID_KEY_3,
+             HID_KEY_4,
+             HID_KEY_5,
+             HID_KEY_6,
+             HID_KEY_7,
+             HID_KEY_8,
+             HID_KEY_9,
+             HID_KEY_0,
+             HID_KEY_MINUS,
+             HID_KEY_EQUAL,
+             HID_KEY_BACKSPACE),
+    l61::row(HID_KEY_TAB,
+             HID_KEY_Q,
+             HID_KEY_W,
+             HID_KEY_E,
+             HID_KEY_R,
+             HID_KEY_T,
+             HID_KEY_Y,
+             HID_KEY_U,
+             HID_KEY_I,
+             HID_KEY_O,
+             HID_KEY_P,
+             HID_KEY_BRACKET_LEFT,
+             HID_KEY_BRACKET_RIGHT,
+             HID_KEY_BACKSLASH),
+    l61::row(HID_KEY_ESCAPE,  // Caps lock replaced with escape
+             HID_KEY_A,
+             HID_KEY_S,
+             HID_KEY_D,
+             HID_KEY_F,
+             HID_KEY_G,
+             HID_KEY_H,
+             HID_KEY_J,
+             HID_KEY_K,
+             HID_KEY_L,
+             HID_KEY_SEMICOLON,
+             HID_KEY_APOSTROPHE,
+             HID_KEY_ENTER),
+    l61::row(HID_KEY_SHIFT_LEFT,
+             HID_KEY_Z,
+             HID_KEY_X,
+             HID_KEY_C,
+             HID_KEY_V,
+             HID_KEY_B,
+             HID_KEY_N,
+             HID_KEY_M,
+             HID_KEY_COMMA,
+             HID_KEY_PERIOD,
+             HID_KEY_SLASH,
+             HID_KEY_SHIFT_RIGHT),
+    l61::row(HID_KEY_CONTROL_LEFT,
+             HID_KEY_GUI_LEFT,
+             HID_KEY_ALT_LEFT,
+             HID_KEY_SPACE,
+             HID_KEY_ALT_RIGHT,
+             HID_KEY_GUI_RIGHT,
+             l61::fn,  // Handled in l61_keymatrix_is_fn_key_pressed
+             HID_KEY_CONTROL_RIGHT));
+
+// Keycode associated with each key, when the function key is also pressed
+// Differences with the base layer:
+// - Backtick (GRAVE) on the top left ESC key
+// - F1-F12 keys on the top layer
+// - Directional arrows on WASD, PG_UP on Q, PG_DOWN on E
+// - Directional arrows on PL:" for one-handed motions
+// - Delete key on backspace
+// - HOME on R, END on F
+// - Caps lock on the physical caps lock key
+// - Escape on the top left key (tilde)
+// - Media keys on the bottom left: previous, play/pause, next on ZXC
+//   and mute, volume down, volume up on M,.
+// - Screen brightness down/up on the square brackets
+// - Sleep on backslash
+// - Mouse keys: pointer on YGHJ, left/right/middle buttons on UIO,
+//   wheel up/down on T and B
+// - Dynamic macro: record/stop on N, play on V
+// - Steno mode toggle on K
+// - Degree sign on slash
+// - Leader key on space
+// - Next performance profile on tab
+constexpr auto fn_layer = l61::layer(
+    l61::row(HID_KEY_ESCAPE,  // Tilde becomes secondary Esc
+             HID_KEY_F1,
+             HID_KEY_F2,
+             HID_KEY_F3,
+             HID_KEY_F4,
+             HID_KEY_F5,
+             HID_KEY_F6,
+             HID_KEY_F7,
+             HID_KEY_F8,
+             HID_KEY_F9,
+             HID_KEY_F10,
+             HID_KEY_F11,
+             HID_KEY_F12,
+             HID_KEY_DELETE),
+    l61::row(L61_PROFILE_NEXT,
+             HID_KEY_PAGE_UP,
+             HID_KEY_ARROW_UP,
+             HID_KEY_PAGE_DOWN,
+             HID_KEY_HOME,
+             L61_MOUSE(L61_MOUSE_WHEEL_UP),
+             L61_MOUSE(L61_MOUSE_UP),
+             L61_MOUSE(L61_MOUSE_BUTTON_LEFT),
+             L61_MOUSE(L61_MOUSE_BUTTON_RIGHT),
+             L61_MOUSE(L61_MOUSE_BUTTON_MIDDLE),
+             HID_KEY_ARROW_UP,
+             L61_CONSUMER(HID_USAGE_CONSUMER_BRIGHTNESS_DECREMENT),
+             L61_CONSUMER(HID_USAGE_CONSUMER_BRIGHTNESS_INCREMENT),
+             L61_SYSTEM(L61_SYSTEM_SLEEP)),
+    l61::row(HID_KEY_CAPS_LOCK,
+             HID_KEY_ARROW_LEFT,
+             HID_KEY_ARROW_DOWN,
+             HID_KEY_ARROW_RIGHT,
+             HID_KEY_END,
+             L61_MOUSE(L61_MOUSE_LEFT),
+             L61_MOUSE(L61_MOUSE_DOWN),
+             L61_MOUSE(L61_MOUSE_RIGHT),
+             L61_STENO_TOGGLE,
+             HID_KEY_ARROW_LEFT,
+             HID_KEY_ARROW_DOWN,
+             HID_KEY_ARROW_RIGHT,
+             l61::trans),
+    l61::row(l61::trans,
+             L61_CONSUMER(HID_USAGE_CONSUMER_SCAN_PREVIOUS),
+             L61_CONSUMER(HID_USAGE_CONSUMER_PLAY_PAUSE),
+             L61_CONSUMER(HID_USAGE_CONSUMER_SCAN_NEXT),
+             L61_MACRO_PLAY(0),
+             L61_MOUSE(L61_MOUSE_WHEEL_DOWN),
+             L61_MACRO_RECORD(0),
+             L61_CONSUMER(HID_USAGE_CONSUMER_MUTE),
+             L61_CONSUMER(HID_USAGE_CONSUMER_VOLUME_DECREMENT),
+             L61_CONSUMER(HID_USAGE_CONSUMER_VOLUME_INCREMENT),
+             L61_UNICODE(L61_UC_DEGREE),
+             l61::trans),
+    l61::row(l61::trans,
+             l61::trans,
+             l61::trans,
+             L61_LEADER,
+             l61::trans,
+             l61::trans,
+             l61::fn,
+             l61::trans));
+
+constexpr l61_keymap l61_keymap_default = l61::keymap(base_layer, fn_layer);
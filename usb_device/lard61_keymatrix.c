@@ -7,8 +7,19 @@
 #include "lard61_keymatrix.h"
 #include <stdio.h>
 #include <string.h>
+#include "class/cdc/cdc_device.h"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "lard61_capture.h"
 #include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_cycles.h"
+#include "lard61_debounce.h"
+#include "lard61_health.h"
+#include "lard61_hot.h"
+#include "lard61_selfbench.h"
+#include "lard61_stream.h"
 #include "pico/time.h"
 #include "pico/types.h"
 
@@ -16,14 +27,16 @@
 // Static variables
 //-----------------------------------------------------------------------------
 
-// Minimum time between a key being first pressed/released and the
-// moment it is registered
-#define DEBOUNCE_THRESHOLD_MS 4
+// Learned debounce windows are saved at most this often, and only while no
+// key is pressed, since the flash erase stalls the keyboard
+#define DEBOUNCE_SAVE_INTERVAL_MS (10 * 60 * 1000)
+// Room needed in the CDC TX FIFO to print one line of debounce statistics
+#define DEBOUNCE_LINE_SIZE 96
 
-// Time of the last occurrence of a key state change
-// The debounced keymatrix state will be updated once the time difference
-// becomes greater than DEBOUNCE_THRESHOLD
-absolute_time_t last_change_time;
+// Time of the last save of the debounce table
+static uint32_t debounce_saved_ms = 0;
+// Next key to print the debounce statistics of, or -1 if not printing
+static int debounce_print_key = -1;
 
 // Keymatrix column whose pin is currently high.
 // Shared state between the main process and l61_keymatrix_gpio_callback.
@@ -35,20 +48,21 @@ volatile uint active_col = 0;
 
 // Keys that are registered as pressed, after debouncing
 bool pressed[N_COLS * N_ROWS] = {0};
-// Encodes whether a key was down in the last call to l61_keymatrix_update.
-bool pressed_last[N_COLS * N_ROWS] = {0};
 // Whether the key is down during the current call to l61_keymatrix_update.
 // Shared state between the main process and l61_keymatrix_gpio_callback.
 volatile bool pressed_this_update[N_COLS * N_ROWS] = {false};
+// Number of keys in `pressed`
+static uint pressed_count = 0;
 
 // Index of the function (Fn) key in the above arrays.
 #define L61_FN_KEY 63
 
 // Number of keys per row in the keymatrix
-static const uint n_keys_in_row[N_ROWS] = {14, 14, 13, 12, 8};
+static const uint n_keys_in_row[N_ROWS] L61_HOT_DATA(n_keys_in_row) =
+    L61_KEYS_IN_ROW;
 
 // GPIO pins for each row
-static const uint row_pin[N_ROWS] = {
+static const uint row_pin[N_ROWS] L61_HOT_DATA(row_pin) = {
     19,  // row0
     20,  // row1
     21,  // row2
@@ -65,7 +79,7 @@ static const uint row_pin_mask = (1 << row_pin[0]) | (1 << row_pin[1]) |
 #ifndef LARD61
 // Change GPIO mapping on Pico to avoid interfering
 // with LED and UART pins.
-static const uint col_pin[N_COLS] = {
+static const uint col_pin[N_COLS] L61_HOT_DATA(col_pin) = {
     23,  // col0
     // Pin 25 is the LED pin on Pico
     // => change to same pin as col0
@@ -79,10 +93,10 @@ static const uint col_pin[N_COLS] = {
     // => change to same pin as col6
     29,  // col7
     29,  // col8
-}
+};
 #else
 // GPIO pins for each column
-static const uint col_pin[N_COLS] = {
+static const uint col_pin[N_COLS] L61_HOT_DATA(col_pin) = {
     23,  // col0
     25,  // col1
     26,  // col2
@@ -107,6 +121,39 @@ static const uint col_pin[N_COLS] = {
 // Interrupt callback for a rising edge event on one of the row pins
 void l61_keymatrix_gpio_callback(uint gpio, uint32_t event_mask);
 
+static uint32_t now_ms() {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+static bool any_key_pressed() {
+  for (uint i = 0; i < N_COLS * N_ROWS; ++i) {
+    if (pressed[i])
+      return true;
+  }
+  return false;
+}
+
+// Print the statistics of the next key with something to report, if the
+// line fits in the CDC TX FIFO
+static void print_next_debounce_key() {
+  if (tud_cdc_write_available() < DEBOUNCE_LINE_SIZE)
+    return;
+
+  const struct l61_debounce_table* table = l61_debounce_get_table();
+  for (; debounce_print_key < N_COLS * N_ROWS; ++debounce_print_key) {
+    const struct l61_debounce_key* key = &table->key[debounce_print_key];
+    if (key->presses == 0 && key->bounces == 0 && key->short_presses == 0)
+      continue;
+    l61_printf("%2d: window %5u us, bounce max %5u us, presses %5u, "
+               "bounces %5u, short %5u\n",
+               debounce_print_key, key->window_us, key->bounce_max_us,
+               key->presses, key->bounces, key->short_presses);
+    debounce_print_key++;
+    return;
+  }
+  debounce_print_key = -1;
+}
+
 //-----------------------------------------------------------------------------
 // Public API
 //-----------------------------------------------------------------------------
@@ -131,12 +178,63 @@ void l61_keymatrix_setup() {
     gpio_set_irq_enabled(row_pin[row], GPIO_IRQ_EDGE_RISE, true);
   }
   gpio_set_irq_callback(&l61_keymatrix_gpio_callback);
+  // The scan may run from a timer interrupt (see lard61_scan.c), in which
+  // case the row interrupts must be able to preempt it to fill in
+  // `pressed_this_update` while the column is still active.
+  irq_set_priority(IO_IRQ_BANK0, PICO_HIGHEST_IRQ_PRIORITY);
   irq_set_enabled(IO_IRQ_BANK0, true);
 
   printf("Key matrix interrupts OK\n");
+
+  static struct l61_debounce_table learned;
+  if (l61_config_load(L61_CONFIG_DEBOUNCE, &learned, sizeof(learned))) {
+    l61_debounce_init(&learned);
+  } else {
+    l61_debounce_init(NULL);
+  }
 }
 
-uint l61_keymatrix_get_row(uint gpio) {
+void l61_keymatrix_task() {
+  if (debounce_print_key >= 0)
+    print_next_debounce_key();
+
+  // The benchmark's strokes would be saved as chatter, the windows from
+  // before it are restored at the end
+  if (l61_debounce_is_dirty() && !l61_selfbench_is_active() &&
+      now_ms() - debounce_saved_ms > DEBOUNCE_SAVE_INTERVAL_MS &&
+      !any_key_pressed()) {
+    l61_keymatrix_save_debounce();
+  }
+}
+
+void l61_keymatrix_save_debounce() {
+  // The debouncer may update the table from the scan alarm interrupt
+  static struct l61_debounce_table saved;
+  uint32_t status = save_and_disable_interrupts();
+  saved = *l61_debounce_get_table();
+  l61_debounce_clear_dirty();
+  restore_interrupts(status);
+
+  l61_config_store(L61_CONFIG_DEBOUNCE, &saved, sizeof(saved));
+  debounce_saved_ms = now_ms();
+}
+
+void l61_keymatrix_reset_debounce() {
+  l61_debounce_reset();
+  // Events captured so far cannot be replayed from the old checkpoint
+  l61_capture_clear();
+  l61_config_clear(L61_CONFIG_DEBOUNCE);
+  l61_debounce_clear_dirty();
+}
+
+void l61_keymatrix_print_debounce() {
+  l61_printf("debounce window %d-%d us, short press < %d us\n",
+             L61_DEBOUNCE_MIN_US, L61_DEBOUNCE_MAX_US,
+             L61_CHATTER_SHORT_PRESS_US);
+  debounce_print_key = 0;
+}
+
+uint L61_HOT_FUNC(l61_keymatrix_get_row)(uint gpio) {
   switch (gpio) {
     case 19:
       return 0;
@@ -153,7 +251,7 @@ uint l61_keymatrix_get_row(uint gpio) {
   }
 }
 
-uint l61_keymatrix_get_row_offset(uint row) {
+uint L61_HOT_FUNC(l61_keymatrix_get_row_offset)(uint row) {
   uint offset = 0;
   for (uint i = 0; i < row; ++i) {
     offset += n_keys_in_row[i];
@@ -161,7 +259,7 @@ uint l61_keymatrix_get_row_offset(uint row) {
   return offset;
 }
 
-void l61_keymatrix_update() {
+bool L61_HOT_FUNC(l61_keymatrix_update)() {
   // Turn each column on, let irq on rows update the pressed table
 
   for (uint i = 0; i < N_ROWS * N_COLS; ++i) {
@@ -192,49 +290,31 @@ void l61_keymatrix_update() {
 
     // Before moving on to the next column, wait for all row pins to be low.
     // Otherwise, we will miss rising edges on the next iteration.
-    // uint loop_count = 0;
+    uint32_t settle_start_us = time_us_32();
     while ((gpio_get_all() & row_pin_mask) != 0) {
-      // loop_count++;
+      if (time_us_32() - settle_start_us > L61_KEYMATRIX_SETTLE_TIMEOUT_US) {
+        l61_health_count(L61_FAULT_SETTLE_TIMEOUT);
+        break;
+      }
     }
-    // if (loop_count > 0)
-    //   l61_printf("row pins at 0 after %d iterations\n", loop_count);
   }
   for (uint row = 0; row < N_ROWS; ++row) {
     gpio_set_irq_enabled(row_pin[row], GPIO_IRQ_EDGE_RISE, false);
   }
 
-  // Debouncing: only register a change of state if the entire keyboard
-  // state has stayed the same for DEBOUNCE_THRESHOLD_MS.
-
-  // Start by checking if any key state has changed.
-
-  bool changed = false;
-  for (uint i = 0; i < N_COLS * N_ROWS; ++i) {
-    if (pressed_this_update[i] && !pressed_last[i]) {
-      changed = true;
-    } else if (!pressed_this_update[i] && pressed_last[i]) {
-      changed = true;
-    }
-    pressed_last[i] = pressed_this_update[i];
-  }
-
-  absolute_time_t t = get_absolute_time();
-
-  // If the key state has changed, reset the last changed time
+  // Debounce each key with its own window, see lard61_debounce.c
+  uint32_t now_us = time_us_32();
+  l61_selfbench_inject(pressed_this_update, now_us);
+  uint32_t debounce_start = l61_cycles_now();
+  bool changed = l61_debounce_update(pressed_this_update, pressed, now_us);
+  l61_cycles_record(L61_CYCLES_DEBOUNCE, debounce_start);
   if (changed) {
-    last_change_time = t;
-    // l61_printf("change, lct = %lld\n", last_change_time);
-  }
-
-  if (absolute_time_diff_us(last_change_time, t) >
-      DEBOUNCE_THRESHOLD_MS * 1000) {
-    last_change_time = t;
-    // l61_printf("register, lct = %lld, cur = %d\n", last_change_time, t);
-    // Record the current key state
-    for (uint i = 0; i < N_COLS * N_ROWS; ++i) {
-      pressed[i] = pressed_this_update[i];
-    }
+    pressed_count = 0;
+    for (uint i = 0; i < N_ROWS * N_COLS; ++i)
+      pressed_count += pressed[i];
   }
+  l61_stream_scan(pressed_this_update, pressed, now_us);
+  return changed;
 }
 
 void l61_keymatrix_report() {
@@ -250,11 +330,15 @@ void l61_keymatrix_report() {
   }
 }
 
-bool l61_keymatrix_is_key_pressed(uint index) {
+bool L61_HOT_FUNC(l61_keymatrix_is_key_pressed)(uint index) {
   return pressed[index];
 }
 
-bool l61_keymatrix_is_fn_key_pressed() {
+uint L61_HOT_FUNC(l61_keymatrix_get_pressed_count)() {
+  return pressed_count;
+}
+
+bool L61_HOT_FUNC(l61_keymatrix_is_fn_key_pressed)() {
   return l61_keymatrix_is_key_pressed(L61_FN_KEY);
 }
 
@@ -262,7 +346,8 @@ bool l61_keymatrix_is_fn_key_pressed() {
 // IRQ callbacks
 //-----------------------------------------------------------------------------
 
-void l61_keymatrix_gpio_callback(uint gpio, uint32_t event_mask) {
+void L61_HOT_FUNC(l61_keymatrix_gpio_callback)(uint gpio,
+                                               uint32_t event_mask) {
   // l61_printf("gpio callback for pin %d, mask %d, active_col=%d\n", gpio,
   //            event_mask, active_col);
 
@@ -12,6 +12,23 @@
 #define N_ROWS 5
 #define N_COLS 14
 #define TOTAL_KEYS 61
+// Number of keys on each row. Key indices run row by row, the index of a
+// key being the number of keys on the rows above plus its column.
+#define L61_KEYS_IN_ROW {14, 14, 13, 12, 8}
+// Longest wait for the row pins to go low after turning a column off. The
+// pull-downs take a few microseconds, a row still high after this is stuck.
+#define L61_KEYMATRIX_SETTLE_TIMEOUT_US 100
+
+// Identifiers for specific keys
+// Use as argument to l61_keymatrix_is_key_pressed to check for
+// specific keys
+enum L61_KEY_INDEX {
+  L61_KEY_GRAVE = 0,
+  L61_KEY_R = 18,
+  L61_KEY_LEFT_CONTROL = 53,
+  L61_KEY_LEFT_ALT = 55,
+  L61_KEY_FN = 63,
+};
 
 //-----------------------------------------------------------------------------
 // Public API
@@ -27,12 +44,23 @@ uint l61_keymatrix_get_row_offset(uint row);
 
 // Query the state of all keys on the keyboard
 // Return true if the state has changed (after debouncing)
-void l61_keymatrix_update();
+bool l61_keymatrix_update();
+// Save learned debounce windows from time to time, print statistics
+void l61_keymatrix_task();
+// Save the learned debounce windows and chatter counts to flash now
+void l61_keymatrix_save_debounce();
+// Forget the learned debounce windows, in RAM and in flash
+void l61_keymatrix_reset_debounce();
+// Print the debounce window and chatter counts of every key used so far
+void l61_keymatrix_print_debounce();
 // Print out what keys are pressed according to the last call
-// to l61_keymatrix_update
+// to l61_keymatrix_update. Too slow to call for every scan, see
+// lard61_stream.h for that.
 void l61_keymatrix_report();
 // Returns true if switch at index is pressed down
 bool l61_keymatrix_is_key_pressed(uint index);
+// Number of keys pressed after debouncing
+uint l61_keymatrix_get_pressed_count();
 // Returns true if the Fn/layer key is pressed
 bool l61_keymatrix_is_fn_key_pressed();
 
@@ -0,0 +1,172 @@
+/*
+** file: lard61_layout.hpp
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Compile-time keymap description, for C++17. Layers are written row by row
+** in the physical order of the keys, and the compiler places each key at
+** its index in struct l61_keymap:
+**
+**   constexpr l61_keymap keymap = l61::keymap(
+**       l61::layer(l61::row(HID_KEY_GRAVE, HID_KEY_1, ...),
+**                  ...
+**                  l61::row(HID_KEY_CONTROL_LEFT, ..., l61::fn, ...)),
+**       l61::layer(...));
+**
+** A row must list exactly as many keys as the board has on it, and the Fn
+** key must be written l61::fn, on every layer; anything else fails to
+** compile. l61::trans on an upper layer takes the key of the base layer.
+** Matrix positions without a key are set to HID_KEY_NONE. The result is a
+** constant: nothing is left to compute at runtime.
+*/
+
+#ifndef _LARD61_LAYOUT_HPP
+#define _LARD61_LAYOUT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+}
+
+namespace l61 {
+
+//-----------------------------------------------------------------------------
+// Board geometry
+//-----------------------------------------------------------------------------
+
+constexpr uint8_t keys_in_row[N_ROWS] = L61_KEYS_IN_ROW;
+
+// Matrix column of each key of a row, from left to right. The bottom row
+// has no switch on the columns under the space bar.
+constexpr uint8_t row_columns[N_ROWS][N_COLS] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11},
+    {0, 1, 2, 3, 8, 9, 10, 11},
+};
+
+constexpr uint row_offset(uint row) {
+  uint offset = 0;
+  for (uint r = 0; r < row; ++r)
+    offset += keys_in_row[r];
+  return offset;
+}
+
+// Every key has its own index, within its row's range, and the board has
+// TOTAL_KEYS of them
+constexpr bool geometry_valid() {
+  uint total = 0;
+  for (uint r = 0; r < N_ROWS; ++r) {
+    uint count = keys_in_row[r];
+    if (count == 0 || count > N_COLS)
+      return false;
+    for (uint k = 1; k < count; ++k) {
+      if (row_columns[r][k] <= row_columns[r][k - 1])
+        return false;
+    }
+    uint end = r + 1 < N_ROWS ? row_offset(r + 1) : N_ROWS * N_COLS;
+    if (row_offset(r) + row_columns[r][count - 1] >= end)
+      return false;
+    total += count;
+  }
+  return total == TOTAL_KEYS;
+}
+static_assert(geometry_valid(), "the board geometry has overlapping keys");
+
+//-----------------------------------------------------------------------------
+// Keymap description
+//-----------------------------------------------------------------------------
+
+// A keycode of lard61_keycodes.h, or one of the markers below
+using entry = uint32_t;
+// The Fn key, which selects L61_LAYER_FN and has no keycode
+constexpr entry fn = 0x10000;
+// Same key as on the base layer
+constexpr entry trans = 0x10001;
+
+template <size_t N>
+struct row_keys {
+  entry key[N];
+};
+
+struct layer_keys {
+  entry key[N_ROWS * N_COLS];
+};
+
+template <typename... Keys>
+constexpr row_keys<sizeof...(Keys)> row(Keys... keys) {
+  return {{static_cast<entry>(keys)...}};
+}
+
+// These are not constexpr: reaching one while building a keymap stops the
+// compilation, with its name in the error.
+void fn_key_misplaced();
+void fn_key_missing();
+void trans_on_base_layer();
+void keycode_too_large();
+
+template <size_t N>
+constexpr void place(layer_keys& layer, uint row, const row_keys<N>& keys) {
+  for (uint k = 0; k < N; ++k)
+    layer.key[row_offset(row) + row_columns[row][k]] = keys.key[k];
+}
+
+template <size_t N0, size_t N1, size_t N2, size_t N3, size_t N4>
+constexpr layer_keys layer(const row_keys<N0>& row0,
+                           const row_keys<N1>& row1,
+                           const row_keys<N2>& row2,
+                           const row_keys<N3>& row3,
+                           const row_keys<N4>& row4) {
+  static_assert(N_ROWS == 5, "a layer takes one row per matrix row");
+  static_assert(N0 == keys_in_row[0], "wrong number of keys on row 0");
+  static_assert(N1 == keys_in_row[1], "wrong number of keys on row 1");
+  static_assert(N2 == keys_in_row[2], "wrong number of keys on row 2");
+  static_assert(N3 == keys_in_row[3], "wrong number of keys on row 3");
+  static_assert(N4 == keys_in_row[4], "wrong number of keys on row 4");
+
+  layer_keys layer{};
+  place(layer, 0, row0);
+  place(layer, 1, row1);
+  place(layer, 2, row2);
+  place(layer, 3, row3);
+  place(layer, 4, row4);
+  return layer;
+}
+
+// Layers in the order of enum l61_keymap_layer
+template <typename... Layers>
+constexpr l61_keymap keymap(const Layers&... layers) {
+  static_assert(sizeof...(Layers) == L61_LAYER_COUNT,
+                "a keymap takes one layer per enum l61_keymap_layer");
+
+  const layer_keys all[] = {layers...};
+  l61_keymap keymap{};
+  for (uint l = 0; l < L61_LAYER_COUNT; ++l) {
+    for (uint i = 0; i < N_ROWS * N_COLS; ++i) {
+      entry key = all[l].key[i];
+      if (key == fn) {
+        if (i != L61_KEY_FN)
+          fn_key_misplaced();
+        key = HID_KEY_NONE;
+      } else if (i == L61_KEY_FN) {
+        fn_key_missing();
+      } else if (key == trans) {
+        if (l == L61_LAYER_BASE)
+          trans_on_base_layer();
+        key = keymap.keycode[L61_LAYER_BASE][i];
+      } else if (key > UINT16_MAX) {
+        keycode_too_large();
+      }
+      keymap.keycode[l][i] = static_cast<uint16_t>(key);
+    }
+  }
+  return keymap;
+}
+
+}  // namespace l61
+
+#endif /* _LARD61_LAYOUT_HPP */
@@ -0,0 +1,168 @@
+/*
+** file: lard61_leader.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Key presses and releases are followed by l61_leader_key, called by the
+** debouncer before the new state is registered, so a key is consumed
+** before any report can include it. The debouncer may run from the scan
+** alarm interrupt, so the main loop only touches the sequence and the text
+** being typed with interrupts disabled.
+**
+** Every character of a sequence's text is typed as a press report followed
+** by an empty one, so repeated characters are seen as separate presses.
+*/
+
+#include "lard61_leader.h"
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+
+// Generated from leader_sequences.txt, defines leader_nodes,
+// leader_actions and leader_strokes
+#include "lard61_leader_table.h"
+
+#define KEY_COUNT (N_ROWS * N_COLS)
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// Keys taken by the leader, until released
+static uint8_t consumed[(KEY_COUNT + 7) / 8];
+
+// Sequence being matched
+static struct {
+  bool active;
+  uint16_t node;
+  uint32_t last_key_us;
+} sequence = {0};
+
+// Text being typed, as the next stroke and the end of the range, and
+// whether the next report is the release of the current stroke
+static struct {
+  uint16_t next;
+  uint16_t end;
+  bool release;
+} typing = {0};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void consume(uint index) {
+  consumed[index / 8] |= 1 << (index % 8);
+}
+
+// Child of `node` reached with `usage`, or -1
+static int find_child(uint16_t node, uint8_t usage) {
+  const struct l61_leader_node* n = &leader_nodes[node];
+  for (uint i = 0; i < n->child_count; ++i) {
+    if (leader_nodes[n->first_child + i].usage == usage)
+      return n->first_child + i;
+  }
+  return -1;
+}
+
+static void finish(uint16_t node) {
+  sequence.active = false;
+  uint16_t action = leader_nodes[node].action;
+  if (action == L61_LEADER_NO_ACTION)
+    return;
+  typing.next = leader_actions[action].first;
+  typing.end = typing.next + leader_actions[action].count;
+  typing.release = false;
+}
+
+static void L61_HOT_FUNC(key_pressed)(uint index, uint32_t now_us) {
+  uint layer =
+      l61_keymatrix_is_fn_key_pressed() ? L61_LAYER_FN : L61_LAYER_BASE;
+  uint16_t keycode = l61_keymap_get()->keycode[layer][index];
+
+  if ((keycode & L61_KC_TYPE_MASK) == L61_KC_LEADER) {
+    consume(index);
+    sequence.active = true;
+    sequence.node = 0;
+    sequence.last_key_us = now_us;
+    return;
+  }
+  if (!sequence.active || (keycode & L61_KC_TYPE_MASK) != L61_KC_KEYBOARD)
+    return;
+
+  // Modifiers are neither part of sequences nor taken from the host
+  uint8_t usage = keycode & L61_KC_USAGE_MASK;
+  if (usage == HID_KEY_NONE ||
+      (usage >= HID_KEY_CONTROL_LEFT && usage <= HID_KEY_GUI_RIGHT))
+    return;
+
+  consume(index);
+  int child = find_child(sequence.node, usage);
+  if (child < 0) {
+    sequence.active = false;
+    return;
+  }
+  sequence.node = child;
+  sequence.last_key_us = now_us;
+  if (leader_nodes[child].child_count == 0)
+    finish(child);
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void L61_HOT_FUNC(l61_leader_key)(uint key, bool pressed, uint32_t now_us) {
+  if (pressed)
+    key_pressed(key, now_us);
+  else
+    consumed[key / 8] &= ~(1 << (key % 8));
+}
+
+void L61_HOT_FUNC(l61_leader_update)(uint32_t now_us) {
+  uint32_t status = save_and_disable_interrupts();
+  // A key registered since now_us was read is not late
+  if (sequence.active && (int32_t)(now_us - sequence.last_key_us) >=
+                             L61_LEADER_TIMEOUT_MS * 1000) {
+    // Ends the sequence if it is complete, cancels it otherwise
+    finish(sequence.node);
+  }
+  restore_interrupts(status);
+}
+
+bool L61_HOT_FUNC(l61_leader_is_consumed)(uint index) {
+  return consumed[index / 8] & (1 << (index % 8));
+}
+
+bool l61_leader_get_report(struct l61_report* report) {
+  uint32_t status = save_and_disable_interrupts();
+  uint16_t next = typing.next;
+  bool typed = next != typing.end;
+  bool release = typing.release;
+  restore_interrupts(status);
+  if (!typed)
+    return false;
+
+  memset(report, 0, sizeof(*report));
+  if (release)
+    return true;
+
+  uint16_t stroke = leader_strokes[next];
+  if (stroke & L61_LEADER_SHIFT)
+    report->keycode[report->key_count++] = HID_KEY_SHIFT_LEFT;
+  report->keycode[report->key_count++] = (uint8_t)stroke;
+  return true;
+}
+
+void l61_leader_report_sent() {
+  uint32_t status = save_and_disable_interrupts();
+  if (typing.next != typing.end) {
+    if (typing.release)
+      typing.next++;
+    typing.release = !typing.release;
+  }
+  restore_interrupts(status);
+}
@@ -0,0 +1,72 @@
+/*
+** file: lard61_leader.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Leader key sequences: after the L61_LEADER key, the next keys pressed
+** are matched against a list of sequences instead of being sent, and a
+** complete sequence types its text.
+**
+** The sequences are listed in leader_sequences.txt and compiled into a
+** trie at build time by tools/l61_leader_gen.py. The trie is a table of
+** nodes in flash where the children of each node are contiguous, so
+** following a sequence takes one step per key and no allocation. Each
+** node takes 6 bytes and each typed character 2, so thousands of sequences
+** fit easily.
+**
+** A sequence ends when its last key leads to a node without children, or
+** when no key is pressed for L61_LEADER_TIMEOUT_MS. A key which matches no
+** sequence cancels the leader, and is not sent either.
+*/
+
+#ifndef _LARD61_LEADER_H
+#define _LARD61_LEADER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_report.h"
+
+#define L61_LEADER_TIMEOUT_MS 1000
+
+// Action index of a node which does not end a sequence
+#define L61_LEADER_NO_ACTION 0xffff
+// Flag of a stroke typed with shift held
+#define L61_LEADER_SHIFT 0x100
+
+struct l61_leader_node {
+  // Index of the first child, the others follow it
+  uint16_t first_child;
+  // Index in the action table, or L61_LEADER_NO_ACTION
+  uint16_t action;
+  // HID keyboard usage leading from the parent to this node
+  uint8_t usage;
+  uint8_t child_count;
+};
+
+// Text typed by a sequence, as a range of the stroke table. A stroke is a
+// HID keyboard usage, with L61_LEADER_SHIFT to type it shifted.
+struct l61_leader_action {
+  uint16_t first;
+  uint16_t count;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Handle a registered key state change, called by the debouncer
+void l61_leader_key(uint key, bool pressed, uint32_t now_us);
+// Time out the current sequence. Called by l61_hid_task before building
+// reports.
+void l61_leader_update(uint32_t now_us);
+// Whether key `index` was used by a leader sequence, and must be left out
+// of the reports until released
+bool l61_leader_is_consumed(uint index);
+// While a sequence's text is being typed, fill the next keyboard report
+// to send and return true
+bool l61_leader_get_report(struct l61_report* report);
+// Move on to the next report, after the one from l61_leader_get_report
+// was sent
+void l61_leader_report_sent();
+
+#endif /* _LARD61_LEADER_H */
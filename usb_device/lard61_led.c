@@ -0,0 +1,160 @@
+/*
+** file: lard61_led.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** A pattern is a short list of steps, each holding a PWM level for some
+** time. The alarm interrupt moves to the next step and rearms itself; a
+** pattern with a single step is steady and needs no alarm. Patterns are
+** rebuilt from the USB callbacks, which TinyUSB runs from tud_task, with
+** the alarm interrupt held off while they change.
+*/
+
+#include "lard61_led.h"
+
+#include "class/hid/hid_device.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "lard61_cdc.h"
+#include "pico/time.h"
+
+#define LED_PIN PICO_DEFAULT_LED_PIN
+#define MAX_STEPS 2
+
+struct led_step {
+  uint16_t level;
+  // Time to hold the level, 0 for ever
+  uint16_t ms;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static enum l61_led_usb_state usb_state = L61_LED_UNMOUNTED;
+static uint8_t host_leds = 0;
+
+static int led_alarm = -1;
+static struct led_step pattern[MAX_STEPS];
+static uint step_count = 0;
+static uint step = 0;
+// Time the current step ends
+static uint64_t step_end_us = 0;
+
+static const char* const usb_state_names[] = {
+    [L61_LED_UNMOUNTED] = "unmounted",
+    [L61_LED_MOUNTED] = "mounted",
+    [L61_LED_SUSPENDED] = "suspended",
+};
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Show step `index` and arm the alarm for its end. A target reached before
+// the alarm is set is missed and leaves the alarm disarmed, which would
+// freeze the pattern: skip the steps which already ended instead.
+static void start_step(uint index) {
+  step = index;
+  pwm_set_gpio_level(LED_PIN, pattern[step].level);
+  if (step_count < 2)
+    return;
+  step_end_us += pattern[step].ms * 1000;
+  while (hardware_alarm_set_target(led_alarm,
+                                   from_us_since_boot(step_end_us))) {
+    step = (step + 1) % step_count;
+    pwm_set_gpio_level(LED_PIN, pattern[step].level);
+    step_end_us += pattern[step].ms * 1000;
+  }
+}
+
+// Rebuild the pattern from the USB and host LED states
+static void update_pattern() {
+  // The USB callbacks only run from the main loop, after setup
+  if (led_alarm < 0)
+    return;
+
+  uint32_t status = save_and_disable_interrupts();
+  hardware_alarm_cancel(led_alarm);
+
+  switch (usb_state) {
+    case L61_LED_UNMOUNTED:
+      pattern[0] = (struct led_step){L61_LED_BRIGHT, 1000};
+      pattern[1] = (struct led_step){0, 1000};
+      step_count = 2;
+      break;
+    case L61_LED_SUSPENDED:
+      pattern[0] = (struct led_step){L61_LED_DIM, 20};
+      pattern[1] = (struct led_step){0, 2480};
+      step_count = 2;
+      break;
+    case L61_LED_MOUNTED: {
+      uint16_t level = host_leds & KEYBOARD_LED_CAPSLOCK ? L61_LED_BRIGHT
+                                                         : L61_LED_DIM;
+      if (host_leds & KEYBOARD_LED_SCROLLLOCK) {
+        pattern[0] = (struct led_step){level, 500};
+        pattern[1] = (struct led_step){0, 500};
+        step_count = 2;
+      } else {
+        pattern[0] = (struct led_step){level, 0};
+        step_count = 1;
+      }
+      break;
+    }
+  }
+
+  step_end_us = time_us_64();
+  start_step(0);
+  restore_interrupts(status);
+}
+
+//-----------------------------------------------------------------------------
+// IRQ callbacks
+//-----------------------------------------------------------------------------
+
+static void led_alarm_callback(uint alarm_num) {
+  (void)alarm_num;
+  start_step((step + 1) % step_count);
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_led_setup() {
+  gpio_set_function(LED_PIN, GPIO_FUNC_PWM);
+  uint slice = pwm_gpio_to_slice_num(LED_PIN);
+  pwm_config config = pwm_get_default_config();
+  pwm_config_set_wrap(&config, L61_LED_PWM_WRAP);
+  pwm_init(slice, &config, true);
+
+  led_alarm = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback(led_alarm, &led_alarm_callback);
+  update_pattern();
+}
+
+void l61_led_set_usb_state(enum l61_led_usb_state state) {
+  usb_state = state;
+  update_pattern();
+}
+
+void l61_led_set_host_leds(uint8_t leds) {
+  if (leds == host_leds)
+    return;
+  host_leds = leds;
+  update_pattern();
+}
+
+uint8_t l61_led_get_host_leds() {
+  return host_leds;
+}
+
+void l61_led_print() {
+  l61_printf("usb: %s\n", usb_state_names[usb_state]);
+  l61_printf("caps lock: %s, num lock: %s, scroll lock: %s\n",
+             host_leds & KEYBOARD_LED_CAPSLOCK ? "on" : "off",
+             host_leds & KEYBOARD_LED_NUMLOCK ? "on" : "off",
+             host_leds & KEYBOARD_LED_SCROLLLOCK ? "on" : "off");
+}
@@ -0,0 +1,46 @@
+/*
+** file: lard61_led.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Keyboard LED state set by the host, and the on-board LED showing it along
+** with the USB state.
+**
+** The LED is dimmed by PWM and its blink patterns are stepped by a hardware
+** alarm, so nothing runs from the main loop. It shows:
+** - unmounted: slow blink,
+** - suspended: a short dim flash every few seconds,
+** - mounted: steady dim, or bright with Caps Lock on. Scroll Lock makes it
+**   blink at that level.
+** Num Lock is on for most people most of the time and is not shown.
+*/
+
+#ifndef _LARD61_LED_H
+#define _LARD61_LED_H
+
+#include "pico/types.h"
+
+// PWM counter wrap, about 30 kHz from the 125 MHz system clock
+#define L61_LED_PWM_WRAP 4095
+#define L61_LED_BRIGHT L61_LED_PWM_WRAP
+#define L61_LED_DIM (L61_LED_PWM_WRAP / 16)
+
+enum l61_led_usb_state {
+  L61_LED_UNMOUNTED,
+  L61_LED_MOUNTED,
+  L61_LED_SUSPENDED,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_led_setup();
+void l61_led_set_usb_state(enum l61_led_usb_state state);
+// Store the KEYBOARD_LED_* bits of the host's keyboard output report
+void l61_led_set_host_leds(uint8_t leds);
+uint8_t l61_led_get_host_leds();
+// Print the host LED and USB states via l61_printf
+void l61_led_print();
+
+#endif /* _LARD61_LED_H */
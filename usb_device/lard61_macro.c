@@ -0,0 +1,323 @@
+/*
+** file: lard61_macro.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Recording happens in l61_macro_key, from the scan, possibly in an alarm
+** interrupt. Allocating a block is popping the head of the free list, and
+** emptying a slot is splicing its whole chain back onto it, so both take
+** constant time there.
+**
+** Playback happens in l61_hid_task, from the main loop: one event per
+** report, each report sent as soon as the previous one has been polled.
+** The slot being played cannot be recorded meanwhile, and the main loop
+** only starts playing with interrupts disabled, so the scan never touches
+** the blocks being read.
+*/
+
+#include "lard61_macro.h"
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+
+_Static_assert(sizeof(struct l61_macro_store) <= L61_CONFIG_ITEM_MAX_SIZE,
+               "macros must fit in a config item");
+
+#define KEY_COUNT (N_ROWS * N_COLS)
+#define NO_BLOCK 0xffff
+#define NO_SLOT -1
+
+struct block {
+  // Next block of the slot, or of the free list
+  uint16_t next;
+  uint16_t count;
+  uint16_t event[L61_MACRO_BLOCK_EVENTS];
+};
+
+_Static_assert(L61_MACRO_BLOCK_COUNT < NO_BLOCK, "too many macro blocks");
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static struct block pool[L61_MACRO_BLOCK_COUNT];
+static uint16_t free_head = NO_BLOCK;
+static uint16_t free_count = 0;
+
+static struct {
+  uint16_t head;
+  uint16_t tail;
+  uint16_t length;
+} slots[L61_MACRO_SLOT_COUNT];
+
+// Slot being recorded, and whether it ran out of blocks
+static volatile int recording = NO_SLOT;
+static bool truncated = false;
+// Usage recorded for each key held down since recording started, so its
+// release is recorded with the same usage even if the layer changed
+static uint8_t recorded_usage[KEY_COUNT];
+
+// Slot asked for by a play key, picked up by the main loop
+static volatile int play_request = NO_SLOT;
+static volatile int playing = NO_SLOT;
+
+// Playback position, and the keys it holds down
+static struct {
+  uint16_t block;
+  uint16_t index;
+  uint16_t remaining;
+  uint8_t keycode[6];
+  uint8_t key_count;
+} play;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void reset_pool() {
+  for (uint i = 0; i < L61_MACRO_BLOCK_COUNT; ++i)
+    pool[i].next = i + 1 < L61_MACRO_BLOCK_COUNT ? i + 1 : NO_BLOCK;
+  free_head = 0;
+  free_count = L61_MACRO_BLOCK_COUNT;
+  for (uint i = 0; i < L61_MACRO_SLOT_COUNT; ++i) {
+    slots[i].head = NO_BLOCK;
+    slots[i].tail = NO_BLOCK;
+    slots[i].length = 0;
+  }
+}
+
+static void L61_HOT_FUNC(empty_slot)(uint slot) {
+  if (slots[slot].head == NO_BLOCK)
+    return;
+  pool[slots[slot].tail].next = free_head;
+  free_head = slots[slot].head;
+  free_count += (slots[slot].length + L61_MACRO_BLOCK_EVENTS - 1) /
+                L61_MACRO_BLOCK_EVENTS;
+  slots[slot].head = NO_BLOCK;
+  slots[slot].tail = NO_BLOCK;
+  slots[slot].length = 0;
+}
+
+// Return false if the pool is full
+static bool L61_HOT_FUNC(append)(uint slot, uint16_t event) {
+  uint16_t tail = slots[slot].tail;
+  if (tail == NO_BLOCK || pool[tail].count == L61_MACRO_BLOCK_EVENTS) {
+    if (free_head == NO_BLOCK)
+      return false;
+    uint16_t block = free_head;
+    free_head = pool[block].next;
+    free_count--;
+    pool[block].next = NO_BLOCK;
+    pool[block].count = 0;
+    if (tail == NO_BLOCK)
+      slots[slot].head = block;
+    else
+      pool[tail].next = block;
+    slots[slot].tail = block;
+    tail = block;
+  }
+  pool[tail].event[pool[tail].count++] = event;
+  slots[slot].length++;
+  return true;
+}
+
+// Once the pool is full, the slot stays in recording until stopped, so
+// the stop key does not start a new recording over it
+static void L61_HOT_FUNC(record)(uint16_t event) {
+  if (!truncated && !append(recording, event))
+    truncated = true;
+}
+
+static void L61_HOT_FUNC(macro_key)(uint16_t usage) {
+  uint action = (usage >> 8) & 0xf;
+  uint slot = usage & 0xff;
+  if (slot >= L61_MACRO_SLOT_COUNT)
+    return;
+
+  if (action == L61_MACRO_ACTION_RECORD) {
+    bool stop = recording == (int)slot;
+    recording = NO_SLOT;
+    if (stop || playing == (int)slot)
+      return;
+    empty_slot(slot);
+    memset(recorded_usage, 0, sizeof(recorded_usage));
+    truncated = false;
+    recording = slot;
+  } else if (action == L61_MACRO_ACTION_PLAY) {
+    // Playing the slot being recorded ends the recording instead
+    if (recording == (int)slot)
+      recording = NO_SLOT;
+    else
+      play_request = slot;
+  }
+}
+
+// Press or release the key of `event` in a keyboard report
+static void apply(uint16_t event, uint8_t* keycode, uint8_t* key_count) {
+  uint8_t usage = event & 0xff;
+  uint i = 0;
+  while (i < *key_count && keycode[i] != usage)
+    ++i;
+  if (event & L61_MACRO_RELEASE) {
+    if (i == *key_count)
+      return;
+    memmove(&keycode[i], &keycode[i + 1], *key_count - i - 1);
+    keycode[--*key_count] = 0;
+  } else if (i == *key_count && *key_count < sizeof(play.keycode)) {
+    keycode[(*key_count)++] = usage;
+  }
+}
+
+// Start playing the requested slot, if any
+static bool start_playing() {
+  bool started = false;
+  uint32_t status = save_and_disable_interrupts();
+  int slot = play_request;
+  play_request = NO_SLOT;
+  if (slot != NO_SLOT && slot != recording) {
+    playing = slot;
+    play.block = slots[slot].head;
+    play.index = 0;
+    play.remaining = slots[slot].length;
+    play.key_count = 0;
+    memset(play.keycode, 0, sizeof(play.keycode));
+    started = true;
+  }
+  restore_interrupts(status);
+  return started;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_macro_setup() {
+  static struct l61_macro_store store;
+
+  reset_pool();
+  if (!l61_config_load(L61_CONFIG_MACROS, &store, sizeof(store)) ||
+      store.magic != L61_MACRO_MAGIC || store.version != L61_MACRO_VERSION ||
+      store.slot_count != L61_MACRO_SLOT_COUNT)
+    return;
+
+  uint event = 0;
+  for (uint slot = 0; slot < L61_MACRO_SLOT_COUNT; ++slot) {
+    for (uint i = 0; i < store.length[slot] && event < L61_MACRO_MAX_EVENTS;
+         ++i) {
+      if (!append(slot, store.event[event++]))
+        return;
+    }
+  }
+}
+
+void L61_HOT_FUNC(l61_macro_key)(uint key, bool pressed) {
+  if (pressed) {
+    uint layer =
+        l61_keymatrix_is_fn_key_pressed() ? L61_LAYER_FN : L61_LAYER_BASE;
+    uint16_t keycode = l61_keymap_get()->keycode[layer][key];
+    uint16_t usage = keycode & L61_KC_USAGE_MASK;
+    switch (keycode & L61_KC_TYPE_MASK) {
+      case L61_KC_MACRO:
+        macro_key(usage);
+        break;
+      case L61_KC_KEYBOARD:
+        if (recording != NO_SLOT && usage != HID_KEY_NONE) {
+          recorded_usage[key] = (uint8_t)usage;
+          record(usage);
+        }
+        break;
+    }
+  } else if (recording != NO_SLOT && recorded_usage[key] != HID_KEY_NONE) {
+    record(recorded_usage[key] | L61_MACRO_RELEASE);
+    recorded_usage[key] = HID_KEY_NONE;
+  }
+}
+
+bool l61_macro_get_report(struct l61_report* report) {
+  if (playing == NO_SLOT && !start_playing())
+    return false;
+
+  // Once all events are played, one last report releases the keys left
+  // held down
+  memset(report, 0, sizeof(*report));
+  if (play.remaining == 0)
+    return true;
+
+  memcpy(report->keycode, play.keycode, sizeof(report->keycode));
+  report->key_count = play.key_count;
+  apply(pool[play.block].event[play.index], report->keycode,
+        &report->key_count);
+  return true;
+}
+
+void l61_macro_report_sent() {
+  if (playing == NO_SLOT)
+    return;
+  if (play.remaining == 0) {
+    playing = NO_SLOT;
+    return;
+  }
+
+  apply(pool[play.block].event[play.index], play.keycode, &play.key_count);
+  play.remaining--;
+  if (++play.index == pool[play.block].count) {
+    play.block = pool[play.block].next;
+    play.index = 0;
+  }
+}
+
+void l61_macro_save() {
+  static struct l61_macro_store store;
+
+  memset(&store, 0, sizeof(store));
+  store.magic = L61_MACRO_MAGIC;
+  store.version = L61_MACRO_VERSION;
+  store.slot_count = L61_MACRO_SLOT_COUNT;
+
+  // The slot being recorded is saved as recorded so far
+  uint32_t status = save_and_disable_interrupts();
+  uint event = 0;
+  for (uint slot = 0; slot < L61_MACRO_SLOT_COUNT; ++slot) {
+    store.length[slot] = slots[slot].length;
+    for (uint16_t b = slots[slot].head; b != NO_BLOCK; b = pool[b].next) {
+      memcpy(&store.event[event], pool[b].event,
+             pool[b].count * sizeof(uint16_t));
+      event += pool[b].count;
+    }
+  }
+  restore_interrupts(status);
+
+  l61_config_store(L61_CONFIG_MACROS, &store, sizeof(store));
+}
+
+void l61_macro_clear() {
+  uint32_t status = save_and_disable_interrupts();
+  recording = NO_SLOT;
+  play_request = NO_SLOT;
+  playing = NO_SLOT;
+  truncated = false;
+  reset_pool();
+  restore_interrupts(status);
+
+  l61_config_clear(L61_CONFIG_MACROS);
+}
+
+void l61_macro_print() {
+  for (uint slot = 0; slot < L61_MACRO_SLOT_COUNT; ++slot) {
+    const char* state = "";
+    if (recording == (int)slot)
+      state = " (recording)";
+    else if (playing == (int)slot)
+      state = " (playing)";
+    l61_printf("slot %u: %u events%s\n", slot, slots[slot].length, state);
+  }
+  l61_printf("free: %u/%d blocks of %d events%s\n", free_count,
+             L61_MACRO_BLOCK_COUNT, L61_MACRO_BLOCK_EVENTS,
+             truncated ? ", last recording truncated" : "");
+}
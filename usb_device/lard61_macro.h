@@ -0,0 +1,80 @@
+/*
+** file: lard61_macro.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Dynamic macros: L61_MACRO_RECORD(slot) starts recording the keys typed
+** into a slot, and pressing it again stops. L61_MACRO_PLAY(slot) then types
+** them back, as fast as the host polls the keyboard.
+**
+** Recorded events are kept in a pool of fixed-size blocks in RAM, chained
+** per slot, so slots of any length share the same memory and recording
+** never calls malloc. Each event takes 2 bytes: the HID keyboard usage of
+** the key, and whether it was released. Only keyboard keys are recorded.
+**
+** `macro save` stores all the slots in the config area, and they are
+** loaded again at boot.
+*/
+
+#ifndef _LARD61_MACRO_H
+#define _LARD61_MACRO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_report.h"
+
+#define L61_MACRO_SLOT_COUNT 4
+// Pool of L61_MACRO_BLOCK_COUNT blocks of L61_MACRO_BLOCK_EVENTS events,
+// 64 bytes each
+#define L61_MACRO_BLOCK_COUNT 44
+#define L61_MACRO_BLOCK_EVENTS 30
+#define L61_MACRO_MAX_EVENTS (L61_MACRO_BLOCK_COUNT * L61_MACRO_BLOCK_EVENTS)
+
+// Event flag of a key release
+#define L61_MACRO_RELEASE 0x100
+
+// Actions of L61_KC_MACRO keycodes, in bits 8-11 of the usage. The slot is
+// in bits 0-7.
+enum l61_macro_action {
+  L61_MACRO_ACTION_RECORD,
+  L61_MACRO_ACTION_PLAY,
+  L61_MACRO_ACTION_COUNT,
+};
+
+#define L61_MACRO_MAGIC 0x6c36316d
+#define L61_MACRO_VERSION 1
+
+// Slots as saved to flash: the events of every slot, one after the other
+struct l61_macro_store {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t slot_count;
+  uint16_t length[L61_MACRO_SLOT_COUNT];
+  uint16_t event[L61_MACRO_MAX_EVENTS];
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the saved slots
+void l61_macro_setup();
+// Handle a registered key state change, called by the debouncer: macro
+// keys start and stop recording or playing, other keys are recorded
+void l61_macro_key(uint key, bool pressed);
+
+// While a slot is being played, fill the next keyboard report to send and
+// return true
+bool l61_macro_get_report(struct l61_report* report);
+// Move on to the next event, after the report from l61_macro_get_report
+// was sent
+void l61_macro_report_sent();
+
+// Store all the slots in flash
+void l61_macro_save();
+// Empty all the slots, in RAM and in flash
+void l61_macro_clear();
+// Print the length of each slot and the free space via l61_printf
+void l61_macro_print();
+
+#endif /* _LARD61_MACRO_H */
@@ -0,0 +1,146 @@
+/*
+** file: lard61_mousekeys.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** The pointer and wheel speeds follow an acceleration curve over the number
+** of USB frames a movement key has been held. Speeds and positions use 8
+** fractional bits, so that slow speeds still move the pointer smoothly by
+** accumulating sub-pixel steps from one frame to the next.
+**
+** Reports are sent on the mouse interface, at most once per frame and only
+** while there is something to report: movement or a change of buttons.
+*/
+
+#include "lard61_mousekeys.h"
+
+#include "class/hid/hid_device.h"
+#include "lard61_hid.h"
+#include "lard61_report.h"
+#include "lard61_scan.h"
+
+#define ACTION_BIT(action) (1u << (action))
+
+// Catching up on more frames than this after a stall would make the pointer
+// jump
+#define MAX_FRAMES_PER_REPORT 4
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static enum l61_mousekeys_curve accel_curve = L61_MOUSEKEYS_CURVE_QUADRATIC;
+
+// SOF count when the mouse keys were last evaluated
+static uint32_t last_frame = 0;
+
+// Number of frames the pointer and wheel have been moving for
+static uint32_t pointer_frames = 0;
+static uint32_t wheel_frames = 0;
+// Sub-pixel and sub-step remainders, in 1/256th
+static uint32_t pointer_acc = 0;
+static uint32_t wheel_acc = 0;
+
+// Buttons in the last report sent to the host
+static uint8_t sent_buttons = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Speed after moving for `frames` frames, following the acceleration curve
+static uint32_t speed(uint32_t frames, uint32_t initial, uint32_t max) {
+  if (frames >= L61_MOUSEKEYS_ACCEL_FRAMES)
+    return max;
+
+  // Progress along the curve, in 1/256th
+  uint32_t t = frames * 256 / L61_MOUSEKEYS_ACCEL_FRAMES;
+  if (accel_curve == L61_MOUSEKEYS_CURVE_QUADRATIC)
+    t = t * t / 256;
+
+  return initial + (max - initial) * t / 256;
+}
+
+// Advance an accumulator by `frames` frames at the given speed, and return
+// the number of whole units (pixels or wheel steps) to report
+static int8_t step(uint32_t* acc, uint32_t speed, uint32_t frames) {
+  *acc += speed * frames;
+  uint32_t units = *acc >> 8;
+  *acc &= 0xff;
+  return units > 127 ? 127 : (int8_t)units;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_mousekeys_task() {
+  // Wait for the host to poll the previous report
+  if (!tud_hid_n_ready(L61_HID_MOUSE))
+    return;
+
+  uint32_t frame = l61_scan_get_sof_count();
+  uint32_t frames = frame - last_frame;
+  if (frames == 0)
+    return;
+  last_frame = frame;
+  if (frames > MAX_FRAMES_PER_REPORT)
+    frames = MAX_FRAMES_PER_REPORT;
+
+  struct l61_report report;
+  l61_report_build(&report, 0);
+  uint16_t actions = report.mouse;
+
+  int dx = !!(actions & ACTION_BIT(L61_MOUSE_RIGHT)) -
+           !!(actions & ACTION_BIT(L61_MOUSE_LEFT));
+  int dy = !!(actions & ACTION_BIT(L61_MOUSE_DOWN)) -
+           !!(actions & ACTION_BIT(L61_MOUSE_UP));
+  int dw = !!(actions & ACTION_BIT(L61_MOUSE_WHEEL_UP)) -
+           !!(actions & ACTION_BIT(L61_MOUSE_WHEEL_DOWN));
+
+  uint8_t buttons = 0;
+  if (actions & ACTION_BIT(L61_MOUSE_BUTTON_LEFT))
+    buttons |= MOUSE_BUTTON_LEFT;
+  if (actions & ACTION_BIT(L61_MOUSE_BUTTON_RIGHT))
+    buttons |= MOUSE_BUTTON_RIGHT;
+  if (actions & ACTION_BIT(L61_MOUSE_BUTTON_MIDDLE))
+    buttons |= MOUSE_BUTTON_MIDDLE;
+
+  int8_t pixels = 0;
+  if (dx != 0 || dy != 0) {
+    pointer_frames += frames;
+    uint32_t v = speed(pointer_frames, L61_MOUSEKEYS_POINTER_INITIAL_SPEED,
+                       L61_MOUSEKEYS_POINTER_MAX_SPEED);
+    // Keep the same speed along diagonals: 181/256 ~= 1/sqrt(2)
+    if (dx != 0 && dy != 0)
+      v = v * 181 / 256;
+    pixels = step(&pointer_acc, v, frames);
+  } else {
+    pointer_frames = 0;
+    pointer_acc = 0;
+  }
+
+  int8_t steps = 0;
+  if (dw != 0) {
+    wheel_frames += frames;
+    steps = step(&wheel_acc,
+                 speed(wheel_frames, L61_MOUSEKEYS_WHEEL_INITIAL_SPEED,
+                       L61_MOUSEKEYS_WHEEL_MAX_SPEED),
+                 frames);
+  } else {
+    wheel_frames = 0;
+    wheel_acc = 0;
+  }
+
+  if (pixels == 0 && steps == 0 && buttons == sent_buttons)
+    return;
+
+  if (tud_hid_n_mouse_report(L61_HID_MOUSE, 0, buttons, (int8_t)(dx * pixels),
+                             (int8_t)(dy * pixels), (int8_t)(dw * steps), 0)) {
+    sent_buttons = buttons;
+  }
+}
+
+void l61_mousekeys_set_curve(enum l61_mousekeys_curve curve) {
+  accel_curve = curve;
+}
@@ -0,0 +1,56 @@
+/*
+** file: lard61_mousekeys.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Mouse keys: pointer movement, buttons and wheel from the keyboard, sent on
+** the dedicated mouse HID interface.
+*/
+
+#ifndef _LARD61_MOUSEKEYS_H
+#define _LARD61_MOUSEKEYS_H
+
+#include "pico/types.h"
+
+// Speeds are in 1/256th of a pixel (or wheel step) per USB frame.
+// Pointer speed when a movement key is first pressed
+#define L61_MOUSEKEYS_POINTER_INITIAL_SPEED 256
+// Pointer speed once fully accelerated
+#define L61_MOUSEKEYS_POINTER_MAX_SPEED (12 * 256)
+// Wheel speeds: start at one step every 100 frames, up to one every 20
+#define L61_MOUSEKEYS_WHEEL_INITIAL_SPEED (256 / 100)
+#define L61_MOUSEKEYS_WHEEL_MAX_SPEED (256 / 20)
+// Number of frames to go from the initial to the max speed
+#define L61_MOUSEKEYS_ACCEL_FRAMES 800
+
+// Actions which can be put in a keymap with L61_MOUSE(action)
+enum l61_mouse_action {
+  L61_MOUSE_UP,
+  L61_MOUSE_DOWN,
+  L61_MOUSE_LEFT,
+  L61_MOUSE_RIGHT,
+  L61_MOUSE_WHEEL_UP,
+  L61_MOUSE_WHEEL_DOWN,
+  L61_MOUSE_BUTTON_LEFT,
+  L61_MOUSE_BUTTON_RIGHT,
+  L61_MOUSE_BUTTON_MIDDLE,
+  L61_MOUSE_ACTION_COUNT,
+};
+
+// Shape of the speed increase while a movement key is held
+enum l61_mousekeys_curve {
+  // Constant acceleration
+  L61_MOUSEKEYS_CURVE_LINEAR,
+  // Slow start for precise positioning, then faster
+  L61_MOUSEKEYS_CURVE_QUADRATIC,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Send at most one mouse report per USB frame while mouse keys are held
+void l61_mousekeys_task();
+void l61_mousekeys_set_curve(enum l61_mousekeys_curve curve);
+
+#endif /* _LARD61_MOUSEKEYS_H */
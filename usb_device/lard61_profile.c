@@ -0,0 +1,365 @@
+/*
+** file: lard61_profile.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** A profile is applied with interrupts disabled, from the main loop: a scan
+** from the alarm interrupt either ran before with the old settings or runs
+** after with the new ones, and a scan from the main loop is not running.
+**
+** Profile keys may be registered from the scan alarm interrupt, where the
+** flash cannot be written, so they only leave a request for
+** l61_profile_task.
+**
+** The statistics are counted by the scan and debouncer, in the scan
+** context, and at each SOF, in the USB interrupt. Each field is written from
+** one of them only, and the main loop reads them with interrupts disabled.
+*/
+
+#include "lard61_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_debounce.h"
+#include "lard61_hid.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+#include "lard61_scan.h"
+#include "lard61_selfbench.h"
+#include "pico/time.h"
+
+#define SCAN_MODE_COUNT (L61_SCAN_TIMER + 1)
+#define NO_REQUEST -1
+
+// Saved to flash as is
+struct profile_config {
+  uint8_t active;
+  uint8_t reserved[3];
+  struct l61_profile profile[L61_PROFILE_COUNT];
+};
+
+struct profile_stats {
+  // Time spent active, up to the last switch
+  uint64_t active_us;
+  uint32_t scans;
+  uint64_t scan_cycles;
+  // Registered key state changes, and their delay since the first edge
+  uint32_t changes;
+  uint64_t debounce_us;
+  uint32_t debounce_max_us;
+  // Changes followed by a SOF, and their delay until it
+  uint32_t sofs;
+  uint64_t sof_us;
+  uint32_t sof_max_us;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static const char* const scan_mode_names[SCAN_MODE_COUNT] = {
+    [L61_SCAN_FREE_RUNNING] = "free",
+    [L61_SCAN_SOF_ALIGNED] = "sof",
+    [L61_SCAN_TIMER] = "timer",
+};
+
+static const char* const debounce_mode_names[L61_DEBOUNCE_MODE_COUNT] = {
+    [L61_DEBOUNCE_DEFERRED] = "deferred",
+    [L61_DEBOUNCE_EAGER] = "eager",
+};
+
+static const struct profile_config default_config = {
+    .active = 0,
+    .profile = {
+        {
+            .name = "default",
+            .scan_mode = L61_SCAN_FREE_RUNNING,
+            .debounce_mode = L61_DEBOUNCE_DEFERRED,
+            .scan_rate_hz = L61_SCAN_RATE_DEFAULT_HZ,
+            .idle_rate_hz = 0,
+            .key_throttle = true,
+        },
+        {
+            .name = "office",
+            .scan_mode = L61_SCAN_TIMER,
+            .debounce_mode = L61_DEBOUNCE_DEFERRED,
+            .scan_rate_hz = 500,
+            .idle_rate_hz = 100,
+            .key_throttle = true,
+        },
+        {
+            .name = "gaming",
+            .scan_mode = L61_SCAN_SOF_ALIGNED,
+            .debounce_mode = L61_DEBOUNCE_EAGER,
+            .scan_rate_hz = L61_SCAN_RATE_DEFAULT_HZ,
+            .idle_rate_hz = 0,
+            .key_throttle = false,
+        },
+    },
+};
+
+static struct profile_config config;
+
+// Index of the profile applied, as read by the statistics hooks
+static volatile uint8_t active = 0;
+// Debounce window of the profile applied, read when a selfbench run ends
+static volatile uint16_t debounce_window_us = 0;
+// Profile requested by a key, L61_PROFILE_USAGE_NEXT or NO_REQUEST
+static volatile int request = NO_REQUEST;
+
+static struct profile_stats stats[L61_PROFILE_COUNT];
+// Time the active profile was applied or its statistics cleared
+static uint64_t active_since_us = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static bool rate_valid(uint hz) {
+  return hz >= L61_SCAN_RATE_MIN_HZ && hz <= L61_SCAN_RATE_MAX_HZ;
+}
+
+static bool window_valid(uint us) {
+  return us == 0 || (us >= L61_DEBOUNCE_MIN_US && us <= L61_DEBOUNCE_MAX_US);
+}
+
+static bool profile_valid(const struct l61_profile* p) {
+  return memchr(p->name, '\0', sizeof(p->name)) != NULL &&
+         p->name[0] != '\0' && p->scan_mode < SCAN_MODE_COUNT &&
+         p->debounce_mode < L61_DEBOUNCE_MODE_COUNT &&
+         rate_valid(p->scan_rate_hz) &&
+         (p->idle_rate_hz == 0 || rate_valid(p->idle_rate_hz)) &&
+         p->key_throttle <= 1 && window_valid(p->debounce_window_us);
+}
+
+static bool config_valid(const struct profile_config* c) {
+  if (c->active >= L61_PROFILE_COUNT)
+    return false;
+  for (uint i = 0; i < L61_PROFILE_COUNT; ++i) {
+    if (!profile_valid(&c->profile[i]))
+      return false;
+  }
+  return true;
+}
+
+// Index of `name` in `names`, or -1
+static int find_name(const char* const* names, uint count, const char* name) {
+  for (uint i = 0; i < count; ++i) {
+    if (strcmp(names[i], name) == 0)
+      return (int)i;
+  }
+  return -1;
+}
+
+static void apply(uint index) {
+  const struct l61_profile* p = &config.profile[index];
+  uint64_t now = time_us_64();
+
+  uint32_t status = save_and_disable_interrupts();
+  l61_scan_set_rate(p->scan_rate_hz);
+  l61_scan_set_idle_rate(p->idle_rate_hz);
+  l61_scan_set_mode(p->scan_mode);
+  l61_debounce_set_mode(p->debounce_mode);
+  // A selfbench run debounces with the shortest window, and sets this one
+  // when it ends
+  debounce_window_us = p->debounce_window_us;
+  if (!l61_selfbench_is_active())
+    l61_debounce_set_window_override(p->debounce_window_us);
+  l61_hid_set_key_throttle(p->key_throttle);
+  stats[active].active_us += now - active_since_us;
+  active_since_us = now;
+  active = (uint8_t)index;
+  restore_interrupts(status);
+}
+
+static void save() {
+  l61_config_store(L61_CONFIG_PROFILE, &config, sizeof(config));
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_profile_setup() {
+  struct profile_config saved;
+  if (l61_config_load(L61_CONFIG_PROFILE, &saved, sizeof(saved)) &&
+      config_valid(&saved))
+    config = saved;
+  else
+    config = default_config;
+  l61_profile_reset_stats();
+  apply(config.active);
+}
+
+void l61_profile_task() {
+  int index = request;
+  if (index == NO_REQUEST)
+    return;
+  request = NO_REQUEST;
+  if (index == L61_PROFILE_USAGE_NEXT)
+    index = (config.active + 1) % L61_PROFILE_COUNT;
+  l61_profile_select((uint)index);
+}
+
+bool l61_profile_select(uint index) {
+  if (index >= L61_PROFILE_COUNT)
+    return false;
+  apply(index);
+  if (config.active != index) {
+    config.active = (uint8_t)index;
+    save();
+  }
+  return true;
+}
+
+int l61_profile_find(const char* name) {
+  for (uint i = 0; i < L61_PROFILE_COUNT; ++i) {
+    if (strcmp(config.profile[i].name, name) == 0)
+      return (int)i;
+  }
+  return -1;
+}
+
+bool l61_profile_set(const char* field, const char* value) {
+  struct l61_profile p = config.profile[config.active];
+  uint number = 0;
+  int found = -1;
+  if (strcmp(field, "name") == 0) {
+    if (strlen(value) >= sizeof(p.name) || l61_profile_find(value) >= 0)
+      return false;
+    strcpy(p.name, value);
+  } else if (strcmp(field, "scan") == 0) {
+    found = find_name(scan_mode_names, SCAN_MODE_COUNT, value);
+    if (found < 0)
+      return false;
+    p.scan_mode = (uint8_t)found;
+  } else if (strcmp(field, "rate") == 0) {
+    if (sscanf(value, "%u", &number) != 1)
+      return false;
+    p.scan_rate_hz = (uint16_t)number;
+  } else if (strcmp(field, "idle") == 0) {
+    if (sscanf(value, "%u", &number) != 1)
+      return false;
+    p.idle_rate_hz = (uint16_t)number;
+  } else if (strcmp(field, "debounce") == 0) {
+    found = find_name(debounce_mode_names, L61_DEBOUNCE_MODE_COUNT, value);
+    if (found < 0)
+      return false;
+    p.debounce_mode = (uint8_t)found;
+  } else if (strcmp(field, "window") == 0) {
+    if (sscanf(value, "%u", &number) != 1)
+      return false;
+    p.debounce_window_us = (uint16_t)number;
+  } else if (strcmp(field, "throttle") == 0) {
+    if (strcmp(value, "on") != 0 && strcmp(value, "off") != 0)
+      return false;
+    p.key_throttle = strcmp(value, "on") == 0;
+  } else {
+    return false;
+  }
+  // Also reject rates and windows which were truncated to 16 bits
+  if (number > UINT16_MAX || !profile_valid(&p))
+    return false;
+
+  config.profile[config.active] = p;
+  apply(config.active);
+  save();
+  return true;
+}
+
+void l61_profile_restore_defaults() {
+  config = default_config;
+  l61_config_clear(L61_CONFIG_PROFILE);
+  apply(config.active);
+}
+
+uint16_t L61_HOT_FUNC(l61_profile_get_debounce_window)() {
+  return debounce_window_us;
+}
+
+void L61_HOT_FUNC(l61_profile_key)(uint key, bool pressed, uint32_t delay_us) {
+  struct profile_stats* s = &stats[active];
+  s->changes++;
+  s->debounce_us += delay_us;
+  if (delay_us > s->debounce_max_us)
+    s->debounce_max_us = delay_us;
+
+  if (!pressed)
+    return;
+  uint layer =
+      l61_keymatrix_is_fn_key_pressed() ? L61_LAYER_FN : L61_LAYER_BASE;
+  uint16_t keycode = l61_keymap_get()->keycode[layer][key];
+  if ((keycode & L61_KC_TYPE_MASK) == L61_KC_PROFILE)
+    request = keycode & L61_KC_USAGE_MASK;
+}
+
+void L61_HOT_FUNC(l61_profile_scan)(uint32_t cycles) {
+  struct profile_stats* s = &stats[active];
+  s->scans++;
+  s->scan_cycles += cycles;
+}
+
+void l61_profile_sof_delay(uint32_t delay_us) {
+  struct profile_stats* s = &stats[active];
+  s->sofs++;
+  s->sof_us += delay_us;
+  if (delay_us > s->sof_max_us)
+    s->sof_max_us = delay_us;
+}
+
+void l61_profile_print() {
+  for (uint i = 0; i < L61_PROFILE_COUNT; ++i) {
+    const struct l61_profile* p = &config.profile[i];
+    l61_printf("%c %u %-9s scan %s %u Hz, idle %u Hz, debounce %s, ",
+               i == config.active ? '*' : ' ', i, p->name,
+               scan_mode_names[p->scan_mode], p->scan_rate_hz,
+               p->idle_rate_hz, debounce_mode_names[p->debounce_mode]);
+    if (p->debounce_window_us)
+      l61_printf("window %u us, ", p->debounce_window_us);
+    else
+      l61_printf("window learned, ");
+    l61_printf("throttle %s\n", p->key_throttle ? "on" : "off");
+  }
+}
+
+void l61_profile_print_stats() {
+  static struct profile_stats copy[L61_PROFILE_COUNT];
+  uint32_t status = save_and_disable_interrupts();
+  memcpy(copy, stats, sizeof(copy));
+  copy[active].active_us += time_us_64() - active_since_us;
+  restore_interrupts(status);
+
+  uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+  for (uint i = 0; i < L61_PROFILE_COUNT; ++i) {
+    const struct profile_stats* s = &copy[i];
+    uint32_t ms = (uint32_t)(s->active_us / 1000);
+    if (ms == 0)
+      continue;
+    // Scan share of the processor, in tenths of a percent
+    uint32_t load = (uint32_t)(s->scan_cycles * 1000 / (s->active_us * mhz));
+    l61_printf("%s: %lu s, %lu scans/s, scan cpu %lu.%lu%%\n",
+               config.profile[i].name, ms / 1000,
+               (uint32_t)((uint64_t)s->scans * 1000 / ms), load / 10,
+               load % 10);
+    if (s->changes == 0)
+      continue;
+    l61_printf("  %lu changes, edge -> change avg %lu max %lu us, "
+               "change -> SOF avg %lu max %lu us\n",
+               s->changes, (uint32_t)(s->debounce_us / s->changes),
+               s->debounce_max_us,
+               s->sofs ? (uint32_t)(s->sof_us / s->sofs) : 0, s->sof_max_us);
+  }
+}
+
+void l61_profile_reset_stats() {
+  uint32_t status = save_and_disable_interrupts();
+  memset(stats, 0, sizeof(stats));
+  active_since_us = time_us_64();
+  restore_interrupts(status);
+}
@@ -0,0 +1,96 @@
+/*
+** file: lard61_profile.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Performance profiles: named sets of the scan, debounce and report
+** settings, to switch between them in one go rather than one command at a
+** time. The built-in profiles are:
+** - default: scanning from the main loop with deferred debouncing, as the
+**   firmware always did,
+** - office: timer scans at 500 Hz, slowing down to 100 Hz when idle,
+** - gaming: SOF-aligned scans, eager debouncing, and chords sent in a
+**   single report.
+**
+** The active profile is switched with the `profile` shell command or the
+** L61_PROFILE(index) and L61_PROFILE_NEXT keycodes, and the profiles are
+** edited with `profile set`. Both are saved to flash. The scan, debounce
+** and report settings all change between two scans. The `scan` shell
+** commands still override the scan settings, until the next switch. A
+** profile's debounce window replaces the learned window of every key,
+** unless it is 0.
+**
+** Each profile keeps its own statistics while active, to compare them on
+** the same typing: scan rate and processor share of the scan, which is the
+** part of the power the profiles change, and the delays from the first
+** edge of a key to its registration, and from its registration to the
+** next USB frame.
+*/
+
+#ifndef _LARD61_PROFILE_H
+#define _LARD61_PROFILE_H
+
+#include "pico/types.h"
+
+#define L61_PROFILE_COUNT 3
+// Longest name, with its terminating null character
+#define L61_PROFILE_NAME_SIZE 10
+// Keycode usage of L61_PROFILE_NEXT, the others select a profile by index
+#define L61_PROFILE_USAGE_NEXT 0xff
+
+// Saved to flash as is
+struct l61_profile {
+  char name[L61_PROFILE_NAME_SIZE];
+  // enum l61_scan_mode
+  uint8_t scan_mode;
+  // enum l61_debounce_mode
+  uint8_t debounce_mode;
+  // Scan rate in timer mode
+  uint16_t scan_rate_hz;
+  // Scan rate in timer mode once idle, 0 to keep scan_rate_hz
+  uint16_t idle_rate_hz;
+  // See l61_hid_set_key_throttle
+  uint8_t key_throttle;
+  uint8_t reserved;
+  // Debounce window of every key, 0 for the learned windows (see
+  // l61_debounce_set_window_override)
+  uint16_t debounce_window_us;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the profiles saved to flash and apply the active one.
+// Must be called after l61_scan_setup.
+void l61_profile_setup();
+// Apply a profile requested from the keyboard
+void l61_profile_task();
+// Apply profile `index` and save it as the active one.
+// Return false if there is no such profile.
+bool l61_profile_select(uint index);
+// Index of the profile called `name`, or -1
+int l61_profile_find(const char* name);
+// Set `field` of the active profile to `value`, apply and save it.
+// Return false if either is not valid.
+bool l61_profile_set(const char* field, const char* value);
+// Go back to the built-in profiles
+void l61_profile_restore_defaults();
+// Debounce window of the profile applied, which a selfbench run restores
+uint16_t l61_profile_get_debounce_window();
+
+// Handle a registered key state change, called by the debouncer with the
+// time since the first edge of the change
+void l61_profile_key(uint key, bool pressed, uint32_t delay_us);
+// Count a scan of the active profile, which took `cycles`
+void l61_profile_scan(uint32_t cycles);
+// Count the delay between a key state change and the next SOF
+void l61_profile_sof_delay(uint32_t delay_us);
+
+// Print the profiles via l61_printf
+void l61_profile_print();
+// Print the statistics of every profile via l61_printf
+void l61_profile_print_stats();
+void l61_profile_reset_stats();
+
+#endif /* _LARD61_PROFILE_H */
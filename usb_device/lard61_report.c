@@ -0,0 +1,66 @@
+/*
+** file: lard61_report.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+*/
+
+#include "lard61_report.h"
+
+#include <string.h>
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+#include "lard61_leader.h"
+#include "lard61_socd.h"
+#include "lard61_steno.h"
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void L61_HOT_FUNC(l61_report_build)(struct l61_report* report, uint max_keys) {
+  memset(report, 0, sizeof(*report));
+
+  if (max_keys > sizeof(report->keycode))
+    max_keys = sizeof(report->keycode);
+
+  // Read the keymap once, it may be swapped for a new one between reports
+  const uint16_t* keymap =
+      l61_keymap_get()->keycode[l61_keymatrix_is_fn_key_pressed()
+                                    ? L61_LAYER_FN
+                                    : L61_LAYER_BASE];
+
+  // Transform the "pressed" table from l61_keymatrix into the reports.
+  // When several consumer or system control keys are pressed, the one with
+  // the lowest key index wins. Keys used by a leader sequence or a steno
+  // chord, and keys losing to their opposite direction (see lard61_socd.h),
+  // are left out.
+  for (uint i = 0; i < N_ROWS * N_COLS; ++i) {
+    if (!l61_keymatrix_is_key_pressed(i) || l61_leader_is_consumed(i) ||
+        l61_steno_is_consumed(i) || l61_socd_is_masked(i))
+      continue;
+
+    uint16_t keycode = keymap[i];
+    uint16_t usage = keycode & L61_KC_USAGE_MASK;
+    switch (keycode & L61_KC_TYPE_MASK) {
+      case L61_KC_KEYBOARD:
+        // Avoid overflowing the buffer if too many keys are pressed
+        if (usage != HID_KEY_NONE && report->key_count < max_keys) {
+          report->keycode[report->key_count++] = (uint8_t)usage;
+        }
+        break;
+      case L61_KC_CONSUMER:
+        if (report->consumer == 0)
+          report->consumer = usage;
+        break;
+      case L61_KC_SYSTEM:
+        if (report->system == 0)
+          report->system = (uint8_t)usage;
+        break;
+      case L61_KC_MOUSE:
+        report->mouse |= 1u << usage;
+        break;
+    }
+  }
+}
@@ -0,0 +1,39 @@
+/*
+** file: lard61_report.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Translation of the debounced key matrix state into the contents of the
+** HID reports, through the active keymap (see lard61_keymap.h).
+** Sending the reports is left to lard61_hid.c.
+*/
+
+#ifndef _LARD61_REPORT_H
+#define _LARD61_REPORT_H
+
+#include "pico/types.h"
+
+// Contents of all the HID input reports
+struct l61_report {
+  // Keyboard report keycodes. Modifiers are sent as regular keycodes
+  // (HID_KEY_SHIFT_LEFT etc.), the modifier byte is not used.
+  uint8_t keycode[6];
+  // Number of used entries in `keycode`
+  uint8_t key_count;
+  // Consumer control usage (HID_USAGE_CONSUMER_*), 0 if none
+  uint16_t consumer;
+  // System control value (L61_SYSTEM_*), 0 if none
+  uint8_t system;
+  // Held mouse keys, as a bitmask of (1 << L61_MOUSE_*)
+  uint16_t mouse;
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Fill `report` from the current key matrix state.
+// At most `max_keys` keys are put in the keyboard report.
+void l61_report_build(struct l61_report* report, uint max_keys);
+
+#endif /* _LARD61_REPORT_H */
@@ -0,0 +1,446 @@
+/*
+** file: lard61_scan.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** The host polls the HID endpoint once per frame (bInterval = 1), shortly
+** after the start-of-frame (SOF) packet. When scanning freely, a key state
+** registered just after a poll waits for the next one, so the added latency
+** is uniformly spread between 0 and 1ms.
+**
+** In SOF-aligned mode, every SOF arms a hardware alarm which fires
+** L61_SOF_SCAN_LEAD_US before the next SOF. The scan runs in that alarm's
+** interrupt, and hid_task picks up the new state from the main loop in time
+** for the next poll.
+**
+** To check the effect, we histogram the delay between each registered key
+** state change and the following SOF.
+**
+** SOFs are timed in the USB interrupt, by a handler chained in front of
+** TinyUSB's, rather than in tud_sof_cb: TinyUSB invokes that from tud_task,
+** whenever the main loop gets to it. Should the handler ever run after
+** TinyUSB's, which clears the SOF interrupt, it would see no SOF, and
+** tud_sof_cb times them instead.
+**
+** In timer mode, the same alarm is rearmed at a fixed period from its own
+** previous target, so the scan cadence does not depend on the main loop.
+** A scan still running when the next one is due is an overrun: the missed
+** periods are skipped rather than queued up.
+**
+** With an idle rate set, timer mode slows down to it once no key has been
+** held or bouncing for L61_SCAN_IDLE_AFTER_US, and speeds up again at the
+** first scan which sees an edge. Only that first edge waits for the slower
+** period, the debouncing which follows runs at the full rate.
+*/
+
+#include "lard61_scan.h"
+
+#include <string.h>
+#include "device/usbd.h"
+#include "hardware/irq.h"
+#include "hardware/structs/usb.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "lard61_boot.h"
+#include "lard61_cdc.h"
+#include "lard61_cycles.h"
+#include "lard61_debounce.h"
+#include "lard61_health.h"
+#include "lard61_hot.h"
+#include "lard61_keymatrix.h"
+#include "lard61_profile.h"
+#include "pico/time.h"
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static volatile enum l61_scan_mode scan_mode = L61_SCAN_FREE_RUNNING;
+
+// Hardware alarm used to start the scan in SOF-aligned and timer modes
+static int scan_alarm = -1;
+
+// Scan period in timer mode, and target time of the next scan
+static uint32_t scan_period_us = 1000000 / L61_SCAN_RATE_DEFAULT_HZ;
+static uint64_t next_scan_us = 0;
+// Scan period in timer mode once idle, 0 to keep scan_period_us
+static uint32_t idle_period_us = 0;
+// Time of the last scan which saw a key held or bouncing
+static volatile uint32_t active_us = 0;
+
+// Set while l61_keymatrix_update is running, to make sure a scan from the
+// alarm interrupt never starts in the middle of one from the main loop
+static volatile bool scan_busy = false;
+
+// Time at which the last SOF was handled by tud_sof_cb
+static volatile uint32_t last_sof_us = 0;
+// SOFs timed by the USB interrupt handler, and how many of them
+// tud_sof_cb has seen
+static volatile uint32_t irq_sof_count = 0;
+static uint32_t seen_irq_sof_count = 0;
+// Whether the last SOF handled by tud_sof_cb was timed in the interrupt
+static bool irq_timed = false;
+// Whether at least one SOF was seen since boot, and how many
+static volatile bool sof_seen = false;
+static volatile uint32_t sof_count = 0;
+
+// Time at which the key matrix state last changed, and whether that change
+// has been followed by a SOF yet
+static volatile uint32_t commit_us = 0;
+static volatile bool commit_pending = false;
+
+// Delay between a key state change and the following SOF
+static struct {
+  uint32_t hist[L61_PHASE_HIST_BINS];
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t sof_count;
+} phase_stats;
+
+// Timer mode statistics
+static struct {
+  // Lateness of each scan relative to its target time
+  uint32_t jitter_hist[L61_JITTER_HIST_BINS];
+  uint32_t max_jitter_us;
+  uint32_t scans;
+  // Scans which were still running when the next one was due
+  uint32_t overruns;
+  // Periods skipped because of overruns
+  uint32_t skipped;
+  // Scans dropped because another one was in progress
+  uint32_t reentries;
+} timer_stats;
+
+// Duration of l61_keymatrix_update, to compare running from flash and RAM
+static struct {
+  uint32_t last_us;
+  uint32_t max_us;
+} scan_time;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Scan the matrix and remember when the debounced state changes
+static void L61_HOT_FUNC(scan)() {
+  if (scan_busy) {
+    timer_stats.reentries++;
+    return;
+  }
+  scan_busy = true;
+  uint32_t start = time_us_32();
+  uint32_t start_cycles = l61_cycles_now();
+  bool changed = l61_keymatrix_update();
+  uint32_t cycles = l61_cycles_record(L61_CYCLES_SCAN, start_cycles);
+  uint32_t end = time_us_32();
+  if (changed) {
+    commit_us = end;
+    commit_pending = true;
+  }
+  if (!l61_debounce_is_settled() || l61_keymatrix_get_pressed_count() > 0)
+    active_us = end;
+  scan_busy = false;
+  l61_profile_scan(cycles);
+
+  scan_time.last_us = end - start;
+  if (scan_time.last_us > scan_time.max_us)
+    scan_time.max_us = scan_time.last_us;
+}
+
+static void L61_HOT_FUNC(record_jitter)(uint32_t late_us) {
+  uint bin = 0;
+  while (late_us >> bin && bin < L61_JITTER_HIST_BINS - 1)
+    bin++;
+  timer_stats.jitter_hist[bin]++;
+  if (late_us > timer_stats.max_jitter_us)
+    timer_stats.max_jitter_us = late_us;
+}
+
+// Arm the alarm for next_scan_us. A target reached before the alarm is set
+// is missed and leaves the alarm disarmed, which would stop timer mode for
+// good: count it as an overrun and move on to the following period.
+static void L61_HOT_FUNC(arm_timer)(uint32_t period) {
+  while (hardware_alarm_set_target(scan_alarm,
+                                   from_us_since_boot(next_scan_us))) {
+    timer_stats.overruns++;
+    l61_health_count(L61_FAULT_SCAN_OVERRUN);
+    timer_stats.skipped++;
+    next_scan_us += period;
+  }
+}
+
+// Run one timer mode scan and rearm the alarm for the next period
+static void L61_HOT_FUNC(timer_scan)() {
+  uint64_t now = time_us_64();
+  record_jitter(now > next_scan_us ? (uint32_t)(now - next_scan_us) : 0);
+  timer_stats.scans++;
+
+  scan();
+
+  uint32_t period = scan_period_us;
+  if (idle_period_us > 0 && time_us_32() - active_us >= L61_SCAN_IDLE_AFTER_US)
+    period = idle_period_us;
+  next_scan_us += period;
+  now = time_us_64();
+  if (now >= next_scan_us) {
+    // Skip the periods we missed and realign on the original cadence
+    uint32_t missed = (uint32_t)((now - next_scan_us) / period) + 1;
+    timer_stats.overruns++;
+    l61_health_count(L61_FAULT_SCAN_OVERRUN);
+    timer_stats.skipped += missed;
+    next_scan_us += (uint64_t)missed * period;
+  }
+  arm_timer(period);
+}
+
+static void L61_HOT_FUNC(scan_alarm_callback)(uint alarm_num) {
+  (void)alarm_num;
+  switch (scan_mode) {
+    case L61_SCAN_SOF_ALIGNED:
+      scan();
+      break;
+    case L61_SCAN_TIMER:
+      timer_scan();
+      break;
+    default:
+      break;
+  }
+}
+
+static void L61_HOT_FUNC(record_phase)(uint32_t delay_us) {
+  uint bin = delay_us * L61_PHASE_HIST_BINS / L61_USB_FRAME_US;
+  if (bin >= L61_PHASE_HIST_BINS)
+    bin = L61_PHASE_HIST_BINS - 1;
+  phase_stats.hist[bin]++;
+
+  if (phase_stats.count == 0 || delay_us < phase_stats.min_us)
+    phase_stats.min_us = delay_us;
+  if (delay_us > phase_stats.max_us)
+    phase_stats.max_us = delay_us;
+  phase_stats.sum_us += delay_us;
+  phase_stats.count++;
+}
+
+// Arm the SOF-aligned scan and record the phase of a SOF seen at `sof_us`
+static void L61_HOT_FUNC(handle_sof)(uint64_t sof_us) {
+  if (scan_mode == L61_SCAN_SOF_ALIGNED) {
+    // Missed only if handled more than a frame late: the next SOF rearms it
+    hardware_alarm_set_target(
+        scan_alarm,
+        from_us_since_boot(sof_us + L61_USB_FRAME_US - L61_SOF_SCAN_LEAD_US));
+  }
+
+  // The scan alarm may fire in between reading the two commit variables
+  uint32_t status = save_and_disable_interrupts();
+  bool pending = commit_pending;
+  uint32_t commit = commit_us;
+  commit_pending = false;
+  restore_interrupts(status);
+
+  phase_stats.sof_count++;
+  if (pending) {
+    record_phase((uint32_t)sof_us - commit);
+    l61_profile_sof_delay((uint32_t)sof_us - commit);
+  }
+}
+
+// Chained in front of TinyUSB's USB interrupt handler, see above. The SOF
+// interrupt is left for TinyUSB to clear.
+static void L61_HOT_FUNC(usb_irq_handler)() {
+  if (!(usb_hw->ints & USB_INTS_DEV_SOF_BITS))
+    return;
+  irq_sof_count++;
+  handle_sof(time_us_64());
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_scan_setup() {
+  scan_alarm = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback(scan_alarm, &scan_alarm_callback);
+
+  // tud_sof_cb is only invoked once enabled, which also enables the SOF
+  // interrupt
+  tud_sof_cb_enable(true);
+  // TinyUSB added its handler in tud_init, with the highest order priority.
+  // The pico-sdk calls a handler added later with the same priority first.
+  irq_add_shared_handler(USBCTRL_IRQ, &usb_irq_handler,
+                         PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+
+  l61_scan_reset_stats();
+}
+
+void l61_scan_set_mode(enum l61_scan_mode mode) {
+  if (mode == scan_mode)
+    return;
+
+  hardware_alarm_cancel(scan_alarm);
+  scan_mode = mode;
+  // Statistics from the previous mode are not meaningful anymore
+  l61_scan_reset_stats();
+
+  if (mode == L61_SCAN_TIMER) {
+    next_scan_us = time_us_64() + scan_period_us;
+    arm_timer(scan_period_us);
+  }
+}
+
+enum l61_scan_mode l61_scan_get_mode() {
+  return scan_mode;
+}
+
+bool l61_scan_set_rate(uint hz) {
+  if (hz < L61_SCAN_RATE_MIN_HZ || hz > L61_SCAN_RATE_MAX_HZ)
+    return false;
+
+  // Picked up by the alarm when computing the next target
+  scan_period_us = 1000000 / hz;
+  l61_scan_reset_stats();
+  return true;
+}
+
+uint l61_scan_get_rate() {
+  return 1000000 / scan_period_us;
+}
+
+bool l61_scan_set_idle_rate(uint hz) {
+  if (hz != 0 && (hz < L61_SCAN_RATE_MIN_HZ || hz > L61_SCAN_RATE_MAX_HZ))
+    return false;
+
+  idle_period_us = hz ? 1000000 / hz : 0;
+  return true;
+}
+
+uint l61_scan_get_idle_rate() {
+  return idle_period_us ? 1000000 / idle_period_us : 0;
+}
+
+void l61_scan_task() {
+  switch (scan_mode) {
+    case L61_SCAN_FREE_RUNNING:
+      scan();
+      break;
+    case L61_SCAN_SOF_ALIGNED:
+      // Without SOFs (bus suspended or not connected yet), nothing would
+      // trigger the scan: keep scanning from the main loop instead.
+      if (!sof_seen || time_us_32() - last_sof_us > L61_SOF_TIMEOUT_US) {
+        scan();
+      }
+      break;
+    case L61_SCAN_TIMER:
+      // Scanned from the alarm only
+      break;
+  }
+}
+
+uint32_t l61_scan_get_sof_count() {
+  return sof_count;
+}
+
+void l61_scan_print_stats() {
+  switch (scan_mode) {
+    case L61_SCAN_FREE_RUNNING:
+      l61_printf("scan mode: free\n");
+      break;
+    case L61_SCAN_SOF_ALIGNED:
+      l61_printf("scan mode: sof, %d us lead\n", L61_SOF_SCAN_LEAD_US);
+      break;
+    case L61_SCAN_TIMER:
+      if (idle_period_us > 0) {
+        l61_printf("scan mode: timer, %lu Hz, %lu Hz when idle\n",
+                   1000000 / scan_period_us, 1000000 / idle_period_us);
+      } else {
+        l61_printf("scan mode: timer, %lu Hz\n", 1000000 / scan_period_us);
+      }
+      break;
+  }
+
+#if PICO_COPY_TO_RAM
+  l61_printf("code in: RAM (copy_to_ram binary)\n");
+#elif defined(L61_HOT_PATH_IN_RAM)
+  l61_printf("code in: RAM (hot path only)\n");
+#else
+  l61_printf("code in: flash\n");
+#endif
+  l61_printf("scan time: last %lu us, max %lu us\n", scan_time.last_us,
+             scan_time.max_us);
+
+  l61_printf("SOFs: %lu timed in %s, state changes: %lu\n",
+             phase_stats.sof_count,
+             irq_timed ? "USB interrupt" : "main loop", phase_stats.count);
+  if (phase_stats.count > 0) {
+    l61_printf("change -> SOF: min %lu us, avg %lu us, max %lu us\n",
+               phase_stats.min_us,
+               (uint32_t)(phase_stats.sum_us / phase_stats.count),
+               phase_stats.max_us);
+    for (uint i = 0; i < L61_PHASE_HIST_BINS; ++i) {
+      if (phase_stats.hist[i] == 0)
+        continue;
+      l61_printf("  %4u-%4u us: %lu\n",
+                 i * L61_USB_FRAME_US / L61_PHASE_HIST_BINS,
+                 (i + 1) * L61_USB_FRAME_US / L61_PHASE_HIST_BINS,
+                 phase_stats.hist[i]);
+    }
+  }
+
+  if (scan_mode != L61_SCAN_TIMER && timer_stats.reentries == 0)
+    return;
+
+  l61_printf("timer scans: %lu, overruns: %lu (%lu periods skipped), "
+             "reentries: %lu\n",
+             timer_stats.scans, timer_stats.overruns, timer_stats.skipped,
+             timer_stats.reentries);
+  l61_printf("jitter: max %lu us\n", timer_stats.max_jitter_us);
+  for (uint i = 0; i < L61_JITTER_HIST_BINS; ++i) {
+    if (timer_stats.jitter_hist[i] == 0)
+      continue;
+    if (i == 0) {
+      l61_printf("  0 us: %lu\n", timer_stats.jitter_hist[i]);
+    } else if (i == L61_JITTER_HIST_BINS - 1) {
+      l61_printf("  >= %u us: %lu\n", 1u << (i - 1),
+                 timer_stats.jitter_hist[i]);
+    } else {
+      l61_printf("  %u-%u us: %lu\n", 1u << (i - 1), (1u << i) - 1,
+                 timer_stats.jitter_hist[i]);
+    }
+  }
+}
+
+void l61_scan_reset_stats() {
+  uint32_t status = save_and_disable_interrupts();
+  memset(&phase_stats, 0, sizeof(phase_stats));
+  memset(&timer_stats, 0, sizeof(timer_stats));
+  scan_time.max_us = 0;
+  commit_pending = false;
+  restore_interrupts(status);
+}
+
+//-----------------------------------------------------------------------------
+// USB callbacks
+//-----------------------------------------------------------------------------
+
+// Invoked from tud_task for every start of frame, once enabled with
+// tud_sof_cb_enable
+void tud_sof_cb(uint32_t frame_count) {
+  (void)frame_count;
+
+  uint32_t now = time_us_32();
+  last_sof_us = now;
+  sof_count++;
+  if (!sof_seen) {
+    l61_boot_mark(L61_BOOT_FIRST_SOF);
+    sof_seen = true;
+  }
+
+  // Normally done by usb_irq_handler already. There is one call per SOF
+  // interrupt, unless TinyUSB's event queue overflowed.
+  irq_timed = seen_irq_sof_count != irq_sof_count;
+  if (irq_timed)
+    seen_irq_sof_count++;
+  else
+    handle_sof(time_us_64());
+}
@@ -0,0 +1,86 @@
+/*
+** file: lard61_scan.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Scheduling of the key matrix scan.
+**
+** By default the matrix is scanned from the main loop, as often as the loop
+** goes around. The SOF-aligned mode instead uses the USB start-of-frame to
+** start each scan a fixed time before the host's next poll, so that a key
+** state registered by the debouncer does not wait almost a whole frame
+** before being sent. The timer mode scans at a fixed rate from a hardware
+** alarm, independently of how long the rest of the main loop takes.
+*/
+
+#ifndef _LARD61_SCAN_H
+#define _LARD61_SCAN_H
+
+#include "pico/types.h"
+
+// Duration of a full speed USB frame
+#define L61_USB_FRAME_US 1000
+// In SOF-aligned mode, start scanning this long before the next expected
+// start of frame. This must leave enough time for the scan, debouncing and
+// hid_task to queue the report before the host polls the HID endpoint.
+#define L61_SOF_SCAN_LEAD_US 250
+// If no SOF was seen for this long (suspended or unplugged bus), the
+// SOF-aligned mode falls back to scanning from the main loop.
+#define L61_SOF_TIMEOUT_US (3 * L61_USB_FRAME_US)
+// Number of bins in the histogram of delays between a key state being
+// registered and the next start of frame. Each bin is
+// L61_USB_FRAME_US / L61_PHASE_HIST_BINS wide.
+#define L61_PHASE_HIST_BINS 10
+
+// Default and allowed scan rates in timer mode
+#define L61_SCAN_RATE_DEFAULT_HZ 1000
+#define L61_SCAN_RATE_MIN_HZ 100
+#define L61_SCAN_RATE_MAX_HZ 10000
+// With an idle rate set, timer mode switches to it once no key has been held
+// or bouncing for this long
+#define L61_SCAN_IDLE_AFTER_US 1000000
+// Number of bins in the timer mode jitter histogram. Bin 0 counts scans
+// started exactly on time, bin i counts a lateness in [2^(i-1), 2^i) us, and
+// the last bin counts anything later.
+#define L61_JITTER_HIST_BINS 10
+
+enum l61_scan_mode {
+  // Scan from the main loop, as fast as it goes around
+  L61_SCAN_FREE_RUNNING,
+  // Scan from a hardware alarm, L61_SOF_SCAN_LEAD_US before the next SOF
+  L61_SCAN_SOF_ALIGNED,
+  // Scan from a hardware alarm at a fixed rate, see l61_scan_set_rate
+  L61_SCAN_TIMER,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Claim the scan alarm and enable start-of-frame callbacks.
+// Must be called after tud_init and l61_keymatrix_setup.
+void l61_scan_setup();
+// Change the scan mode. Takes effect at the next scan.
+void l61_scan_set_mode(enum l61_scan_mode mode);
+enum l61_scan_mode l61_scan_get_mode();
+// Set the scan rate used in timer mode.
+// Return false if the rate is outside of the allowed range.
+bool l61_scan_set_rate(uint hz);
+uint l61_scan_get_rate();
+// Set the scan rate used in timer mode once idle, 0 to always scan at the
+// rate set by l61_scan_set_rate. A key pressed while idle is seen up to one
+// idle period late.
+// Return false if the rate is outside of the allowed range.
+bool l61_scan_set_idle_rate(uint hz);
+uint l61_scan_get_idle_rate();
+// Scan the key matrix from the main loop, if the current mode requires it
+void l61_scan_task();
+// Number of USB start of frames seen since boot
+uint32_t l61_scan_get_sof_count();
+
+// Print the frame phase, overrun and jitter statistics via l61_printf
+void l61_scan_print_stats();
+// Clear all scan statistics
+void l61_scan_reset_stats();
+
+#endif /* _LARD61_SCAN_H */
@@ -0,0 +1,216 @@
+/*
+** file: lard61_selfbench.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** l61_selfbench_inject runs in the scan, possibly from an alarm interrupt.
+** It owns the benchmark from start to finish, including restoring the
+** debounce windows, so the main loop only starts it and reads the results
+** once `done` is set. The main loop does not save the debounce windows
+** meanwhile.
+*/
+
+#include "lard61_selfbench.h"
+
+#include <string.h>
+#include "lard61_capture.h"
+#include "lard61_cdc.h"
+#include "lard61_debounce.h"
+#include "lard61_hid.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+#include "lard61_profile.h"
+#include "lard61_scan.h"
+#include "pico/time.h"
+
+#define KEY_COUNT (N_ROWS * N_COLS)
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static volatile bool active = false;
+static volatile bool done = false;
+static volatile bool stop_requested = false;
+
+static uint32_t stroke_count = 0;
+static uint32_t period_us = 0;
+static uint32_t start_us = 0;
+static bool started = false;
+// Key matrix index typing each letter
+static uint8_t letter_key[26];
+// Debounce windows from before the benchmark, and whether they were saved
+static struct l61_debounce_table saved_table;
+static bool saved_dirty = false;
+// Keyboard reports sent before the benchmark
+static uint32_t reports_before = 0;
+
+static struct {
+  uint32_t duration_us;
+  // Time from queueing a report to the host reading it
+  uint32_t queued_us;
+  bool queued;
+  uint64_t busy_total_us;
+  uint32_t busy_max_us;
+  uint32_t busy_count;
+  // Main loop iterations
+  uint32_t last_loop_us;
+  uint64_t loop_total_us;
+  uint32_t loop_max_us;
+  uint32_t loop_count;
+} results;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+// Called in the scan once the last stroke has settled, with all keys up
+static void L61_HOT_FUNC(finish)(uint32_t now_us) {
+  results.duration_us = now_us - start_us;
+  l61_debounce_set_window_override(l61_profile_get_debounce_window());
+  l61_debounce_init(&saved_table);
+  if (saved_dirty)
+    l61_debounce_set_dirty();
+  // The capture cannot replay the windows being restored
+  l61_capture_clear();
+  active = false;
+  done = true;
+}
+
+static void print_results() {
+  uint32_t ms = results.duration_us / 1000;
+  uint32_t reports = l61_hid_get_sent(L61_REPORT_KEYBOARD) - reports_before;
+  l61_printf("selfbench: %lu strokes at %lu Hz in %lu ms%s\n", stroke_count,
+             1000000 / period_us, ms, stop_requested ? ", stopped" : "");
+  l61_printf("reports: %lu keyboard, %lu/s\n", reports,
+             ms ? (uint32_t)((uint64_t)reports * 1000 / ms) : 0);
+  l61_printf("endpoint busy: mean %lu us, max %lu us\n",
+             results.busy_count
+                 ? (uint32_t)(results.busy_total_us / results.busy_count)
+                 : 0,
+             results.busy_max_us);
+  uint32_t slack = results.loop_max_us < L61_USB_FRAME_US
+                       ? L61_USB_FRAME_US - results.loop_max_us
+                       : 0;
+  l61_printf("main loop: %lu iterations, mean %lu us, max %lu us, "
+             "slack %lu us\n",
+             results.loop_count,
+             results.loop_count
+                 ? (uint32_t)(results.loop_total_us / results.loop_count)
+                 : 0,
+             results.loop_max_us, slack);
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+bool l61_selfbench_start(uint32_t strokes, uint32_t rate_hz) {
+  if (active || strokes == 0 || strokes > L61_SELFBENCH_MAX_STROKES ||
+      rate_hz == 0 || rate_hz > L61_SELFBENCH_MAX_RATE_HZ ||
+      (uint64_t)strokes * (1000000 / rate_hz) > L61_SELFBENCH_MAX_DURATION_US)
+    return false;
+  // Free running and SOF-aligned scans happen at least once per frame
+  uint32_t scan_us = l61_scan_get_mode() == L61_SCAN_TIMER
+                         ? 1000000 / l61_scan_get_rate()
+                         : L61_USB_FRAME_US;
+  if (1000000 / rate_hz / 2 < L61_DEBOUNCE_MIN_US + scan_us)
+    return false;
+
+  const uint16_t* base = l61_keymap_get()->keycode[L61_LAYER_BASE];
+  for (uint letter = 0; letter < 26; ++letter) {
+    int key = -1;
+    for (uint i = 0; i < KEY_COUNT && key < 0; ++i) {
+      if (base[i] == HID_KEY_A + letter)
+        key = i;
+    }
+    if (key < 0)
+      return false;
+    letter_key[letter] = (uint8_t)key;
+  }
+
+  memset(&results, 0, sizeof(results));
+  stroke_count = strokes;
+  period_us = 1000000 / rate_hz;
+  reports_before = l61_hid_get_sent(L61_REPORT_KEYBOARD);
+  saved_table = *l61_debounce_get_table();
+  saved_dirty = l61_debounce_is_dirty();
+  l61_debounce_set_window_override(L61_DEBOUNCE_MIN_US);
+  started = false;
+  stop_requested = false;
+  done = false;
+  active = true;
+  return true;
+}
+
+void l61_selfbench_stop() {
+  if (active)
+    stop_requested = true;
+}
+
+bool L61_HOT_FUNC(l61_selfbench_is_active)() {
+  return active;
+}
+
+void L61_HOT_FUNC(l61_selfbench_inject)(volatile bool* raw, uint32_t now_us) {
+  if (!active)
+    return;
+  if (!started) {
+    started = true;
+    start_us = now_us;
+  }
+
+  for (uint i = 0; i < KEY_COUNT; ++i)
+    raw[i] = false;
+
+  uint32_t elapsed = now_us - start_us;
+  uint32_t stroke = elapsed / period_us;
+  // Drop the remaining strokes, but let the last ones be released first
+  if (stop_requested && stroke < stroke_count)
+    stroke_count = stroke;
+  if (elapsed >= stroke_count * period_us + L61_SELFBENCH_SETTLE_US) {
+    finish(now_us);
+    return;
+  }
+  if (stroke < stroke_count && elapsed - stroke * period_us < period_us / 2)
+    raw[letter_key[L61_SELFBENCH_LETTER(stroke)]] = true;
+}
+
+void l61_selfbench_task() {
+  uint32_t now_us = time_us_32();
+  if (active) {
+    if (results.last_loop_us != 0) {
+      uint32_t loop_us = now_us - results.last_loop_us;
+      results.loop_total_us += loop_us;
+      results.loop_count++;
+      if (loop_us > results.loop_max_us)
+        results.loop_max_us = loop_us;
+    }
+    results.last_loop_us = now_us;
+  }
+
+  if (done) {
+    done = false;
+    print_results();
+  }
+}
+
+void L61_HOT_FUNC(l61_selfbench_report_queued)(uint32_t now_us) {
+  if (!active)
+    return;
+  results.queued_us = now_us;
+  results.queued = true;
+}
+
+void L61_HOT_FUNC(l61_selfbench_report_complete)(uint32_t now_us) {
+  if (!active || !results.queued)
+    return;
+  uint32_t busy_us = now_us - results.queued_us;
+  results.queued = false;
+  results.busy_total_us += busy_us;
+  results.busy_count++;
+  if (busy_us > results.busy_max_us)
+    results.busy_max_us = busy_us;
+}
@@ -0,0 +1,78 @@
+/*
+** file: lard61_selfbench.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** On-device benchmark of the whole key path, including what the host tools
+** cannot simulate: TinyUSB and the USB controller.
+**
+** `selfbench <strokes> <rate>` types `strokes` letters at `rate` strokes
+** per second by replacing the scanned key matrix state with synthetic
+** presses, right after the matrix scan. They go through the real
+** debounce, keymap, report building and HID endpoint, and reach the host
+** like typed keys. Each key is held for half of the stroke period. The
+** physical keys are ignored until the benchmark is over or stopped with
+** `selfbench stop`.
+**
+** Every key is debounced with the shortest window, L61_DEBOUNCE_MIN_US,
+** during the benchmark. A stroke's press and release must each last that
+** long plus a scan period to be registered, hence at most
+** L61_SELFBENCH_MAX_RATE_HZ, 250 strokes per second, when scanning every
+** frame, and less with a slow timer scan rate.
+**
+** Stroke i types letter (i * 11) % 26 of the alphabet, using the key the
+** active keymap puts that letter on, so the host can check that every
+** keystroke arrived in order (see tools/l61_selfbench.py).
+**
+** Once done, the keyboard prints the keyboard reports sent per second, the
+** time the HID endpoint stayed busy with each report until the host polled
+** it, and the main loop iteration times. The slack is what the longest
+** iteration left of a USB frame.
+**
+** The debounce windows learned before the benchmark are restored after it,
+** so the synthetic short presses do not widen them, and the keystroke
+** counters ignore it.
+*/
+
+#ifndef _LARD61_SELFBENCH_H
+#define _LARD61_SELFBENCH_H
+
+#include "lard61_debounce.h"
+#include "lard61_scan.h"
+#include "pico/types.h"
+
+// Holding a key for half a period covers the debounce window and a scan
+#define L61_SELFBENCH_MAX_RATE_HZ \
+  (1000000 / (2 * (L61_DEBOUNCE_MIN_US + L61_USB_FRAME_US)))
+#define L61_SELFBENCH_MAX_STROKES 100000
+#define L61_SELFBENCH_MAX_DURATION_US (600 * 1000000)
+// Time left after the last stroke for its release to be reported
+#define L61_SELFBENCH_SETTLE_US 50000
+
+// Letter typed by stroke `i`, from 0 for 'a' to 25 for 'z'
+#define L61_SELFBENCH_LETTER(i) (((i) * 11) % 26)
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Start typing `strokes` letters at `rate_hz`.
+// Return false if the parameters are out of range, the strokes are too
+// short for the debouncer at the current scan rate, the benchmark would
+// last longer than L61_SELFBENCH_MAX_DURATION_US, or a letter is missing
+// from the keymap.
+bool l61_selfbench_start(uint32_t strokes, uint32_t rate_hz);
+void l61_selfbench_stop();
+bool l61_selfbench_is_active();
+
+// Replace the scanned `raw` key states with the benchmark's, called by
+// l61_keymatrix_update before debouncing
+void l61_selfbench_inject(volatile bool* raw, uint32_t now_us);
+// Measure the main loop, and print the results once done
+void l61_selfbench_task();
+
+// Keyboard report queued on the HID endpoint, and sent to the host
+void l61_selfbench_report_queued(uint32_t now_us);
+void l61_selfbench_report_complete(uint32_t now_us);
+
+#endif /* _LARD61_SELFBENCH_H */
@@ -0,0 +1,184 @@
+/*
+** file: lard61_socd.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Each paired key knows its pair and side through a table indexed by key,
+** and each pair keeps which of its keys are held and which was pressed
+** last in one byte. Registering a key and deciding whether it is masked
+** thus take constant time, whatever the number of pairs.
+**
+** The pair states are written by the debouncer, which may run from the
+** scan alarm interrupt, and read by l61_report_build from the main loop.
+** Keeping each in a single byte means the report never sees half an update.
+*/
+
+#include "lard61_socd.h"
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_hot.h"
+#include "lard61_keymatrix.h"
+
+#define KEY_COUNT (N_ROWS * N_COLS)
+#define NO_PAIR 0xff
+
+// Bits of a pair state
+#define HELD_A 0x01
+#define HELD_B 0x02
+// Key b was pressed after key a
+#define LAST_B 0x04
+
+// Saved to flash as is
+struct socd_config {
+  uint8_t mode;
+  uint8_t count;
+  uint8_t key[L61_SOCD_MAX_PAIRS][2];
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static const char* const mode_names[L61_SOCD_MODE_COUNT] = {
+    [L61_SOCD_OFF] = "off",
+    [L61_SOCD_LAST] = "last",
+    [L61_SOCD_FIRST] = "first",
+    [L61_SOCD_NEUTRAL] = "neutral",
+};
+
+// A and D, W and S
+static struct socd_config config = {
+    .mode = L61_SOCD_OFF,
+    .count = 2,
+    .key = {{29, 31}, {16, 30}},
+};
+
+// Pair index << 1 | side of each key, or NO_PAIR
+static uint8_t pair_of[KEY_COUNT];
+static volatile uint8_t pair_state[L61_SOCD_MAX_PAIRS];
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static bool config_valid(const struct socd_config* c) {
+  if (c->mode >= L61_SOCD_MODE_COUNT || c->count > L61_SOCD_MAX_PAIRS)
+    return false;
+  bool used[KEY_COUNT] = {false};
+  for (uint i = 0; i < c->count; ++i) {
+    for (uint side = 0; side < 2; ++side) {
+      uint key = c->key[i][side];
+      if (key >= KEY_COUNT || used[key])
+        return false;
+      used[key] = true;
+    }
+  }
+  return true;
+}
+
+// Rebuild the key table from `config`, with the keys held right now
+static void apply_pairs() {
+  uint32_t status = save_and_disable_interrupts();
+  memset(pair_of, NO_PAIR, sizeof(pair_of));
+  for (uint i = 0; i < L61_SOCD_MAX_PAIRS; ++i) {
+    pair_state[i] = 0;
+    if (i >= config.count)
+      continue;
+    uint a = config.key[i][0];
+    uint b = config.key[i][1];
+    pair_of[a] = i << 1;
+    pair_of[b] = (i << 1) | 1;
+    pair_state[i] = (l61_keymatrix_is_key_pressed(a) ? HELD_A : 0) |
+                    (l61_keymatrix_is_key_pressed(b) ? HELD_B : 0);
+  }
+  restore_interrupts(status);
+}
+
+static void save() {
+  l61_config_store(L61_CONFIG_SOCD, &config, sizeof(config));
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_socd_setup() {
+  struct socd_config saved;
+  if (l61_config_load(L61_CONFIG_SOCD, &saved, sizeof(saved)) &&
+      config_valid(&saved))
+    config = saved;
+  apply_pairs();
+}
+
+void l61_socd_set_mode(enum l61_socd_mode mode) {
+  config.mode = mode;
+  save();
+}
+
+enum l61_socd_mode l61_socd_get_mode() {
+  return config.mode;
+}
+
+bool l61_socd_add_pair(uint a, uint b) {
+  if (config.count == L61_SOCD_MAX_PAIRS || a >= KEY_COUNT ||
+      b >= KEY_COUNT || a == b || pair_of[a] != NO_PAIR ||
+      pair_of[b] != NO_PAIR)
+    return false;
+  config.key[config.count][0] = (uint8_t)a;
+  config.key[config.count][1] = (uint8_t)b;
+  config.count++;
+  apply_pairs();
+  save();
+  return true;
+}
+
+void l61_socd_clear_pairs() {
+  config.count = 0;
+  apply_pairs();
+  save();
+}
+
+void L61_HOT_FUNC(l61_socd_key)(uint key, bool pressed) {
+  uint8_t p = pair_of[key];
+  if (p == NO_PAIR)
+    return;
+  bool side_b = p & 1;
+  uint8_t state = pair_state[p >> 1];
+  if (pressed) {
+    state |= side_b ? HELD_B : HELD_A;
+    state = side_b ? state | LAST_B : state & ~LAST_B;
+  } else {
+    state &= side_b ? ~HELD_B : ~HELD_A;
+  }
+  pair_state[p >> 1] = state;
+}
+
+bool L61_HOT_FUNC(l61_socd_is_masked)(uint index) {
+  uint8_t p = pair_of[index];
+  if (p == NO_PAIR || config.mode == L61_SOCD_OFF)
+    return false;
+  uint8_t state = pair_state[p >> 1];
+  if ((state & (HELD_A | HELD_B)) != (HELD_A | HELD_B))
+    return false;
+
+  bool pressed_last = ((state & LAST_B) != 0) == (p & 1);
+  switch (config.mode) {
+    case L61_SOCD_LAST:
+      return !pressed_last;
+    case L61_SOCD_FIRST:
+      return pressed_last;
+    default:
+      return true;
+  }
+}
+
+void l61_socd_print() {
+  l61_printf("mode: %s\n", mode_names[config.mode]);
+  for (uint i = 0; i < config.count; ++i) {
+    l61_printf("pair %u: keys %u and %u\n", i, config.key[i][0],
+               config.key[i][1]);
+  }
+}
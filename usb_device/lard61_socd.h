@@ -0,0 +1,57 @@
+/*
+** file: lard61_socd.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Simultaneous opposing cardinal directions (SOCD): when both keys of a
+** pair such as A and D are held, only one of them, or neither, is reported,
+** instead of leaving games to pick one, often after a frame of neither:
+** - last: the key pressed last wins, and the other one comes back when it
+**   is released, for quick strafing,
+** - first: the key held first wins until released,
+** - neutral: neither key is reported while both are held.
+**
+** The keys are physical matrix keys, on every layer. The pairs are set
+** with the `socd` shell command and saved to flash with the mode, A/D and
+** W/S by default. Resolution happens as keys are registered and as the
+** report is built, so the winning key goes out in the same report as the
+** press that decided it.
+*/
+
+#ifndef _LARD61_SOCD_H
+#define _LARD61_SOCD_H
+
+#include "pico/types.h"
+
+#define L61_SOCD_MAX_PAIRS 4
+
+enum l61_socd_mode {
+  // Both keys are reported
+  L61_SOCD_OFF,
+  L61_SOCD_LAST,
+  L61_SOCD_FIRST,
+  L61_SOCD_NEUTRAL,
+  L61_SOCD_MODE_COUNT,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the mode and pairs saved to flash
+void l61_socd_setup();
+void l61_socd_set_mode(enum l61_socd_mode mode);
+enum l61_socd_mode l61_socd_get_mode();
+// Add the pair of matrix keys `a` and `b`.
+// Return false if either is already paired, or there is no room left.
+bool l61_socd_add_pair(uint a, uint b);
+void l61_socd_clear_pairs();
+// Handle a registered key state change, called by the debouncer
+void l61_socd_key(uint key, bool pressed);
+// Whether key `index` loses to its opposite, and must be left out of the
+// reports
+bool l61_socd_is_masked(uint index);
+// Print the mode and pairs via l61_printf
+void l61_socd_print();
+
+#endif /* _LARD61_SOCD_H */
@@ -0,0 +1,201 @@
+/*
+** file: lard61_steno.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Chords are built in l61_steno_key, from the scan, possibly in an alarm
+** interrupt, and handed to the main loop through a single producer, single
+** consumer queue of packets. l61_steno_task only writes whole packets, and
+** only as many as the CDC TX FIFO has room for, so it never blocks and the
+** host never sees half a packet followed by shell output.
+*/
+
+#include "lard61_steno.h"
+
+#include <string.h>
+#include "class/cdc/cdc_device.h"
+#include "lard61_cdc.h"
+#include "lard61_health.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+#include "pico/time.h"
+
+#define KEY_COUNT (N_ROWS * N_COLS)
+
+_Static_assert(L61_STENO_KEY_COUNT == 7 * L61_STENO_PACKET_SIZE,
+               "GeminiPR packets hold 7 keys per byte");
+_Static_assert((L61_STENO_QUEUE_SIZE & (L61_STENO_QUEUE_SIZE - 1)) == 0,
+               "queue size must be a power of 2");
+
+// Entries of steno_layout are GeminiPR keys + 1, so 0 is no key
+#define STENO(key) (L61_STENO_##key + 1)
+
+struct packet {
+  uint8_t data[L61_STENO_PACKET_SIZE];
+  // Time the chord was complete
+  uint32_t time_us;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+// GeminiPR key of each key matrix index
+static const uint8_t steno_layout[KEY_COUNT] = {
+    // Row 0: number bar on 1 to =
+    [1] = STENO(N1),
+    [2] = STENO(N2),
+    [3] = STENO(N3),
+    [4] = STENO(N4),
+    [5] = STENO(N5),
+    [6] = STENO(N6),
+    [7] = STENO(N7),
+    [8] = STENO(N8),
+    [9] = STENO(N9),
+    [10] = STENO(NA),
+    [11] = STENO(NB),
+    [12] = STENO(NC),
+    // Row 1: Q to [
+    [15] = STENO(S1),
+    [16] = STENO(T),
+    [17] = STENO(P),
+    [18] = STENO(H),
+    [19] = STENO(ST1),
+    [20] = STENO(ST3),
+    [21] = STENO(RF),
+    [22] = STENO(RP),
+    [23] = STENO(RL),
+    [24] = STENO(RT),
+    [25] = STENO(RD),
+    // Row 2: A to '
+    [29] = STENO(S2),
+    [30] = STENO(K),
+    [31] = STENO(W),
+    [32] = STENO(R),
+    [33] = STENO(ST2),
+    [34] = STENO(ST4),
+    [35] = STENO(RR),
+    [36] = STENO(RB),
+    [37] = STENO(RG),
+    [38] = STENO(RS),
+    [39] = STENO(RZ),
+    // Row 3: C, V, N, M
+    [44] = STENO(A),
+    [45] = STENO(O),
+    [47] = STENO(RE),
+    [48] = STENO(RU),
+};
+
+static volatile bool enabled = false;
+// Enabled and the host has the port open, updated by l61_steno_task
+static volatile bool active = false;
+
+// Chord being built, and the number of its keys still held down
+static uint8_t chord[L61_STENO_PACKET_SIZE];
+static uint held = 0;
+// Keys taken by a chord, until released
+static volatile uint8_t consumed[(KEY_COUNT + 7) / 8];
+
+static struct packet queue[L61_STENO_QUEUE_SIZE];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+static struct {
+  uint32_t sent;
+  uint32_t dropped;
+  // Time between the end of a chord and its packet entering the TX FIFO
+  uint32_t last_latency_us;
+  uint32_t max_latency_us;
+} steno_stats;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static void L61_HOT_FUNC(end_chord)(uint32_t now_us) {
+  if (head - tail == L61_STENO_QUEUE_SIZE) {
+    steno_stats.dropped++;
+    l61_health_count(L61_FAULT_QUEUE_OVERFLOW);
+  } else {
+    struct packet* p = &queue[head & (L61_STENO_QUEUE_SIZE - 1)];
+    memcpy(p->data, chord, sizeof(chord));
+    p->data[0] |= L61_STENO_PACKET_START;
+    p->time_us = now_us;
+    head++;
+  }
+  memset(chord, 0, sizeof(chord));
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_steno_set_enabled(bool e) {
+  enabled = e;
+}
+
+bool l61_steno_is_enabled() {
+  return enabled;
+}
+
+void L61_HOT_FUNC(l61_steno_key)(uint key, bool pressed, uint32_t now_us) {
+  if (!pressed) {
+    if (!l61_steno_is_consumed(key))
+      return;
+    consumed[key / 8] &= ~(1 << (key % 8));
+    if (--held == 0)
+      end_chord(now_us);
+    return;
+  }
+
+  bool fn = l61_keymatrix_is_fn_key_pressed();
+  uint16_t keycode =
+      l61_keymap_get()->keycode[fn ? L61_LAYER_FN : L61_LAYER_BASE][key];
+  if ((keycode & L61_KC_TYPE_MASK) == L61_KC_STENO) {
+    enabled = !enabled;
+    return;
+  }
+
+  uint8_t steno_key = steno_layout[key];
+  if (!active || fn || steno_key == 0)
+    return;
+  steno_key -= 1;
+  chord[steno_key / 7] |= 0x40 >> (steno_key % 7);
+  consumed[key / 8] |= 1 << (key % 8);
+  held++;
+}
+
+bool L61_HOT_FUNC(l61_steno_is_consumed)(uint index) {
+  return consumed[index / 8] & (1 << (index % 8));
+}
+
+void l61_steno_task() {
+  // Chords in progress finish normally if the port is closed meanwhile
+  active = enabled && tud_cdc_connected();
+
+  bool written = false;
+  while (tail != head &&
+         tud_cdc_write_available() >= L61_STENO_PACKET_SIZE) {
+    const struct packet* p = &queue[tail & (L61_STENO_QUEUE_SIZE - 1)];
+    tud_cdc_write(p->data, L61_STENO_PACKET_SIZE);
+    steno_stats.last_latency_us = time_us_32() - p->time_us;
+    if (steno_stats.last_latency_us > steno_stats.max_latency_us)
+      steno_stats.max_latency_us = steno_stats.last_latency_us;
+    steno_stats.sent++;
+    tail++;
+    written = true;
+  }
+  if (written)
+    tud_cdc_write_flush();
+}
+
+void l61_steno_print() {
+  l61_printf("steno: %s%s\n", enabled ? "on" : "off",
+             enabled && !active ? ", waiting for the port to be opened" : "");
+  l61_printf("chords sent: %lu, dropped: %lu\n", steno_stats.sent,
+             steno_stats.dropped);
+  l61_printf("latency: last %lu us, max %lu us\n",
+             steno_stats.last_latency_us, steno_stats.max_latency_us);
+}
@@ -0,0 +1,106 @@
+/*
+** file: lard61_steno.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Stenography mode: the keys of the steno layout are gathered into chords,
+** and each chord is sent to the host over CDC as a GeminiPR packet, for
+** Plover or a similar steno engine. Any number of keys can be part of a
+** chord, unlike with the 6-key HID keyboard report.
+**
+** The layout is Plover's QWERTY one:
+**
+**   # # # # # # # # # # # #     (number row, 1 to =)
+**   S- T- P- H- *  *  -F -P -L -T -D
+**   S- K- W- R- *  *  -R -B -G -S -Z
+**         A- O-       -E -U
+**
+** A chord starts with the first steno key pressed and ends when all of
+** them are released. Steno keys are then left out of the HID reports, the
+** other keys keep typing normally, as do all keys while Fn is held.
+**
+** Steno mode is toggled by the L61_STENO_TOGGLE key (Fn+K) or the `steno
+** on|off` commands, and only applies while the host has the CDC port open.
+** Otherwise the keyboard types normally.
+**
+** A GeminiPR packet is 6 bytes. The first byte has its top bit set, the
+** others do not, which the host uses to find packet boundaries. The 42
+** remaining bits are the keys of enum l61_steno_key, from the top bit of
+** the first byte down.
+*/
+
+#ifndef _LARD61_STENO_H
+#define _LARD61_STENO_H
+
+#include "pico/types.h"
+
+#define L61_STENO_PACKET_SIZE 6
+// Top bit of the first byte of a packet
+#define L61_STENO_PACKET_START 0x80
+// Chords waiting to be written to the CDC FIFO
+#define L61_STENO_QUEUE_SIZE 16
+
+// GeminiPR keys, in packet order
+enum l61_steno_key {
+  L61_STENO_FN,
+  L61_STENO_N1,
+  L61_STENO_N2,
+  L61_STENO_N3,
+  L61_STENO_N4,
+  L61_STENO_N5,
+  L61_STENO_N6,
+  L61_STENO_S1,
+  L61_STENO_S2,
+  L61_STENO_T,
+  L61_STENO_K,
+  L61_STENO_P,
+  L61_STENO_W,
+  L61_STENO_H,
+  L61_STENO_R,
+  L61_STENO_A,
+  L61_STENO_O,
+  L61_STENO_ST1,
+  L61_STENO_ST2,
+  L61_STENO_RES1,
+  L61_STENO_RES2,
+  L61_STENO_PWR,
+  L61_STENO_ST3,
+  L61_STENO_ST4,
+  L61_STENO_RE,
+  L61_STENO_RU,
+  L61_STENO_RF,
+  L61_STENO_RR,
+  L61_STENO_RP,
+  L61_STENO_RB,
+  L61_STENO_RL,
+  L61_STENO_RG,
+  L61_STENO_RT,
+  L61_STENO_RS,
+  L61_STENO_RD,
+  L61_STENO_N7,
+  L61_STENO_N8,
+  L61_STENO_N9,
+  L61_STENO_NA,
+  L61_STENO_NB,
+  L61_STENO_NC,
+  L61_STENO_RZ,
+  L61_STENO_KEY_COUNT,
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_steno_set_enabled(bool enabled);
+bool l61_steno_is_enabled();
+// Handle a registered key state change, called by the debouncer
+void l61_steno_key(uint key, bool pressed, uint32_t now_us);
+// Whether key `index` is part of a chord, and must be left out of the
+// reports until released
+bool l61_steno_is_consumed(uint index);
+// Write the completed chords to CDC, as space in the TX FIFO allows
+void l61_steno_task();
+// Print the mode and packet counters via l61_printf
+void l61_steno_print();
+
+#endif /* _LARD61_STENO_H */
@@ -0,0 +1,215 @@
+/*
+** file: lard61_stream.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** The scan may run from an alarm interrupt (see lard61_scan.c), while the
+** CDC functions may only be called from the main loop. Frames are thus
+** encoded by the scan into a byte ring, and l61_stream_task copies them to
+** the CDC TX FIFO. The scan is the only writer of `head` and the task the
+** only writer of `tail`.
+**
+** A frame is only written if it fits entirely. Otherwise it is counted as
+** lost, and a snapshot is sent as soon as there is room again.
+*/
+
+#include "lard61_stream.h"
+
+#include <string.h>
+#include "class/cdc/cdc_device.h"
+#include "lard61_cdc.h"
+#include "lard61_health.h"
+#include "lard61_hot.h"
+
+// Size of the ring, a power of two. At 1 kHz, this holds a few hundred
+// milliseconds of every key changing at every scan.
+#define RING_SIZE 4096
+
+#define SNAPSHOT_SIZE (2 + 4 + 2 * L61_STREAM_BITMAP_SIZE + 1)
+#define LOST_SIZE 3
+#define DELTA_HEADER_SIZE 3
+
+_Static_assert(L61_STREAM_MAX_CHANGES < L61_STREAM_SNAPSHOT,
+               "delta frame counts must not look like other frames");
+_Static_assert(L61_STREAM_KEY_COUNT <= L61_STREAM_DEBOUNCED,
+               "key indices must fit below the debounced flag");
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static volatile bool active = false;
+
+static uint8_t ring[RING_SIZE];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+// States last sent to the host
+static uint8_t sent_raw[L61_STREAM_BITMAP_SIZE];
+static uint8_t sent_debounced[L61_STREAM_BITMAP_SIZE];
+
+static bool snapshot_needed = true;
+static uint32_t snapshot_us = 0;
+// Frames lost since the last L61_STREAM_LOST frame
+static uint32_t lost = 0;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t L61_HOT_FUNC(ring_space)() {
+  return RING_SIZE - (head - tail);
+}
+
+static void L61_HOT_FUNC(ring_write)(const uint8_t* data, uint32_t len) {
+  uint32_t h = head;
+  for (uint32_t i = 0; i < len; ++i)
+    ring[(h + i) & (RING_SIZE - 1)] = data[i];
+  // Publish the frame once it is complete
+  head = h + len;
+}
+
+// Count a lost frame, and each run of them as a fault
+static void L61_HOT_FUNC(drop_frame)() {
+  if (lost++ == 0)
+    l61_health_count(L61_FAULT_QUEUE_OVERFLOW);
+}
+
+static bool L61_HOT_FUNC(get_bit)(const uint8_t* bitmap, uint i) {
+  return bitmap[i / 8] & (1 << (i % 8));
+}
+
+static void L61_HOT_FUNC(write_snapshot)(const volatile bool* raw,
+                                         const bool* debounced,
+                                         uint32_t now_us) {
+  memset(sent_raw, 0, sizeof(sent_raw));
+  memset(sent_debounced, 0, sizeof(sent_debounced));
+  for (uint i = 0; i < L61_STREAM_KEY_COUNT; ++i) {
+    if (raw[i])
+      sent_raw[i / 8] |= 1 << (i % 8);
+    if (debounced[i])
+      sent_debounced[i / 8] |= 1 << (i % 8);
+  }
+
+  uint8_t frame[SNAPSHOT_SIZE];
+  uint8_t* p = frame;
+  *p++ = L61_STREAM_SNAPSHOT;
+  *p++ = L61_STREAM_SNAPSHOT_2;
+  for (uint i = 0; i < 4; ++i)
+    *p++ = now_us >> (8 * i);
+  memcpy(p, sent_raw, sizeof(sent_raw));
+  p += sizeof(sent_raw);
+  memcpy(p, sent_debounced, sizeof(sent_debounced));
+  p += sizeof(sent_debounced);
+  uint8_t check = 0;
+  for (uint8_t* q = frame; q < p; ++q)
+    check ^= *q;
+  *p++ = check;
+
+  ring_write(frame, sizeof(frame));
+  snapshot_needed = false;
+  snapshot_us = now_us;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_stream_start() {
+  active = false;
+  tail = head;
+  snapshot_needed = true;
+  lost = 0;
+  l61_printf("stream %d\n", L61_STREAM_VERSION);
+  active = true;
+}
+
+void l61_stream_stop() {
+  active = false;
+}
+
+bool l61_stream_is_active() {
+  return active;
+}
+
+void L61_HOT_FUNC(l61_stream_scan)(const volatile bool* raw,
+                                   const bool* debounced,
+                                   uint32_t now_us) {
+  if (!active)
+    return;
+
+  if (lost > 0) {
+    if (ring_space() < LOST_SIZE + SNAPSHOT_SIZE) {
+      drop_frame();
+      return;
+    }
+    uint32_t count = lost > UINT16_MAX ? UINT16_MAX : lost;
+    const uint8_t frame[LOST_SIZE] = {L61_STREAM_LOST, count, count >> 8};
+    ring_write(frame, sizeof(frame));
+    lost = 0;
+    snapshot_needed = true;
+  }
+
+  if (snapshot_needed || now_us - snapshot_us >= L61_STREAM_SNAPSHOT_US) {
+    if (ring_space() < SNAPSHOT_SIZE) {
+      drop_frame();
+      return;
+    }
+    write_snapshot(raw, debounced, now_us);
+    return;
+  }
+
+  uint8_t frame[DELTA_HEADER_SIZE + L61_STREAM_MAX_CHANGES];
+  uint count = 0;
+  uint8_t* changes = frame + DELTA_HEADER_SIZE;
+  for (uint i = 0; i < L61_STREAM_KEY_COUNT; ++i) {
+    if (raw[i] != get_bit(sent_raw, i))
+      changes[count++] = i;
+    if (debounced[i] != get_bit(sent_debounced, i))
+      changes[count++] = i | L61_STREAM_DEBOUNCED;
+  }
+  if (count == 0)
+    return;
+
+  uint32_t len = DELTA_HEADER_SIZE + count;
+  if (ring_space() < len) {
+    drop_frame();
+    return;
+  }
+  frame[0] = count;
+  frame[1] = now_us;
+  frame[2] = now_us >> 8;
+  ring_write(frame, len);
+
+  for (uint c = 0; c < count; ++c) {
+    uint i = changes[c] & ~L61_STREAM_DEBOUNCED;
+    uint8_t* bitmap =
+        changes[c] & L61_STREAM_DEBOUNCED ? sent_debounced : sent_raw;
+    bitmap[i / 8] ^= 1 << (i % 8);
+  }
+}
+
+void l61_stream_task() {
+  if (!active)
+    return;
+  if (!tud_cdc_connected()) {
+    active = false;
+    return;
+  }
+
+  // Copy the contiguous parts of the ring, at most up to the wrap point
+  uint32_t h = head;
+  if (tail == h)
+    return;
+  while (tail != h) {
+    uint32_t offset = tail & (RING_SIZE - 1);
+    uint32_t len = h - tail;
+    if (len > RING_SIZE - offset)
+      len = RING_SIZE - offset;
+    uint32_t written = tud_cdc_write(&ring[offset], len);
+    tail += written;
+    if (written < len)
+      break;
+  }
+  tud_cdc_write_flush();
+}
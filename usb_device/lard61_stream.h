@@ -0,0 +1,71 @@
+/*
+** file: lard61_stream.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Live streaming of the raw and debounced key matrix state over CDC, for a
+** key tester on the host (tools/l61_keytest.py).
+**
+** After the `stream` command, the keyboard prints a "stream <version>" line
+** followed by a stream of binary frames, until `stream stop` or the host
+** closes the port. Two kinds of frames are sent:
+**
+** - Delta frames, for every scan which changed something:
+**     count (1 byte, 1 to L61_STREAM_MAX_CHANGES)
+**     low 16 bits of the scan time in us (little endian)
+**     `count` change bytes: key index, | L61_STREAM_DEBOUNCED for a change
+**     of the debounced state rather than the raw one. Each change toggles
+**     the state.
+** - Snapshot frames, every L61_STREAM_SNAPSHOT_US and after frames were
+**   lost, so the host can resync and extend the 16-bit times:
+**     L61_STREAM_SNAPSHOT, L61_STREAM_SNAPSHOT_2
+**     scan time in us (32 bits, little endian)
+**     raw states, then debounced states, as L61_STREAM_BITMAP_SIZE bytes
+**     each with key i in bit i % 8 of byte i / 8
+**     xor of all the previous bytes of the frame
+**
+** A L61_STREAM_LOST byte followed by a 16-bit count means that many
+** frames did not fit in the buffer. The states are only valid again from
+** the next snapshot.
+*/
+
+#ifndef _LARD61_STREAM_H
+#define _LARD61_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lard61_keymatrix.h"
+
+#define L61_STREAM_VERSION 1
+
+#define L61_STREAM_KEY_COUNT (N_ROWS * N_COLS)
+#define L61_STREAM_BITMAP_SIZE ((L61_STREAM_KEY_COUNT + 7) / 8)
+#define L61_STREAM_MAX_CHANGES (2 * L61_STREAM_KEY_COUNT)
+
+// Flag of a change byte
+#define L61_STREAM_DEBOUNCED 0x80
+// First bytes of the other frames, above any delta frame count
+#define L61_STREAM_SNAPSHOT 0xf5
+#define L61_STREAM_SNAPSHOT_2 0x61
+#define L61_STREAM_LOST 0xfe
+
+// Snapshot period. Must stay below 2^16 us for the delta frame times to be
+// unambiguous.
+#define L61_STREAM_SNAPSHOT_US 50000
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Start or stop streaming
+void l61_stream_start();
+void l61_stream_stop();
+bool l61_stream_is_active();
+// Encode the changes of one scan, called by l61_keymatrix_update
+void l61_stream_scan(const volatile bool* raw,
+                     const bool* debounced,
+                     uint32_t now_us);
+// Send the encoded frames over CDC
+void l61_stream_task();
+
+#endif /* _LARD61_STREAM_H */
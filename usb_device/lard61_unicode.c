@@ -0,0 +1,286 @@
+/*
+** file: lard61_unicode.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Code points, or symbols of the table, are queued by the debouncer, which
+** may run from the scan alarm interrupt, and by the main loop with
+** interrupts disabled. They are taken out by l61_hid_task only, which
+** expands one at a time into the list of reports (steps) typing it.
+**
+** A step changes as many keys as possible: the report after [1] can be [f]
+** directly, releasing 1 and pressing f at once. Only a repeated key needs
+** a report without it in between, to be seen as a new press. Modifiers are
+** pressed one report before the keys they modify. A 4-digit code point on
+** Linux thus takes 9 reports, typed in 9 ms.
+**
+** The code point table takes 3 bytes per symbol in flash.
+*/
+
+#include "lard61_unicode.h"
+
+#include <string.h>
+#include "class/hid/hid.h"
+#include "hardware/sync.h"
+#include "lard61_cdc.h"
+#include "lard61_config.h"
+#include "lard61_hot.h"
+#include "lard61_keycodes.h"
+#include "lard61_keymap.h"
+#include "lard61_keymatrix.h"
+
+// Longest sequence: a macOS surrogate pair, with Option held alone, 8
+// digits with a release between each, and the final release
+#define MAX_STEPS 18
+#define STEP_KEYS 3
+
+// Queue entry holding a symbol of the table rather than a code point. The
+// table is only read from the main loop, so that it can stay in flash.
+#define SYMBOL_FLAG 0x80000000
+
+// 21-bit code point, little endian
+#define CP(c) {(c) & 0xff, ((c) >> 8) & 0xff, (c) >> 16}
+
+struct step {
+  uint8_t keycode[STEP_KEYS];
+  uint8_t count;
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static const uint8_t code_points[L61_UC_COUNT][3] = {
+    [L61_UC_DEGREE] = CP(0x00b0),
+    [L61_UC_EURO] = CP(0x20ac),
+    [L61_UC_POUND] = CP(0x00a3),
+    [L61_UC_MICRO] = CP(0x00b5),
+    [L61_UC_PLUS_MINUS] = CP(0x00b1),
+    [L61_UC_TIMES] = CP(0x00d7),
+    [L61_UC_DIVIDE] = CP(0x00f7),
+    [L61_UC_EN_DASH] = CP(0x2013),
+    [L61_UC_EM_DASH] = CP(0x2014),
+    [L61_UC_ELLIPSIS] = CP(0x2026),
+    [L61_UC_LEFT_QUOTE] = CP(0x201c),
+    [L61_UC_RIGHT_QUOTE] = CP(0x201d),
+    [L61_UC_ARROW_LEFT] = CP(0x2190),
+    [L61_UC_ARROW_RIGHT] = CP(0x2192),
+    [L61_UC_NOT_EQUAL] = CP(0x2260),
+    [L61_UC_LESS_EQUAL] = CP(0x2264),
+    [L61_UC_GREATER_EQUAL] = CP(0x2265),
+    [L61_UC_INFINITY] = CP(0x221e),
+    [L61_UC_LAMBDA] = CP(0x03bb),
+    [L61_UC_PI] = CP(0x03c0),
+    [L61_UC_CHECK_MARK] = CP(0x2713),
+    [L61_UC_THUMBS_UP] = CP(0x1f44d),
+};
+
+static const char* const mode_names[L61_UNICODE_MODE_COUNT] = {
+    [L61_UNICODE_LINUX] = "linux",
+    [L61_UNICODE_MACOS] = "macos",
+    [L61_UNICODE_WINDOWS] = "windows",
+    [L61_UNICODE_WINCOMPOSE] = "wincompose",
+};
+
+static enum l61_unicode_mode mode = L61_UNICODE_LINUX;
+
+static uint32_t queue[L61_UNICODE_QUEUE_SIZE];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+// Reports typing the current code point
+static struct step steps[MAX_STEPS];
+static uint step_count = 0;
+static uint step_next = 0;
+
+static struct {
+  uint32_t typed;
+  uint32_t reports;
+  // Queue full
+  uint32_t dropped;
+  // Not supported by the mode
+  uint32_t skipped;
+} unicode_stats;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static bool L61_HOT_FUNC(push)(uint32_t code_point) {
+  if (head - tail == L61_UNICODE_QUEUE_SIZE) {
+    unicode_stats.dropped++;
+    return false;
+  }
+  queue[head & (L61_UNICODE_QUEUE_SIZE - 1)] = code_point;
+  head++;
+  return true;
+}
+
+static void add_step(uint8_t held, uint8_t key) {
+  struct step* s = &steps[step_count++];
+  s->count = 0;
+  if (held != HID_KEY_NONE)
+    s->keycode[s->count++] = held;
+  if (key != HID_KEY_NONE)
+    s->keycode[s->count++] = key;
+}
+
+static uint8_t last_key() {
+  if (step_count == 0 || steps[step_count - 1].count == 0)
+    return HID_KEY_NONE;
+  return steps[step_count - 1].keycode[steps[step_count - 1].count - 1];
+}
+
+static uint8_t hex_key(uint digit, bool numpad) {
+  if (digit >= 10)
+    return HID_KEY_A + digit - 10;
+  if (numpad)
+    return digit == 0 ? HID_KEY_KEYPAD_0 : HID_KEY_KEYPAD_1 + digit - 1;
+  return digit == 0 ? HID_KEY_0 : HID_KEY_1 + digit - 1;
+}
+
+// Type `digits` hex digits of `value`, or as many as needed if 0, with
+// `held` pressed
+static void add_hex(uint32_t value, uint digits, uint8_t held, bool numpad) {
+  if (digits == 0) {
+    digits = 1;
+    while (digits < 8 && value >> (digits * 4) != 0)
+      digits++;
+  }
+  for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+    uint8_t key = hex_key((value >> shift) & 0xf, numpad);
+    if (key == last_key())
+      add_step(held, HID_KEY_NONE);
+    add_step(held, key);
+  }
+}
+
+// Fill `steps` with the reports typing `code_point` in the current mode.
+// Return false if the mode cannot type it.
+static bool expand(uint32_t code_point) {
+  step_count = 0;
+  step_next = 0;
+  switch (mode) {
+    case L61_UNICODE_LINUX:
+      steps[0] = (struct step){{HID_KEY_CONTROL_LEFT, HID_KEY_SHIFT_LEFT}, 2};
+      steps[1] = (struct step){
+          {HID_KEY_CONTROL_LEFT, HID_KEY_SHIFT_LEFT, HID_KEY_U}, 3};
+      step_count = 2;
+      add_step(HID_KEY_NONE, HID_KEY_NONE);
+      add_hex(code_point, 0, HID_KEY_NONE, false);
+      add_step(HID_KEY_NONE, HID_KEY_SPACE);
+      break;
+    case L61_UNICODE_MACOS:
+      add_step(HID_KEY_ALT_LEFT, HID_KEY_NONE);
+      if (code_point > 0xffff) {
+        // UTF-16 surrogate pair
+        uint32_t offset = code_point - 0x10000;
+        add_hex(0xd800 | (offset >> 10), 4, HID_KEY_ALT_LEFT, false);
+        add_hex(0xdc00 | (offset & 0x3ff), 4, HID_KEY_ALT_LEFT, false);
+      } else {
+        add_hex(code_point, 4, HID_KEY_ALT_LEFT, false);
+      }
+      break;
+    case L61_UNICODE_WINDOWS:
+      if (code_point > 0xffff)
+        return false;
+      add_step(HID_KEY_ALT_LEFT, HID_KEY_NONE);
+      add_step(HID_KEY_ALT_LEFT, HID_KEY_KEYPAD_ADD);
+      add_hex(code_point, 0, HID_KEY_ALT_LEFT, true);
+      break;
+    case L61_UNICODE_WINCOMPOSE:
+      add_step(HID_KEY_ALT_RIGHT, HID_KEY_NONE);
+      add_step(HID_KEY_NONE, HID_KEY_NONE);
+      add_step(HID_KEY_NONE, HID_KEY_U);
+      add_hex(code_point, 0, HID_KEY_NONE, false);
+      add_step(HID_KEY_NONE, HID_KEY_ENTER);
+      break;
+    default:
+      return false;
+  }
+  // Release everything
+  add_step(HID_KEY_NONE, HID_KEY_NONE);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_unicode_setup() {
+  uint32_t saved;
+  if (l61_config_load(L61_CONFIG_UNICODE, &saved, sizeof(saved)) &&
+      saved < L61_UNICODE_MODE_COUNT)
+    mode = saved;
+}
+
+void l61_unicode_set_mode(enum l61_unicode_mode new_mode) {
+  mode = new_mode;
+  uint32_t saved = mode;
+  l61_config_store(L61_CONFIG_UNICODE, &saved, sizeof(saved));
+}
+
+enum l61_unicode_mode l61_unicode_get_mode() {
+  return mode;
+}
+
+uint32_t l61_unicode_code_point(enum l61_unicode_symbol symbol) {
+  const uint8_t* c = code_points[symbol];
+  return c[0] | (c[1] << 8) | ((uint32_t)c[2] << 16);
+}
+
+bool l61_unicode_type(uint32_t code_point) {
+  // Surrogates are not characters
+  if (code_point > L61_UNICODE_MAX ||
+      (code_point >= 0xd800 && code_point <= 0xdfff))
+    return false;
+  uint32_t status = save_and_disable_interrupts();
+  bool ok = push(code_point);
+  restore_interrupts(status);
+  return ok;
+}
+
+void L61_HOT_FUNC(l61_unicode_key)(uint key, bool pressed) {
+  if (!pressed)
+    return;
+  uint layer =
+      l61_keymatrix_is_fn_key_pressed() ? L61_LAYER_FN : L61_LAYER_BASE;
+  uint16_t keycode = l61_keymap_get()->keycode[layer][key];
+  if ((keycode & L61_KC_TYPE_MASK) == L61_KC_UNICODE)
+    push(SYMBOL_FLAG | (keycode & L61_KC_USAGE_MASK));
+}
+
+bool l61_unicode_get_report(struct l61_report* report) {
+  while (step_next == step_count) {
+    if (tail == head)
+      return false;
+    uint32_t code_point = queue[tail & (L61_UNICODE_QUEUE_SIZE - 1)];
+    tail++;
+    if (code_point & SYMBOL_FLAG)
+      code_point = l61_unicode_code_point(code_point & ~SYMBOL_FLAG);
+    if (expand(code_point))
+      unicode_stats.typed++;
+    else
+      unicode_stats.skipped++;
+  }
+
+  memset(report, 0, sizeof(*report));
+  const struct step* s = &steps[step_next];
+  memcpy(report->keycode, s->keycode, s->count);
+  report->key_count = s->count;
+  return true;
+}
+
+void l61_unicode_report_sent() {
+  if (step_next == step_count)
+    return;
+  step_next++;
+  unicode_stats.reports++;
+}
+
+void l61_unicode_print() {
+  l61_printf("mode: %s\n", mode_names[mode]);
+  l61_printf("typed: %lu in %lu reports, dropped: %lu, skipped: %lu\n",
+             unicode_stats.typed, unicode_stats.reports,
+             unicode_stats.dropped, unicode_stats.skipped);
+}
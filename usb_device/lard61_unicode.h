@@ -0,0 +1,98 @@
+/*
+** file: lard61_unicode.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Unicode input: L61_UNICODE(symbol) keys type characters which have no
+** HID usage, through the host's own Unicode input method:
+** - Linux (IBus, GTK): Ctrl+Shift+U, the hex code point, Space,
+** - macOS with the "Unicode Hex Input" source: the UTF-16 code units in
+**   hex while holding Option,
+** - Windows with EnableHexNumpad set in the registry: Alt held, numpad +,
+**   then the hex code point. Only code points up to U+FFFF can be typed,
+** - WinCompose: its compose key (Right Alt), U, the hex code point, Enter.
+**
+** Each code point is typed as a sequence of keyboard reports, sent back to
+** back whenever the endpoint is ready, which changes several keys at once
+** where the host allows it. Modifiers held by the user are released during
+** the sequence, so they do not change the hex digits, and pressed again
+** right after it.
+**
+** Code points are queued when their key is pressed, so fast typing is
+** never lost while a previous one is still being sent. The mode is chosen
+** with the `unicode` shell command and saved to flash.
+*/
+
+#ifndef _LARD61_UNICODE_H
+#define _LARD61_UNICODE_H
+
+#include "lard61_report.h"
+#include "pico/types.h"
+
+// Code points waiting to be typed, a power of 2
+#define L61_UNICODE_QUEUE_SIZE 32
+#define L61_UNICODE_MAX 0x10ffff
+
+enum l61_unicode_mode {
+  L61_UNICODE_LINUX,
+  L61_UNICODE_MACOS,
+  L61_UNICODE_WINDOWS,
+  L61_UNICODE_WINCOMPOSE,
+  L61_UNICODE_MODE_COUNT
+};
+
+// Symbols of the code point table, for L61_UNICODE(symbol) keys
+enum l61_unicode_symbol {
+  L61_UC_DEGREE,
+  L61_UC_EURO,
+  L61_UC_POUND,
+  L61_UC_MICRO,
+  L61_UC_PLUS_MINUS,
+  L61_UC_TIMES,
+  L61_UC_DIVIDE,
+  L61_UC_EN_DASH,
+  L61_UC_EM_DASH,
+  L61_UC_ELLIPSIS,
+  L61_UC_LEFT_QUOTE,
+  L61_UC_RIGHT_QUOTE,
+  L61_UC_ARROW_LEFT,
+  L61_UC_ARROW_RIGHT,
+  L61_UC_NOT_EQUAL,
+  L61_UC_LESS_EQUAL,
+  L61_UC_GREATER_EQUAL,
+  L61_UC_INFINITY,
+  L61_UC_LAMBDA,
+  L61_UC_PI,
+  L61_UC_CHECK_MARK,
+  L61_UC_THUMBS_UP,
+  L61_UC_COUNT
+};
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Load the saved mode
+void l61_unicode_setup();
+// Use `mode` and save it to flash
+void l61_unicode_set_mode(enum l61_unicode_mode mode);
+enum l61_unicode_mode l61_unicode_get_mode();
+// Code point of a symbol of the table
+uint32_t l61_unicode_code_point(enum l61_unicode_symbol symbol);
+// Queue a code point to be typed. Return false if the queue is full or the
+// code point invalid.
+bool l61_unicode_type(uint32_t code_point);
+
+// Handle a registered key state change, called by the debouncer
+void l61_unicode_key(uint key, bool pressed);
+// While code points are being typed, fill the next keyboard report to send
+// and return true
+bool l61_unicode_get_report(struct l61_report* report);
+// Move on to the next report, after the one from l61_unicode_get_report
+// was sent
+void l61_unicode_report_sent();
+
+// Print the mode and counters via l61_printf
+void l61_unicode_print();
+
+#endif /* _LARD61_UNICODE_H */
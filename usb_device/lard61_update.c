@@ -0,0 +1,204 @@
+/*
+** file: lard61_update.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** While receiving, the CDC is in raw mode and the image is read straight
+** from its FIFO into the flash writer, only as fast as the writer accepts
+** it. USB flow control holds the host back in the meantime.
+**
+** The keyboard keeps working during the transfer, but in builds running
+** from flash every sector erase stalls it for a few tens of milliseconds.
+*/
+
+#include "lard61_update.h"
+
+#include "class/cdc/cdc_device.h"
+#include "device/usbd.h"
+#include "lard61_bootctl.h"
+#include "lard61_cdc.h"
+#include "lard61_crc.h"
+#include "lard61_flash.h"
+#include "lard61_flash_writer.h"
+#include "lard61_health.h"
+#include "pico/time.h"
+
+// Delay between the end of the update and the reboot, to let the last
+// message reach the host
+#define REBOOT_DELAY_MS 100
+
+enum update_state {
+  UPDATE_IDLE,
+  UPDATE_RECEIVING,
+  UPDATE_REBOOTING,
+};
+
+//-----------------------------------------------------------------------------
+// Static variables
+//-----------------------------------------------------------------------------
+
+static enum update_state state = UPDATE_IDLE;
+static struct l61_flash_writer writer;
+static uint32_t image_crc = 0;
+// Time of the last data received, for the timeout
+static uint32_t last_rx_ms = 0;
+
+static struct l61_bootctl bootctl;
+// Time since which the device is mounted, while waiting to confirm
+static uint32_t mounted_since_ms = 0;
+static bool mounted = false;
+
+//-----------------------------------------------------------------------------
+// Internal API
+//-----------------------------------------------------------------------------
+
+static uint32_t now_ms() {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+#ifdef L61_FLASH_SLOT
+static uint inactive_slot() {
+  return 1 - L61_FLASH_SLOT;
+}
+
+static void stop_receiving() {
+  l61_cdc_set_raw(false);
+  state = UPDATE_IDLE;
+}
+
+static void finish_update() {
+  uint slot = inactive_slot();
+  uint32_t crc = l61_crc32(L61_CRC32_INIT,
+                           l61_flash_ptr(l61_flash_slot_offset(slot)),
+                           writer.size);
+  stop_receiving();
+  if (crc != image_crc) {
+    l61_printf("update: crc mismatch, got %08lx\n", crc);
+    return;
+  }
+
+  bootctl.previous_slot = L61_FLASH_SLOT;
+  bootctl.active_slot = slot;
+  bootctl.confirmed = 0;
+  bootctl.boot_attempts = 0;
+  bootctl.image_size[slot] = writer.size;
+  bootctl.image_crc[slot] = crc;
+  l61_bootctl_write(&bootctl);
+
+  l61_printf("update: ok, rebooting into slot %c\n", 'a' + slot);
+  l61_health_reboot(REBOOT_DELAY_MS);
+  state = UPDATE_REBOOTING;
+}
+
+static void receive() {
+  // Move whatever the writer can take from the CDC FIFO
+  uint8_t chunk[64];
+  uint32_t len;
+  while ((len = l61_flash_writer_space(&writer)) > 0 && tud_cdc_available()) {
+    if (len > sizeof(chunk))
+      len = sizeof(chunk);
+    len = tud_cdc_read(chunk, len);
+    l61_flash_writer_push(&writer, chunk, len);
+    last_rx_ms = now_ms();
+  }
+
+  l61_flash_writer_poll(&writer);
+
+  if (l61_flash_writer_done(&writer)) {
+    finish_update();
+  } else if (now_ms() - last_rx_ms > L61_UPDATE_TIMEOUT_MS) {
+    l61_printf("update: timeout after %lu bytes\n", writer.received);
+    stop_receiving();
+  }
+}
+
+// Confirm the image we are running from once it has proven to work
+static void confirm() {
+  if (!tud_mounted()) {
+    mounted = false;
+    return;
+  }
+  if (!mounted) {
+    mounted = true;
+    mounted_since_ms = now_ms();
+  }
+  if (now_ms() - mounted_since_ms < L61_UPDATE_CONFIRM_MS)
+    return;
+
+  bootctl.confirmed = 1;
+  bootctl.boot_attempts = 0;
+  // The bootloader's trial watchdog was taken over by the health monitor's,
+  // which keeps running
+  l61_bootctl_write(&bootctl);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+void l61_update_setup() {
+#ifdef L61_FLASH_SLOT
+  l61_bootctl_read(&bootctl);
+#endif
+}
+
+void l61_update_task() {
+#ifdef L61_FLASH_SLOT
+  switch (state) {
+    case UPDATE_IDLE:
+      if (bootctl.active_slot == L61_FLASH_SLOT && !bootctl.confirmed)
+        confirm();
+      break;
+    case UPDATE_RECEIVING:
+      receive();
+      break;
+    case UPDATE_REBOOTING:
+      break;
+  }
+#endif
+}
+
+void l61_update_start(uint32_t size, uint32_t crc) {
+#ifdef L61_FLASH_SLOT
+  if (state != UPDATE_IDLE) {
+    l61_printf("update: busy\n");
+    return;
+  }
+  if (size == 0 || size > L61_FLASH_SLOT_SIZE) {
+    l61_printf("update: size must be between 1 and %d bytes\n",
+               L61_FLASH_SLOT_SIZE);
+    return;
+  }
+
+  uint slot = inactive_slot();
+  l61_flash_writer_init(&writer, &l61_flash_ops, l61_flash_slot_offset(slot),
+                        size);
+  image_crc = crc;
+  last_rx_ms = now_ms();
+  state = UPDATE_RECEIVING;
+  // Anything the host sends from now on is image data
+  l61_cdc_set_raw(true);
+  l61_printf("ready\n");
+#else
+  (void)size;
+  (void)crc;
+  l61_printf("update: not supported, build with L61_AB_UPDATE\n");
+#endif
+}
+
+void l61_update_print_status() {
+#ifdef L61_FLASH_SLOT
+  l61_printf("running slot %c, update slot %c\n", 'a' + L61_FLASH_SLOT,
+             'a' + inactive_slot());
+  for (uint slot = 0; slot < L61_FLASH_SLOT_COUNT; ++slot) {
+    l61_printf("slot %c: %lu bytes, crc %08lx%s\n", 'a' + slot,
+               bootctl.image_size[slot], bootctl.image_crc[slot],
+               slot == bootctl.active_slot
+                   ? (bootctl.confirmed ? " (active)" : " (trial)")
+                   : "");
+  }
+#else
+  l61_printf("update: not supported, build with L61_AB_UPDATE\n");
+#endif
+}
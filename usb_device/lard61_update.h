@@ -0,0 +1,43 @@
+/*
+** file: lard61_update.h
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** Firmware self-update over the CDC interface, into the slot which is not
+** running (see lard61_flash.h), without going through BOOTSEL.
+**
+** The host sends `update <size> <crc>`, waits for "ready", then streams
+** the raw image for the inactive slot. Once the CRC-32 of the written
+** image matches, the bootloader is told to try the new slot and the
+** keyboard reboots. The new image confirms itself once it has been
+** enumerated by the host for L61_UPDATE_CONFIRM_MS; otherwise the
+** bootloader rolls back to the previous slot. See tools/l61_update.py.
+**
+** Only available in firmware built with L61_AB_UPDATE, which defines
+** L61_FLASH_SLOT to the slot the firmware is linked for.
+*/
+
+#ifndef _LARD61_UPDATE_H
+#define _LARD61_UPDATE_H
+
+#include "pico/types.h"
+
+// Abort the update if no data was received for this long
+#define L61_UPDATE_TIMEOUT_MS 2000
+// Time the new image must stay mounted before being confirmed
+#define L61_UPDATE_CONFIRM_MS 2000
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+// Read the boot control record. Must be called before l61_update_task.
+void l61_update_setup();
+// Receive and write the image, confirm a trial boot
+void l61_update_task();
+// Start receiving an image of `size` bytes with the given CRC-32
+void l61_update_start(uint32_t size, uint32_t crc);
+// Print the running slot and the state of both slots via l61_printf
+void l61_update_print_status();
+
+#endif /* _LARD61_UPDATE_H */
@@ -0,0 +1,94 @@
+/*
+** file: lard61_usb.c
+** author: beulard (Matthias Dubouchet)
+** creation date: 18/10/2026
+**
+** TinyUSB device state and HID callbacks. They only depend on the modules
+** they notify, so that the host USB harness (host/l61_usb_sim.c) can run
+** them as well.
+*/
+
+#include "class/hid/hid_device.h"
+#include "device/usbd.h"
+#include "lard61_boot.h"
+#include "lard61_health.h"
+#include "lard61_hid.h"
+#include "lard61_led.h"
+#include "lard61_selfbench.h"
+#include "pico/time.h"
+
+//-----------------------------------------------------------------------------
+// USB state callbacks
+//-----------------------------------------------------------------------------
+
+// USB bus is mounted (configured)
+void tud_mount_cb() {
+  l61_boot_mark(L61_BOOT_MOUNTED);
+  l61_health_trace(L61_HEALTH_MOUNT, 0);
+  l61_led_set_usb_state(L61_LED_MOUNTED);
+}
+
+// USB bus is unmounted
+void tud_umount_cb() {
+  l61_health_trace(L61_HEALTH_UNMOUNT, 0);
+  l61_led_set_usb_state(L61_LED_UNMOUNTED);
+}
+
+// USB bus is suspended
+void tud_suspend_cb(bool remote_wakeup_en) {
+  (void)remote_wakeup_en;
+  l61_health_trace(L61_HEALTH_SUSPEND, 0);
+  l61_led_set_usb_state(L61_LED_SUSPENDED);
+}
+
+// USB bus is resumed
+void tud_resume_cb() {
+  l61_health_trace(L61_HEALTH_RESUME, 0);
+  l61_led_set_usb_state(tud_mounted() ? L61_LED_MOUNTED : L61_LED_UNMOUNTED);
+}
+
+//--------------------------------------------------------------------+
+// USB HID callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when received GET_REPORT control request
+uint16_t tud_hid_get_report_cb(uint8_t itf,
+                               uint8_t report_id,
+                               hid_report_type_t report_type,
+                               uint8_t* buffer,
+                               uint16_t reqlen) {
+  (void)itf;
+  (void)report_id;
+  (void)report_type;
+  (void)buffer;
+  (void)reqlen;
+
+  return 0;
+}
+
+// Invoked when a report was read by the host
+void tud_hid_report_complete_cb(uint8_t instance,
+                                uint8_t const* report,
+                                uint16_t len) {
+  (void)report;
+  (void)len;
+
+  if (instance == L61_HID_KEYBOARD)
+    l61_selfbench_report_complete(time_us_32());
+}
+
+// Invoked when received SET_REPORT control request or
+// received data on OUT endpoint ( Report ID = 0, Type = 0 )
+void tud_hid_set_report_cb(uint8_t itf,
+                           uint8_t report_id,
+                           hid_report_type_t report_type,
+                           uint8_t const* buffer,
+                           uint16_t bufsize) {
+  // The only output report is the keyboard LEDs. TinyUSB strips the report
+  // ID from the buffer; there is none in boot protocol.
+  if (itf == L61_HID_KEYBOARD && report_type == HID_REPORT_TYPE_OUTPUT &&
+      (report_id == L61_REPORT_ID_KEYBOARD || report_id == 0) &&
+      bufsize >= 1) {
+    l61_led_set_host_leds(buffer[0]);
+  }
+}
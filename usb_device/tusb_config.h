@@ -93,7 +93,7 @@
 //------------- CLASS -------------//
 #define CFG_TUD_CDC               1
 #define CFG_TUD_MSC               0
-#define CFG_TUD_HID               1
+#define CFG_TUD_HID               2  // Keyboard and mouse keys
 #define CFG_TUD_MIDI              0
 #define CFG_TUD_VENDOR            0
 
@@ -104,7 +104,7 @@
 // When printing large amounts of stuff, increasing this
 // can prevent data from being cut off.
 #define CFG_TUD_CDC_RX_BUFSIZE 256
-#define CFG_TUD_CDC_TX_BUFSIZE 256
+#define CFG_TUD_CDC_TX_BUFSIZE 1024
 
 #ifdef __cplusplus
  }
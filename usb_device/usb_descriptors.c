@@ -24,6 +24,7 @@
  */
 
 #include "tusb.h"
+#include "lard61_hid.h"
 
 //--------------------------------------------------------------------+
 // Device Descriptors
@@ -63,7 +64,16 @@ uint8_t const * tud_descriptor_device_cb(void)
 
 uint8_t const desc_hid_report[] =
 {
-  TUD_HID_REPORT_DESC_KEYBOARD()
+  TUD_HID_REPORT_DESC_KEYBOARD( HID_REPORT_ID(L61_REPORT_ID_KEYBOARD) ),
+  TUD_HID_REPORT_DESC_CONSUMER( HID_REPORT_ID(L61_REPORT_ID_CONSUMER_CONTROL) ),
+  TUD_HID_REPORT_DESC_SYSTEM_CONTROL( HID_REPORT_ID(L61_REPORT_ID_SYSTEM_CONTROL) )
+};
+
+// Mouse keys have their own interface and endpoint, so that pointer reports
+// never take the keyboard endpoint away from keystrokes
+uint8_t const desc_hid_mouse_report[] =
+{
+  TUD_HID_REPORT_DESC_MOUSE()
 };
 
 // Invoked when received GET HID REPORT DESCRIPTOR
@@ -71,7 +81,7 @@ uint8_t const desc_hid_report[] =
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const * tud_hid_descriptor_report_cb(uint8_t itf)
 {
-  (void) itf;
+  if (itf == L61_HID_MOUSE) return desc_hid_mouse_report;
   return desc_hid_report;
 }
 
@@ -84,12 +94,14 @@ enum
   ITF_NUM_HID,
   ITF_NUM_CDC,
   ITF_NUM_CDC_DATA,  // Required
+  ITF_NUM_HID_MOUSE,
   ITF_NUM_TOTAL
 };
 
-#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
+#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN)
 
 #define EPNUM_HID     0x81
+#define EPNUM_HID_MOUSE   0x84
 
 #define EPNUM_CDC_NOTIF   0x82
 #define EPNUM_CDC_OUT     0x02
@@ -105,8 +117,29 @@ uint8_t const desc_configuration[] =
 
   // Interface number, string index, EP notification address and size, EP data address (out, in) and size.
   TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 5, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+
+  // Mouse keys, polled every frame like the keyboard
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID_MOUSE, 6, HID_ITF_PROTOCOL_MOUSE, sizeof(desc_hid_mouse_report), EPNUM_HID_MOUSE, CFG_TUD_HID_EP_BUFSIZE, 1),
 };
 
+// Checked against the descriptors by host/l61_usb_sim.c too
+TU_VERIFY_STATIC(
+    sizeof(desc_configuration) == CONFIG_TOTAL_LEN,
+    "CONFIG_TOTAL_LEN does not match the configuration descriptor");
+TU_VERIFY_STATIC(ITF_NUM_TOTAL == CFG_TUD_HID + 2 * CFG_TUD_CDC,
+                 "Each HID has one interface and each CDC two");
+// TinyUSB numbers the HID instances in the order of their interfaces
+TU_VERIFY_STATIC(L61_HID_KEYBOARD == 0 && L61_HID_MOUSE == 1 &&
+                 ITF_NUM_HID < ITF_NUM_HID_MOUSE,
+                 "HID instances do not match lard61_hid.h");
+TU_VERIFY_STATIC(EPNUM_HID != EPNUM_HID_MOUSE &&
+                     EPNUM_HID != EPNUM_CDC_NOTIF &&
+                     EPNUM_HID != EPNUM_CDC_IN &&
+                     EPNUM_HID_MOUSE != EPNUM_CDC_NOTIF &&
+                     EPNUM_HID_MOUSE != EPNUM_CDC_IN &&
+                     EPNUM_CDC_NOTIF != EPNUM_CDC_IN,
+                 "Two IN endpoints share an address");
+
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
@@ -128,6 +161,7 @@ enum {
   STRID_SERIAL,
   STRID_KB,
   STRID_CDC,
+  STRID_MOUSE,
 };
 
 // array of pointer to string descriptors
@@ -136,9 +170,10 @@ char const* string_desc_arr [] =
   (const char[]) { 0x09, 0x04 }, // 0: is supported language is English (0x0409)
   "beulard",                     // 1: Manufacturer
   "lard61",                      // 2: Product
-  NULL,                          // 3: Serials, should use chip ID
+  "0123456789ABCDEF",            // 3: Serials, should use chip ID
   "lard61 keyboard",             // 4: Keyboard HID
   "lard61 CDC",                  // 5: CDC interface
+  "lard61 mouse keys",           // 6: Mouse HID
 };
 
 static uint16_t _desc_str[32 + 1];
@@ -155,11 +190,6 @@ uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
       chr_count = 1;
       break;
 
-    case STRID_SERIAL:
-      memcpy(&_desc_str[1], "0123456789ABCDEF", 16);
-      chr_count = 16;
-      break;
-
     default:
       // Note: the 0xEE index string is a Microsoft OS 1.0 Descriptors.
       // https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors